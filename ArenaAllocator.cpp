@@ -0,0 +1,206 @@
+#include "ArenaAllocator.h"
+
+#include "Box2D/Common/b2Settings.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstdint>
+
+// every allocation is prefixed by a header so that b2Free can route
+// a pointer back to its owner whatever arena is current at that time
+struct alignas(16) ArenaAllocator::Header
+{
+    ArenaAllocator* arena;
+    Header* prev;
+    Header* next;
+    size_t size;
+    bool on_heap;
+};
+
+thread_local ArenaAllocator* current_arena = nullptr;
+
+ArenaAllocator::ArenaAllocator(const bool enabled, const size_t chunk_size_, const size_t max_arena_size_)
+    : chunk_size(chunk_size_), max_arena_size(max_arena_size_)
+{
+    static_assert(sizeof(Header) % 16 == 0, "header breaks alignment");
+    size_t block_size;
+    free_lists.resize(sizeClass(max_arena_size, block_size) + 1, nullptr);
+    assert(block_size <= chunk_size);
+    install();
+    current_arena = enabled ? this : nullptr;
+}
+
+ArenaAllocator::~ArenaAllocator()
+{
+    if (current_arena == this)
+        current_arena = nullptr;
+
+    // arena memory goes away with the chunks, only heap blocks need an explicit release
+    while (heap_list)
+    {
+        auto next = heap_list->next;
+        std::free(heap_list);
+        heap_list = next;
+    }
+}
+
+void ArenaAllocator::install()
+{
+    static bool installed = false;
+    if (installed)
+        return;
+
+    const auto alloc_callback = [](int32 size, void*) -> void* {
+        return allocateFrom(current_arena, size);
+    };
+    const auto free_callback = [](void* ptr, void*) -> void {
+        auto header_ = header(ptr);
+        if (header_->arena)
+        {
+            header_->arena->free(ptr);
+            return;
+        }
+        assert(header_->on_heap);
+        std::free(header_);
+    };
+
+    b2SetAllocFreeCallbacks(alloc_callback, free_callback, nullptr);
+    installed = true;
+}
+
+ArenaAllocator* ArenaAllocator::getCurrent()
+{
+    return current_arena;
+}
+
+void ArenaAllocator::setCurrent(ArenaAllocator* arena)
+{
+    current_arena = arena;
+}
+
+ArenaAllocator::Scope::Scope(ArenaAllocator* arena)
+    : previous(current_arena)
+{
+    current_arena = arena;
+}
+
+ArenaAllocator::Scope::~Scope()
+{
+    current_arena = previous;
+}
+
+ArenaAllocator::Header* ArenaAllocator::header(void* ptr)
+{
+    assert(ptr);
+    return reinterpret_cast<Header*>(ptr) - 1;
+}
+
+void* ArenaAllocator::allocateFrom(ArenaAllocator* arena, const size_t size)
+{
+    if (arena)
+        return arena->allocate(size);
+
+    auto header_ = static_cast<Header*>(std::malloc(sizeof(Header) + size));
+    assert(header_);
+    *header_ = { nullptr, nullptr, nullptr, size, true };
+    return header_ + 1;
+}
+
+// blocks up to 1KiB, header included, are rounded to 16 bytes, larger ones to a power of two
+// so that the varying stack allocator overflows of successive steps share a few classes
+size_t ArenaAllocator::sizeClass(const size_t size, size_t& block_size)
+{
+    constexpr size_t small_block_size = 1024;
+    block_size = (sizeof(Header) + size + 15) & ~static_cast<size_t>(15);
+    if (block_size <= small_block_size)
+        return block_size / 16;
+
+    size_t size_class = small_block_size / 16;
+    size_t rounded = small_block_size;
+    while (rounded < block_size)
+    {
+        rounded *= 2;
+        size_class++;
+    }
+    block_size = rounded;
+    return size_class;
+}
+
+void* ArenaAllocator::allocate(const size_t size)
+{
+    stats.alloc_count++;
+
+    if (size > max_arena_size)
+    {
+        auto header_ = static_cast<Header*>(std::malloc(sizeof(Header) + size));
+        assert(header_);
+        *header_ = { this, nullptr, heap_list, size, true };
+        if (heap_list)
+            heap_list->prev = header_;
+        heap_list = header_;
+
+        stats.heap_alloc_count++;
+        stats.heap_bytes += size;
+        stats.heap_live_bytes += size;
+        return header_ + 1;
+    }
+
+    size_t block_size;
+    const auto size_class = sizeClass(size, block_size);
+    assert(size_class < free_lists.size());
+
+    stats.arena_bytes += size;
+
+    auto& free_list = free_lists[size_class];
+    if (free_list)
+    {
+        auto header_ = free_list;
+        free_list = header_->next;
+        *header_ = { this, nullptr, nullptr, size, false };
+        stats.reuse_count++;
+        return header_ + 1;
+    }
+
+    if (chunks.empty() || chunk_offset + block_size > chunk_size)
+    {
+        chunks.emplace_back(new char[chunk_size]);
+        assert(reinterpret_cast<std::uintptr_t>(chunks.back().get()) % 16 == 0);
+        chunk_offset = 0;
+        stats.chunk_bytes += chunk_size;
+    }
+
+    auto header_ = reinterpret_cast<Header*>(chunks.back().get() + chunk_offset);
+    *header_ = { this, nullptr, nullptr, size, false };
+    chunk_offset += block_size;
+
+    return header_ + 1;
+}
+
+void ArenaAllocator::free(void* ptr)
+{
+    auto header_ = header(ptr);
+    assert(header_->arena == this);
+
+    stats.free_count++;
+
+    if (!header_->on_heap)
+    {
+        size_t block_size;
+        auto& free_list = free_lists[sizeClass(header_->size, block_size)];
+        header_->next = free_list;
+        free_list = header_;
+        return;
+    }
+
+    if (header_->prev) header_->prev->next = header_->next;
+    else heap_list = header_->next;
+    if (header_->next) header_->next->prev = header_->prev;
+
+    stats.heap_live_bytes -= header_->size;
+    std::free(header_);
+}
+
+const ArenaAllocator::Stats& ArenaAllocator::getStats() const
+{
+    return stats;
+}
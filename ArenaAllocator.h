@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+
+// Routes b2Alloc / b2Free to the current arena of the calling thread,
+// the last enabled arena constructed on a thread becomes its current arena,
+// constructing a disabled arena routes that thread back to the heap.
+// Small allocations (b2BlockAllocator chunks, shapes, tree nodes, stack allocator
+// overflows...) are bumped out of large chunks, freed blocks go to a free list of
+// their size class and are handed out again, so chunks only grow with the peak
+// live size. Releasing the arena drops everything at once. Larger allocations
+// (particle buffers) go to the heap so that they can still be trimmed, they are
+// tracked and released with the arena.
+class ArenaAllocator
+{
+    public:
+        struct Stats
+        {
+            size_t alloc_count = 0;
+            size_t free_count = 0;
+            size_t arena_bytes = 0;
+            size_t reuse_count = 0; // arena allocations served by a free list
+            size_t chunk_bytes = 0;
+            size_t heap_alloc_count = 0;
+            size_t heap_bytes = 0;
+            size_t heap_live_bytes = 0;
+        };
+
+        ArenaAllocator(const bool enabled = true, const size_t chunk_size = 1 << 20, const size_t max_arena_size = 1 << 16);
+        ~ArenaAllocator();
+        ArenaAllocator(const ArenaAllocator&) = delete;
+        ArenaAllocator& operator=(const ArenaAllocator&) = delete;
+
+        void* allocate(const size_t size);
+        void free(void* ptr);
+
+        const Stats& getStats() const;
+
+        static void install();
+        static ArenaAllocator* getCurrent();
+        static void setCurrent(ArenaAllocator* arena);
+
+        // makes arena current on the calling thread and restores the previous one when it ends,
+        // so arenas constructed by a task that outlives them never stay current on its worker
+        class Scope
+        {
+            public:
+                Scope(ArenaAllocator* arena = nullptr);
+                ~Scope();
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+
+            protected:
+                ArenaAllocator* previous;
+        };
+
+    protected:
+        struct Header;
+        static Header* header(void* ptr);
+        static void* allocateFrom(ArenaAllocator* arena, const size_t size);
+        static size_t sizeClass(const size_t size, size_t& block_size);
+
+        const size_t chunk_size;
+        const size_t max_arena_size;
+        std::vector<std::unique_ptr<char[]>> chunks;
+        size_t chunk_offset = 0;
+        std::vector<Header*> free_lists; // by size class, linked through next
+        Header* heap_list = nullptr;
+        Stats stats;
+};
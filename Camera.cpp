@@ -26,10 +26,15 @@ Camera::preparePainter(const RasterWindowOpenGL& view, QPainter& painter) const
 
 QMatrix4x4
 Camera::cameraMatrix(const RasterWindowOpenGL& view) const
+{
+    return cameraMatrix(view.width() / static_cast<float>(view.height()));
+}
+
+QMatrix4x4
+Camera::cameraMatrix(const float aspect_ratio) const
 {
     using std::get;
 
-    const auto aspect_ratio = view.width() / static_cast<float>(view.height());
     const auto hh = screen_height / 2;
 
     QMatrix4x4 perspective_matrix;
@@ -17,5 +17,6 @@ struct Camera
     void paintUI();
     void preparePainter(const RasterWindowOpenGL& view, QPainter& painter) const;
     QMatrix4x4 cameraMatrix(const RasterWindowOpenGL& view) const;
+    QMatrix4x4 cameraMatrix(const float aspect_ratio) const; // width over height, for offscreen surfaces
 };
 
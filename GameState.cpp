@@ -3,15 +3,28 @@
 #include "Box2D/Dynamics/b2Fixture.h"
 #include "Box2D/Collision/Shapes/b2PolygonShape.h"
 #include "Box2D/Collision/Shapes/b2CircleShape.h"
+#include "Box2D/Collision/Shapes/b2ChainShape.h"
 #include "Box2D/Dynamics/Contacts/b2Contact.h"
 #include "Box2D/Particle/b2ParticleGroup.h"
+#include "Box2D/Collision/b2DynamicTree.h"
 
 #include <iostream>
 #include <iomanip>
 #include <bitset>
-
-#include "extract_polygons.h"
-#include "decompose_polygons.h"
+#include <limits>
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+#include <unordered_map>
+#include <istream>
+#include <ostream>
+
+#include "ground_polygons.h"
+#include "carve_polygons.h"
+#include "merge_polygons.h"
+#include "memory_usage.h"
+#include "ThreadPool.h"
 
 constexpr uint16 ground_category = 1 << 0;
 constexpr uint16 object_category = 1 << 1;
@@ -20,8 +33,195 @@ const float default_density = 0.2;
 const float default_friction = 0.1;
 const float default_restitution = 0.5;
 
+bool GameState::use_arena = true;
+
+using ParticleBatches = std::vector<ParticleBatch>;
+
+// groups oldest first to preserve list order, then ungrouped particles,
+// each batch sorted by grid cell when cell_size is positive
+static ParticleBatches snapshot_particles(b2ParticleSystem& system, const float32 cell_size)
+{
+    const auto positions = system.GetPositionBuffer();
+    const auto velocities = system.GetVelocityBuffer();
+    const auto colors = system.GetColorBuffer();
+    const auto flags = system.GetFlagsBuffer();
+    const auto groups = system.GetGroupBuffer();
+    const bool has_lifetimes = system.GetExpirationTimeBuffer() != nullptr;
+
+    const auto cell_key = [&positions, &cell_size](const int32 kk) -> std::tuple<int, int>
+    {
+        const auto& position = positions[kk];
+        return std::make_tuple(static_cast<int>(std::floor(position.y / cell_size)), static_cast<int>(std::floor(position.x / cell_size)));
+    };
+
+    const auto make_batch = [&](std::vector<int32>& indices, ParticleBatch& batch) -> void
+    {
+        if (cell_size > 0)
+            std::sort(std::begin(indices), std::end(indices), [&cell_key](const int32 aa, const int32 bb) -> bool {
+                return cell_key(aa) < cell_key(bb);
+            });
+
+        batch.positions.reserve(indices.size());
+        batch.velocities.reserve(indices.size());
+        batch.colors.reserve(indices.size());
+        batch.flags.reserve(indices.size());
+        if (has_lifetimes)
+            batch.lifetimes.reserve(indices.size());
+        for (const auto& kk : indices)
+        {
+            batch.positions.emplace_back(positions[kk]);
+            batch.velocities.emplace_back(velocities[kk]);
+            batch.colors.emplace_back(colors[kk]);
+            batch.flags.emplace_back(flags[kk]);
+            if (has_lifetimes)
+                batch.lifetimes.emplace_back(system.GetParticleLifetime(kk));
+        }
+    };
+
+    ParticleBatches batches;
+
+    { // groups
+        std::vector<b2ParticleGroup*> groups_;
+        for (auto* group = system.GetParticleGroupList(); group; group = group->GetNext())
+            groups_.emplace_back(group);
+
+        for (auto iter=std::crbegin(groups_), iter_end=std::crend(groups_); iter!=iter_end; iter++)
+        {
+            const auto& group = **iter;
+
+            std::vector<int32> indices;
+            for (auto kk=group.GetBufferIndex(), kk_max=kk + group.GetParticleCount(); kk<kk_max; kk++)
+                if (!(flags[kk] & b2_zombieParticle))
+                    indices.emplace_back(kk);
+            if (indices.empty())
+                continue;
+
+            ParticleBatch batch;
+            batch.group_flags = group.GetGroupFlags() & ~b2_particleGroupInternalMask;
+            batch.linear_velocity = group.GetLinearVelocity();
+            batch.angular_velocity = group.GetAngularVelocity();
+            make_batch(indices, batch);
+            batches.emplace_back(std::move(batch));
+        }
+    }
+
+    { // ungrouped particles
+        std::vector<int32> indices;
+        for (auto kk=0, kk_max=system.GetParticleCount(); kk<kk_max; kk++)
+            if (!groups[kk] && !(flags[kk] & b2_zombieParticle))
+                indices.emplace_back(kk);
+
+        if (!indices.empty())
+        {
+            ParticleBatch batch;
+            batch.grouped = false;
+            make_batch(indices, batch);
+            batches.emplace_back(std::move(batch));
+        }
+    }
+
+    return batches;
+}
+
+// particles liquidfun lays on its lattice inside the shapes, the border rows make it vary a little
+static int lattice_count(const b2ParticleSystem& system, const b2Shape* const* shapes, const int32 shape_count)
+{
+    const auto stride = b2_particleStride * 2 * system.GetRadius();
+    float32 area = 0;
+    for (auto kk=0; kk<shape_count; kk++)
+    {
+        b2MassData mass;
+        shapes[kk]->ComputeMass(&mass, 1);
+        area += mass.mass;
+    }
+    return static_cast<int>(std::ceil(area / (stride * stride)));
+}
+
+// once the system holds max_count particles, CreateParticle recycles the oldest one and compacts the buffers,
+// which would corrupt a group being built. room is made beforehand by destroying the oldest live particles,
+// they leave the buffers on the next step only so the cap is lifted by the group size until then.
+// recycling is off while the group is built, a group larger than count is truncated instead
+static b2ParticleGroup* create_group(b2ParticleSystem& system, const b2ParticleGroupDef& def, const int count, const int max_count)
+{
+    assert(max_count > 0);
+    const auto particle_count = system.GetParticleCount();
+    const auto flags = system.GetFlagsBuffer();
+    int zombie_count = 0;
+    for (auto kk=0; kk<particle_count; kk++)
+        if (flags[kk] & b2_zombieParticle)
+            zombie_count++;
+
+    const auto live_count = particle_count - zombie_count;
+    const auto excess = std::min(live_count, live_count + count - max_count);
+    for (auto kk=0; kk<excess; kk++)
+        system.DestroyOldestParticle(zombie_count + kk, false);
+    if (particle_count + count > system.GetMaxParticleCount())
+        system.SetMaxParticleCount(particle_count + count);
+
+    system.SetDestructionByAge(false);
+    const auto group = system.CreateParticleGroup(def);
+    system.SetDestructionByAge(true);
+    return group;
+}
+
+static void restore_particles(b2ParticleSystem& system, const ParticleBatches& batches, const int max_count)
+{
+    const auto copy_particle = [&system](const ParticleBatch& batch, const size_t kk, const int32 ll) -> void
+    {
+        system.GetVelocityBuffer()[ll] = batch.velocities[kk];
+        system.GetColorBuffer()[ll] = batch.colors[kk];
+        system.SetParticleFlags(ll, batch.flags[kk]);
+        if (batch.lifetimes.empty())
+            return;
+        const auto lifetime = batch.lifetimes[kk];
+        if (lifetime > 0)
+            system.SetParticleLifetime(ll, lifetime);
+    };
+
+    for (const auto& batch : batches)
+    {
+        assert(batch.velocities.size() == batch.positions.size());
+        assert(batch.colors.size() == batch.positions.size());
+        assert(batch.flags.size() == batch.positions.size());
+        assert(batch.lifetimes.empty() || batch.lifetimes.size() == batch.positions.size());
+
+        if (batch.grouped)
+        {
+            b2ParticleGroupDef group_def;
+            group_def.groupFlags = batch.group_flags;
+            group_def.linearVelocity = batch.linear_velocity;
+            group_def.angularVelocity = batch.angular_velocity;
+            group_def.particleCount = batch.positions.size();
+            group_def.positionData = batch.positions.data();
+            const auto group = create_group(system, group_def, batch.positions.size(), max_count);
+            assert(group);
+            assert(group->GetParticleCount() == static_cast<int32>(batch.positions.size()));
+
+            auto ll = group->GetBufferIndex();
+            for (size_t kk=0, kk_max=batch.positions.size(); kk<kk_max; kk++)
+                copy_particle(batch, kk, ll++);
+            continue;
+        }
+
+        for (size_t kk=0, kk_max=batch.positions.size(); kk<kk_max; kk++)
+        {
+            b2ParticleDef def;
+            def.flags = batch.flags[kk];
+            def.position = batch.positions[kk];
+            def.velocity = batch.velocities[kk];
+            def.color = batch.colors[kk];
+            const auto ll = system.CreateParticle(def);
+            if (ll != b2_invalidParticleIndex)
+                copy_particle(batch, kk, ll);
+        }
+    }
+}
+
 GameState::GameState()
 {
+    world_bounds.lowerBound = { -1e4, -1e4 };
+    world_bounds.upperBound = { 1e4, 1e4 };
+
     resetShip({ 0, 0 });
     resetBall({ 0, 0 });
     resetParticleSystem();
@@ -44,68 +244,986 @@ GameState::GameState()
     world.SetContactListener(this);
 }
 
-void GameState::resetGround(const std::string& map_filename)
+static b2Fixture* create_ground_fixture(b2Body& body, const b2Shape& shape)
 {
-    using std::cout;
-    using std::endl;
+    b2FixtureDef fixture;
+    fixture.shape = &shape;
+    fixture.density = 0;
+    fixture.friction = .9;
+    fixture.filter.categoryBits = ground_category;
+    fixture.filter.maskBits = object_category | door_category;
+
+    return body.CreateFixture(&fixture);
+}
 
+void GameState::resetGround(const std::string& map_filename, const polygons::GroundOptions& options)
+{
+    resetGround(polygons::build_ground(map_filename, options));
+}
+
+static b2Vec2 vertex_average(const b2Vec2* points, const size_t count)
+{
+    b2Vec2 sum = { 0, 0 };
+    for (size_t kk=0; kk<count; kk++)
+        sum += points[kk];
+    return (1.f / count) * sum;
+}
+
+void GameState::resetGround(const polygons::Ground& ground_, const float chunk_size_)
+{
     b2BodyDef def;
     def.type = b2_staticBody;
     def.position.Set(0, 0);
     auto body = world.CreateBody(&def);
+    ground = UniqueBody(body, [this](b2Body* body) -> void { world.DestroyBody(body); });
+
+    ground_pieces.clear();
+    ground_loops.clear();
+    piece_fixtures.clear();
+    loop_fixtures.clear();
+
+    world_bounds.lowerBound = ground_.lower;
+    world_bounds.upperBound = ground_.upper;
+
+    // every chunk starts unloaded, pieces only get fixtures when streamed in
+    resetChunks(chunk_size_);
+    updateGround(ground_);
+}
+
+std::tuple<size_t, size_t> GameState::updateGround(const polygons::Ground& ground_)
+{
+    using std::cout;
+    using std::endl;
+
+    assert(ground);
+    const auto body = ground.get();
+
+    const auto push_fixture = [&body](const b2Shape& shape) -> b2Fixture*
+    {
+        return create_ground_fixture(*body, shape);
+    };
 
-    const auto push_fixture = [&body](const polygons::Poly& poly)
+    // fixtures of polygons found unchanged in the previous ground are kept, the others are replaced
+    const auto swap_fixtures = [&body](const polygons::PolySoup& previous, std::vector<b2Fixture*>& fixtures, const polygons::PolySoup& polys, const std::function<b2Fixture*(size_t)>& create) -> size_t
     {
+        assert(fixtures.size() == previous.size());
+        const polygons::PolyHasher hasher;
+        std::unordered_multimap<size_t, size_t> previous_indices;
+        for (size_t kk=0; kk<previous.size(); kk++)
+            previous_indices.emplace(hasher(previous.begin(kk), previous.count(kk)), kk);
+
+        std::vector<b2Fixture*> fixtures_(polys.size(), nullptr);
+        size_t kept_count = 0;
+        for (size_t kk=0; kk<polys.size(); kk++)
+        {
+            const auto range = previous_indices.equal_range(hasher(polys.begin(kk), polys.count(kk)));
+            for (auto iter=range.first; iter!=range.second; iter++)
+            {
+                auto& fixture = fixtures[iter->second];
+                if (!fixture || previous.count(iter->second) != polys.count(kk) || !std::equal(polys.begin(kk), polys.end(kk), previous.begin(iter->second)))
+                    continue;
+                std::swap(fixtures_[kk], fixture);
+                kept_count++;
+                break;
+            }
+        }
+
+        for (const auto& fixture : fixtures)
+            if (fixture)
+                body->DestroyFixture(fixture);
+
+        for (size_t kk=0; kk<polys.size(); kk++)
+            if (!fixtures_[kk])
+                fixtures_[kk] = create(kk);
+
+        fixtures = std::move(fixtures_);
+        return kept_count;
+    };
+
+    const auto& pieces = ground_.pieces;
+    auto kept_count = swap_fixtures(ground_pieces, piece_fixtures, pieces, [this, &pieces, &push_fixture](const size_t kk) -> b2Fixture* {
+        if (!chunks.empty() && !chunks[chunkIndex(vertex_average(pieces.begin(kk), pieces.count(kk)))].loaded)
+            return nullptr;
         b2PolygonShape shape;
-        shape.Set(poly.data(), poly.size());
+        shape.Set(pieces.begin(kk), pieces.count(kk));
+        return push_fixture(shape);
+    });
+    ground_pieces = pieces;
+    for (auto& chunk : chunks) // loads in flight prepared pieces of the previous ground
+        std::fill(std::begin(chunk.pending_pieces), std::end(chunk.pending_pieces), std::numeric_limits<uint32_t>::max());
+    piece_carved.assign(ground_pieces.size(), false);
+    carved_piece_count = 0;
+    for (size_t kk=0; kk<piece_fixtures.size(); kk++)
+        if (piece_fixtures[kk])
+            piece_fixtures[kk]->SetUserData(reinterpret_cast<void*>(static_cast<uintptr_t>(kk + 1)));
+    binChunkPieces();
+
+    const auto& outlines = ground_.outlines;
+    auto loops = ground_.use_chains ? outlines : polygons::PolySoup();
+    kept_count += swap_fixtures(ground_loops, loop_fixtures, loops, [&loops, &push_fixture](const size_t kk) -> b2Fixture* {
+        // chain loops reject consecutive vertices closer than the linear slop
+        polygons::Poly loop;
+        for (auto point=loops.begin(kk); point!=loops.end(kk); point++)
+            if (loop.empty() || b2DistanceSquared(loop.back(), *point) > 4 * b2_linearSlop * b2_linearSlop)
+                loop.emplace_back(*point);
+        while (loop.size() > 1 && b2DistanceSquared(loop.back(), loop.front()) <= 4 * b2_linearSlop * b2_linearSlop)
+            loop.pop_back();
+        if (loop.size() < 3)
+            return nullptr;
+
+        b2ChainShape shape;
+        shape.CreateLoop(loop.data(), loop.size());
+        return push_fixture(shape);
+    });
+    ground_loops = std::move(loops);
+
+    ground_segments.clear();
+    ground_segments.reserve(outlines.vertices.size());
+    for (size_t kk=0; kk<outlines.size(); kk++)
+    {
+        const auto outline = outlines.begin(kk);
+        for (size_t ll=0, ll_max=outlines.count(kk); ll<ll_max; ll++)
+            ground_segments.emplace_back(outline[ll], outline[(ll + 1) % ll_max]);
+    }
 
-        b2FixtureDef fixture;
-        fixture.shape = &shape;
-        fixture.density = 0;
-        fixture.friction = .9;
-        fixture.filter.categoryBits = ground_category;
-        fixture.filter.maskBits = object_category | door_category;
+    water_regions = ground_.water_regions;
+    crate_regions = ground_.crate_regions;
 
-        body->CreateFixture(&fixture);
+    const auto is_set = [](const b2Fixture* fixture) -> bool { return fixture; };
+    const size_t fixture_count = std::count_if(std::cbegin(piece_fixtures), std::cend(piece_fixtures), is_set) + std::count_if(std::cbegin(loop_fixtures), std::cend(loop_fixtures), is_set);
+    rebuildGroundGrid();
+    cout << "** updateGround " << ground_pieces.size() << " pieces " << (ground_.use_chains ? "chains " : "");
+    cout << kept_count << " kept " << fixture_count - kept_count << " created ";
+    cout << ground_segments.size() << " segments " << ground_grid.getItemCount() << " sensor entries" << endl;
 
+    return std::make_tuple(kept_count, fixture_count - kept_count);
+}
+
+std::tuple<size_t, size_t> GameState::carveGround(const polygons::Poly& carve)
+{
+    using std::cout;
+    using std::endl;
+    using polygons::Segment;
+
+    assert(ground);
+    assert(!world.IsLocked());
+    assert(carve.size() >= 3);
+
+    b2AABB aabb;
+    aabb.lowerBound = carve.front();
+    aabb.upperBound = carve.front();
+    for (const auto& point : carve)
+    {
+        aabb.lowerBound = b2Min(aabb.lowerBound, point);
+        aabb.upperBound = b2Max(aabb.upperBound, point);
+    }
+
+    // the broadphase already indexes every ground piece, fixture user data is the piece index plus one
+    struct Query : public b2QueryCallback
+    {
+        const b2Body* ground = nullptr;
+        std::vector<b2Fixture*> fixtures;
+
+        bool ReportFixture(b2Fixture* fixture) override
+        {
+            const auto body = fixture->GetBody();
+            if (body == ground && fixture->GetUserData())
+                fixtures.emplace_back(fixture);
+            if (body != ground && body->GetType() == b2_dynamicBody)
+                body->SetAwake(true); // bodies resting on removed pieces would hang in the air
+            return true;
+        }
+
+        bool ShouldQueryParticleSystem(const b2ParticleSystem* system) override
+        {
+            return false;
+        }
     };
 
-    cout << "** svg loading" << endl;
-    cout << "filename " << std::quoted(map_filename) << endl;
+    Query query;
+    query.ground = ground.get();
+    world.QueryAABB(&query, aabb);
+
+    polygons::PolySoup carved;
+    std::vector<Segment> walls;
+    size_t removed_count = 0;
+    for (const auto& fixture : query.fixtures)
+    {
+        const auto index = reinterpret_cast<uintptr_t>(fixture->GetUserData()) - 1;
+        assert(index < ground_pieces.size());
+        assert(piece_fixtures[index] == fixture);
+        const auto piece = ground_pieces.begin(index);
+        const auto count = ground_pieces.count(index);
+        if (polygons::convex_disjoint(piece, count, carve.data(), carve.size()))
+            continue;
+
+        carved.append(polygons::subtract_convex(piece, count, carve.data(), carve.size(), b2_maxPolygonVertices, b2_linearSlop, carve_min_area));
+
+        // carve boundary inside the solid becomes the crater wall
+        for (size_t kk=0, kk_max=carve.size(); kk<kk_max; kk++)
+        {
+            Segment wall;
+            if (polygons::clip_segment(Segment { carve[kk], carve[(kk + 1) % kk_max] }, piece, count, wall))
+                walls.emplace_back(wall);
+        }
 
-    const auto polys_to_colors = polygons::extract(map_filename);
-    const polygons::Color foreground_color { 0, 1, 0, 1};
+        if (!chunks.empty())
+        {
+            auto& chunk_pieces = chunks[chunkIndex(vertex_average(piece, count))].pieces;
+            chunk_pieces.erase(std::find(std::begin(chunk_pieces), std::end(chunk_pieces), index));
+        }
 
-    const auto foreground_transform = [](const polygons::Poly& poly) -> polygons::Poly
+        ground->DestroyFixture(fixture);
+        piece_fixtures[index] = nullptr;
+        piece_carved[index] = true;
+        removed_count++;
+    }
+
+    if (!removed_count)
+        return std::make_tuple(0, 0);
+
+    // pieces cut from neighbouring pieces share edges and merge back
+    const auto merged = polygons::merge_convex(carved, b2_maxPolygonVertices, carve_min_area);
+    for (size_t kk=0; kk<merged.size(); kk++)
     {
-        polygons::Poly poly_;
-        poly_.reserve(poly.size());
-        for (const auto& point : poly)
+        const auto index = ground_pieces.size();
+        ground_pieces.push(merged.begin(kk), merged.count(kk));
+        piece_carved.push_back(false);
+        piece_fixtures.emplace_back(nullptr);
+
+        if (!chunks.empty())
+        { // a piece may end up binned into an unloaded neighbour chunk
+            auto& chunk = chunks[chunkIndex(vertex_average(merged.begin(kk), merged.count(kk)))];
+            chunk.pieces.emplace_back(index);
+            if (!chunk.loaded)
+                continue;
+        }
+
+        b2PolygonShape shape;
+        shape.Set(merged.begin(kk), merged.count(kk));
+        const auto fixture = create_ground_fixture(*ground, shape);
+        fixture->SetUserData(reinterpret_cast<void*>(static_cast<uintptr_t>(index + 1)));
+        piece_fixtures.back() = fixture;
+    }
+    carved_piece_count += removed_count;
+
+    if (2 * carved_piece_count > ground_pieces.size())
+    { // carved away pieces stay in the soup until they outnumber the live ones
+        polygons::PolySoup pieces;
+        std::vector<b2Fixture*> fixtures;
+        std::vector<uint32_t> indices(ground_pieces.size(), std::numeric_limits<uint32_t>::max());
+        for (size_t kk=0; kk<ground_pieces.size(); kk++)
         {
-            const b2Vec2 point_ { point.x - .5f , .25f - point.y };
-            poly_.emplace_back(600 * point_);
+            if (piece_carved[kk])
+                continue;
+            const auto fixture = piece_fixtures[kk];
+            indices[kk] = pieces.size();
+            if (fixture)
+                fixture->SetUserData(reinterpret_cast<void*>(static_cast<uintptr_t>(pieces.size() + 1)));
+            pieces.push(ground_pieces.begin(kk), ground_pieces.count(kk), ground_pieces.colors[kk]);
+            fixtures.emplace_back(fixture);
         }
-        return poly_;
+        ground_pieces = std::move(pieces);
+        piece_fixtures = std::move(fixtures);
+        piece_carved.assign(ground_pieces.size(), false);
+        carved_piece_count = 0;
+
+        for (auto& chunk : chunks)
+            for (auto& index : chunk.pending_pieces)
+                index = index < indices.size() ? indices[index] : index;
+        binChunkPieces();
+    }
+
+    // segments are shortened in place so that the grid cells binning them stay valid,
+    // segments appended since the last grid build are not binned yet
+    std::vector<uint32_t> items;
+    ground_grid.query(aabb, [&items](const uint32_t item) -> void { items.emplace_back(item); });
+    for (auto kk=ground_grid_count; kk<ground_segments.size(); kk++)
+        items.emplace_back(kk);
+    std::sort(std::begin(items), std::end(items));
+    items.erase(std::unique(std::begin(items), std::end(items)), std::end(items));
+
+    std::vector<Segment> parts;
+    for (const auto& item : items)
+    {
+        parts.clear();
+        auto& segment = ground_segments[item];
+        polygons::subtract_segment(segment, carve.data(), carve.size(), parts);
+        if (parts.size() == 1 && parts.front() == segment)
+            continue;
+        segment = parts.empty() ? Segment { std::get<0>(segment), std::get<0>(segment) } : parts.front();
+        if (parts.size() > 1)
+            walls.emplace_back(parts.back());
+    }
+    ground_segments.insert(std::end(ground_segments), std::begin(walls), std::end(walls));
+
+    cout << "** carveGround " << removed_count << " removed " << merged.size() << " created " << walls.size() << " segments" << endl;
+
+    return std::make_tuple(removed_count, merged.size());
+}
+
+void GameState::rebuildGroundGrid()
+{
+    // segments emptied by carving are dropped
+    const auto end = std::remove_if(std::begin(ground_segments), std::end(ground_segments), [](const sensors::Segment& segment) -> bool {
+        return std::get<0>(segment) == std::get<1>(segment);
+    });
+    ground_segments.erase(end, std::end(ground_segments));
+
+    ground_grid = sensors::build_segment_grid(ground_segments, world_bounds, 8);
+    ground_grid_count = ground_segments.size();
+}
+
+void GameState::resetChunks(const float chunk_size_)
+{
+    chunks.clear();
+    chunk_size = chunk_size_;
+    chunk_lower = world_bounds.lowerBound;
+    chunk_columns = 0;
+    chunk_rows = 0;
+    if (chunk_size <= 0)
+        return;
+
+    const auto extents = world_bounds.upperBound - world_bounds.lowerBound;
+    chunk_columns = std::max(1, static_cast<int>(std::ceil(extents.x / chunk_size)));
+    chunk_rows = std::max(1, static_cast<int>(std::ceil(extents.y / chunk_size)));
+    chunks.resize(chunk_columns * chunk_rows);
+    for (auto& chunk : chunks)
+        chunk.particles.grouped = false;
+
+    binChunkPieces();
+}
+
+size_t GameState::chunkIndex(const b2Vec2& point) const
+{
+    assert(!chunks.empty());
+    const auto xx = static_cast<int>(std::floor((point.x - chunk_lower.x) / chunk_size));
+    const auto yy = static_cast<int>(std::floor((point.y - chunk_lower.y) / chunk_size));
+    return std::min(std::max(yy, 0), chunk_rows - 1) * chunk_columns + std::min(std::max(xx, 0), chunk_columns - 1);
+}
+
+b2AABB GameState::chunkBounds(const size_t index) const
+{
+    b2AABB bounds;
+    bounds.lowerBound = chunk_lower + chunk_size * b2Vec2 { static_cast<float>(index % chunk_columns), static_cast<float>(index / chunk_columns) };
+    bounds.upperBound = bounds.lowerBound + b2Vec2 { chunk_size, chunk_size };
+    return bounds;
+}
+
+void GameState::binChunkPieces()
+{
+    for (auto& chunk : chunks)
+        chunk.pieces.clear();
+    if (chunks.empty())
+        return;
+
+    for (size_t kk=0; kk<ground_pieces.size(); kk++)
+        if (!piece_carved[kk])
+            chunks[chunkIndex(vertex_average(ground_pieces.begin(kk), ground_pieces.count(kk)))].pieces.emplace_back(kk);
+}
+
+size_t GameState::streamChunks(const b2Vec2& focus, const float radius, const bool wait)
+{
+    if (chunks.empty())
+        return 0;
+
+    size_t loaded_count = 0;
+    for (size_t kk=0; kk<chunks.size(); kk++)
+    {
+        auto& chunk = chunks[kk];
+        if (chunk.pending_shapes.valid() && chunk.pending_shapes.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            finishChunkLoad(kk);
+
+        const auto bounds = chunkBounds(kk);
+        const auto delta = b2Max(b2Max(bounds.lowerBound - focus, focus - bounds.upperBound), b2Vec2 { 0, 0 });
+        const auto distance = delta.Length();
+        if (!chunk.loaded && !chunk.pending_shapes.valid() && distance < radius)
+            startChunkLoad(kk);
+        if (wait && chunk.pending_shapes.valid())
+            finishChunkLoad(kk);
+        if (chunk.loaded && distance > radius + chunk_size)
+            unloadChunk(kk);
+
+        loaded_count += chunk.loaded;
+    }
+
+    storeDormant();
+
+    return loaded_count;
+}
+
+void GameState::startChunkLoad(const size_t index)
+{
+    auto& chunk = chunks[index];
+    assert(!chunk.loaded);
+    assert(!chunk.pending_shapes.valid());
+
+    // the task works on a copy, carving may grow the soup meanwhile
+    polygons::PolySoup pieces;
+    chunk.pending_pieces.clear();
+    for (const auto& kk : chunk.pieces)
+    {
+        assert(!piece_fixtures[kk]);
+        chunk.pending_pieces.emplace_back(kk);
+        pieces.push(ground_pieces.begin(kk), ground_pieces.count(kk));
+    }
+
+    chunk.pending_shapes = ThreadPool::global().submit([pieces]() -> std::vector<b2PolygonShape> {
+        std::vector<b2PolygonShape> shapes(pieces.size());
+        for (size_t kk=0; kk<pieces.size(); kk++)
+            shapes[kk].Set(pieces.begin(kk), pieces.count(kk));
+        return shapes;
+    });
+}
+
+void GameState::finishChunkLoad(const size_t index)
+{
+    using std::get;
+
+    auto& chunk = chunks[index];
+    const auto shapes = chunk.pending_shapes.get();
+    assert(shapes.size() == chunk.pending_pieces.size());
+
+    const auto push_piece = [this](const size_t kk, const b2PolygonShape& shape) -> void
+    {
+        const auto fixture = create_ground_fixture(*ground, shape);
+        fixture->SetUserData(reinterpret_cast<void*>(static_cast<uintptr_t>(kk + 1)));
+        piece_fixtures[kk] = fixture;
     };
 
-    cout << "foreground";
-    cout.flush();
-    for (const auto& poly_color : std::get<1>(polys_to_colors))
+    for (size_t kk=0; kk<shapes.size(); kk++)
     {
-        if (!polygons::isForeground(poly_color.second))
+        const auto piece = chunk.pending_pieces[kk];
+        if (piece < ground_pieces.size() && !piece_carved[piece] && !piece_fixtures[piece])
+            push_piece(piece, shapes[kk]);
+    }
+    chunk.pending_pieces.clear();
+
+    for (const auto& kk : chunk.pieces)
+        if (!piece_fixtures[kk])
+        { // binned while loading
+            b2PolygonShape shape;
+            shape.Set(ground_pieces.begin(kk), ground_pieces.count(kk));
+            push_piece(kk, shape);
+        }
+
+    chunk.loaded = true;
+
+    if (system && !chunk.particles.positions.empty())
+        restore_particles(*system, { chunk.particles }, max_particle_count);
+    chunk.particles = ParticleBatch();
+    chunk.particles.grouped = false;
+
+    for (const auto& crate : chunk.crates)
+        addCrate(get<0>(crate), get<1>(crate), get<2>(crate), get<3>(crate));
+    chunk.crates.clear();
+}
+
+void GameState::unloadChunk(const size_t index)
+{
+    auto& chunk = chunks[index];
+    assert(chunk.loaded);
+
+    for (const auto& kk : chunk.pieces)
+    {
+        auto& fixture = piece_fixtures[kk];
+        if (!fixture)
             continue;
+        ground->DestroyFixture(fixture);
+        fixture = nullptr;
+    }
 
-        const auto subpolys = polygons::decompose(polygons::ensure_cw(poly_color.first), 1e-5);
+    chunk.loaded = false;
+}
 
-        cout << " " << subpolys.size();
-        cout.flush();
+void GameState::storeDormant()
+{
+    using std::get;
 
-        for (const auto& subpoly : subpolys)
-            push_fixture(foreground_transform(subpoly));
+    if (system)
+    { // particles
+        const auto positions = system->GetPositionBuffer();
+        const auto velocities = system->GetVelocityBuffer();
+        const auto colors = system->GetColorBuffer();
+        const auto flags = system->GetFlagsBuffer();
+        const bool has_lifetimes = system->GetExpirationTimeBuffer() != nullptr;
+        for (auto kk=0, kk_max=system->GetParticleCount(); kk<kk_max; kk++)
+        {
+            if (flags[kk] & b2_zombieParticle)
+                continue;
+            auto& chunk = chunks[chunkIndex(positions[kk])];
+            if (chunk.loaded || chunk.pending_shapes.valid())
+                continue;
+
+            auto& batch = chunk.particles;
+            batch.positions.emplace_back(positions[kk]);
+            batch.velocities.emplace_back(velocities[kk]);
+            batch.colors.emplace_back(colors[kk]);
+            batch.flags.emplace_back(flags[kk]);
+            if (has_lifetimes)
+                batch.lifetimes.emplace_back(system->GetParticleLifetime(kk));
+            system->DestroyParticle(kk);
+        }
     }
-    cout << endl;
 
-    ground = UniqueBody(body, [this](b2Body* body) -> void { world.DestroyBody(body); });
+    { // crates
+        const auto is_dormant = [this](const std::tuple<UniqueBody, int>& crate) -> bool
+        {
+            const auto& body = get<0>(crate);
+            auto& chunk = chunks[chunkIndex(body->GetPosition())];
+            if (chunk.loaded || chunk.pending_shapes.valid())
+                return false;
+            chunk.crates.emplace_back(body->GetPosition(), body->GetLinearVelocity(), body->GetAngle(), get<1>(crate));
+            return true;
+        };
+        crates.erase(std::remove_if(std::begin(crates), std::end(crates), is_dormant), std::end(crates));
+    }
+
+    // other bodies only stop, their joints and owners stay
+    for (auto body=world.GetBodyList(); body; body=body->GetNext())
+    {
+        if (body == ground.get())
+            continue;
+        const auto& chunk = chunks[chunkIndex(body->GetPosition())];
+        const auto active = chunk.loaded || chunk.pending_shapes.valid();
+        if (body->IsActive() != active)
+            body->SetActive(active);
+    }
+}
+
+void GameState::castRays(const sensors::Rays& rays, sensors::Hits& hits, const bool with_particles, const size_t thread_count) const
+{
+    using std::get;
+
+    hits.reset(rays);
+
+    // dynamic fixtures are binned once per batch
+    std::unordered_set<const b2Body*> crate_bodies;
+    for (const auto& crate : crates)
+        crate_bodies.emplace(get<0>(crate).get());
+
+    std::vector<std::tuple<const b2Fixture*, int32, sensors::Category>> objects;
+    sensors::Grid object_grid(world_bounds, 16);
+    for (auto body=world.GetBodyList(); body; body=body->GetNext())
+    {
+        if (body == ground.get())
+            continue;
+        for (auto fixture=body->GetFixtureList(); fixture; fixture=fixture->GetNext())
+        {
+            const auto category =
+                fixture->GetFilterData().categoryBits & door_category ? sensors::door :
+                crate_bodies.count(body) ? sensors::crate :
+                sensors::object;
+            for (auto child=0, child_max=fixture->GetShape()->GetChildCount(); child<child_max; child++)
+            {
+                object_grid.insert(objects.size(), fixture->GetAABB(child));
+                objects.emplace_back(fixture, child, category);
+            }
+        }
+    }
+    object_grid.finalize();
+
+    const bool cast_particles = with_particles && system && system->GetParticleCount();
+    const auto particle_radius = system ? system->GetRadius() : 0;
+    const auto particle_positions = system ? system->GetPositionBuffer() : nullptr;
+    const auto particle_grid = cast_particles ?
+        sensors::build_circle_grid(particle_positions, system->GetParticleCount(), particle_radius, world_bounds, 4 * particle_radius) :
+        sensors::Grid();
+
+    // each grid is traversed up to the closest hit found so far
+    sensors::parallel_for(rays.size(), thread_count, [&](const size_t begin, const size_t end) -> void {
+        for (auto kk=begin; kk<end; kk++)
+        {
+            const auto& origin = rays.origins[kk];
+            const auto& direction = rays.directions[kk];
+            auto& distance = hits.distances[kk];
+            auto& category = hits.categories[kk];
+
+            const auto ground_distance = ground_grid.traverse(origin, direction, distance, [this, &origin, &direction](const uint32_t item, const float best) -> float {
+                return sensors::raycast_segment(ground_segments[item], origin, direction, best);
+            });
+            if (ground_distance < distance)
+            {
+                distance = ground_distance;
+                category = sensors::ground;
+            }
+
+            // box2d ray casts divide by the ray length, a zero length ray hits nothing
+            const auto object_max = distance;
+            if (object_max > 0)
+                distance = object_grid.traverse(origin, direction, object_max, [&objects, &origin, &direction, &object_max, &category](const uint32_t item, const float best) -> float {
+                    const auto& object = objects[item];
+                    b2RayCastInput input;
+                    input.p1 = origin;
+                    input.p2 = origin + object_max * direction;
+                    input.maxFraction = best / object_max;
+                    b2RayCastOutput output;
+                    if (!get<0>(object)->RayCast(&output, input, get<1>(object)) || output.fraction * object_max >= best)
+                        return best;
+                    category = get<2>(object);
+                    return output.fraction * object_max;
+                });
+
+            if (!cast_particles)
+                continue;
+
+            const auto particle_distance = particle_grid.traverse(origin, direction, distance, [&particle_positions, &particle_radius, &origin, &direction](const uint32_t item, const float best) -> float {
+                return sensors::raycast_circle(particle_positions[item], particle_radius, origin, direction, best);
+            });
+            if (particle_distance < distance)
+            {
+                distance = particle_distance;
+                category = sensors::water;
+            }
+        }
+    });
+}
+
+void GameState::fillRegions()
+{
+    using std::cout;
+    using std::endl;
+
+    cout << "** fillRegions " << water_regions.size() << " " << crate_regions.size() << endl;
+
+    assert(system);
+
+    // convex pieces may exceed the polygon shape vertex limit, they are fanned around their first vertex
+    const auto convex_shapes = [](const Region& region) -> std::vector<b2PolygonShape>
+    {
+        std::vector<b2PolygonShape> shapes;
+        for (size_t ll=0; ll<region.size(); ll++)
+        {
+            const auto piece = region.begin(ll);
+            const auto piece_size = region.count(ll);
+            for (size_t kk=1; kk + 1<piece_size; kk+=b2_maxPolygonVertices - 2)
+            {
+                std::array<b2Vec2, b2_maxPolygonVertices> points;
+                points[0] = piece[0];
+                const auto count = std::min<size_t>(b2_maxPolygonVertices - 1, piece_size - kk);
+                std::copy_n(piece + kk, count, std::next(std::begin(points)));
+                if (count < 2)
+                    continue;
+
+                b2PolygonShape shape;
+                shape.Set(points.data(), count + 1);
+                shapes.emplace_back(shape);
+            }
+        }
+        return shapes;
+    };
+
+    for (const auto& region : water_regions)
+    { // one group per region, particles are laid out by liquidfun on its own lattice
+        const auto shapes = convex_shapes(region);
+        if (shapes.empty())
+            continue;
+
+        std::vector<const b2Shape*> shape_ptrs;
+        for (const auto& shape : shapes)
+            shape_ptrs.emplace_back(&shape);
+
+        b2ParticleGroupDef group_def;
+        group_def.flags = b2_waterParticle;
+        group_def.shapes = shape_ptrs.data();
+        group_def.shapeCount = shape_ptrs.size();
+        group_def.color.Set(0x6c, 0xc3, 0xf6, 255u);
+        create_group(*system, group_def, lattice_count(*system, group_def.shapes, group_def.shapeCount), max_particle_count);
+    }
+
+    int tag = 0;
+    for (const auto& region : crate_regions)
+    { // crates stacked on a grid, only where the whole crate fits
+        const auto shapes = convex_shapes(region);
+        if (shapes.empty())
+            continue;
+
+        b2Transform transform;
+        transform.SetIdentity();
+        b2AABB aabb;
+        shapes.front().ComputeAABB(&aabb, transform, 0);
+        for (const auto& shape : shapes)
+        {
+            b2AABB aabb_;
+            shape.ComputeAABB(&aabb_, transform, 0);
+            aabb.Combine(aabb_);
+        }
+
+        const auto contains = [&shapes, &transform](const b2Vec2& point) -> bool
+        {
+            for (const auto& shape : shapes)
+                if (shape.TestPoint(transform, point))
+                    return true;
+            return false;
+        };
+
+        const float32 spacing = 2 * crate_scale + .2;
+        for (auto yy = aabb.lowerBound.y + spacing / 2; yy < aabb.upperBound.y; yy += spacing)
+            for (auto xx = aabb.lowerBound.x + spacing / 2; xx < aabb.upperBound.x; xx += spacing)
+            {
+                const b2Vec2 center { xx, yy };
+                const bool fits =
+                    contains(center + b2Vec2 { -crate_scale, -crate_scale }) &&
+                    contains(center + b2Vec2 { crate_scale, -crate_scale }) &&
+                    contains(center + b2Vec2 { crate_scale, crate_scale }) &&
+                    contains(center + b2Vec2 { -crate_scale, crate_scale });
+                if (fits)
+                    addCrate(center, { 0, 0 }, 0, tag++);
+            }
+    }
+
+    cout << "filled " << system->GetParticleCount() << " particles " << crates.size() << " crates" << endl;
+}
+
+// native endianness, states are baked and loaded on the same kind of machine
+constexpr uint32 state_magic = 0x54534b52; // RKST
+constexpr uint32 state_version = 1;
+
+template <typename Type>
+static void write_pod(std::ostream& os, const Type& value)
+{
+    os.write(reinterpret_cast<const char*>(&value), sizeof(Type));
+}
+
+template <typename Type>
+static void write_vector(std::ostream& os, const std::vector<Type>& values)
+{
+    write_pod(os, static_cast<uint32>(values.size()));
+    os.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(Type));
+}
+
+template <typename Type>
+static bool read_pod(std::istream& is, Type& value)
+{
+    is.read(reinterpret_cast<char*>(&value), sizeof(Type));
+    return static_cast<bool>(is);
+}
+
+// bytes between the read position and the end of the stream, max when it can't seek
+static uint64_t remaining_bytes(std::istream& is)
+{
+    const auto position = is.tellg();
+    if (position < 0)
+        return std::numeric_limits<uint64_t>::max();
+    is.seekg(0, std::ios::end);
+    const auto end = is.tellg();
+    is.seekg(position);
+    if (end < position || !is)
+        return std::numeric_limits<uint64_t>::max();
+    return static_cast<uint64_t>(end - position);
+}
+
+// a corrupt size fails before anything is allocated, streams that can't seek are read
+// in bounded chunks so that memory only grows with the data actually there
+template <typename Type>
+static bool read_vector(std::istream& is, std::vector<Type>& values)
+{
+    uint32 size = 0;
+    if (!read_pod(is, size))
+        return false;
+    if (static_cast<uint64_t>(size) * sizeof(Type) > remaining_bytes(is))
+        return false;
+
+    constexpr size_t chunk_size = 1 << 16;
+    values.clear();
+    while (values.size() < size)
+    {
+        const auto begin = values.size();
+        const auto count = std::min<size_t>(chunk_size, size - begin);
+        values.resize(begin + count);
+        is.read(reinterpret_cast<char*>(values.data() + begin), count * sizeof(Type));
+        if (!is)
+            return false;
+    }
+    return true;
+}
+
+void GameState::saveState(std::ostream& os)
+{
+    using std::cout;
+    using std::endl;
+    using std::get;
+
+    assert(system);
+
+    const auto batches = snapshot_particles(*system, 0);
+
+    write_pod(os, state_magic);
+    write_pod(os, state_version);
+
+    write_pod(os, static_cast<uint32>(batches.size()));
+    for (const auto& batch : batches)
+    {
+        write_pod(os, static_cast<uint8>(batch.grouped));
+        write_pod(os, batch.group_flags);
+        write_pod(os, batch.linear_velocity);
+        write_pod(os, batch.angular_velocity);
+        write_vector(os, batch.positions);
+        write_vector(os, batch.velocities);
+        write_vector(os, batch.colors);
+        write_vector(os, batch.flags);
+        write_vector(os, batch.lifetimes);
+    }
+
+    write_pod(os, static_cast<uint32>(crates.size()));
+    for (const auto& crate : crates)
+    {
+        const auto& body = get<0>(crate);
+        assert(body);
+        write_pod(os, body->GetPosition());
+        write_pod(os, body->GetAngle());
+        write_pod(os, body->GetLinearVelocity());
+        write_pod(os, body->GetAngularVelocity());
+        write_pod(os, static_cast<int32>(get<1>(crate)));
+        write_pod(os, static_cast<uint8>(body->IsAwake()));
+    }
+
+    cout << "** saveState " << batches.size() << " batches " << crates.size() << " crates" << endl;
+}
+
+bool GameState::loadState(std::istream& is)
+{
+    using std::cout;
+    using std::endl;
+    using std::get;
+
+    cout << "** loadState ";
+
+    uint32 magic = 0;
+    uint32 version = 0;
+    if (!read_pod(is, magic) || !read_pod(is, version) || magic != state_magic || version != state_version)
+    {
+        cout << "invalid header" << endl;
+        return false;
+    }
+
+    // everything is read before anything is created so that a truncated stream leaves the state untouched
+    ParticleBatches batches;
+    uint32 batch_count = 0;
+    if (!read_pod(is, batch_count))
+    {
+        cout << "truncated" << endl;
+        return false;
+    }
+    for (uint32 kk=0; kk<batch_count; kk++)
+    {
+        ParticleBatch batch;
+        uint8 grouped = 0;
+        const bool batch_ok =
+            read_pod(is, grouped) &&
+            read_pod(is, batch.group_flags) &&
+            read_pod(is, batch.linear_velocity) &&
+            read_pod(is, batch.angular_velocity) &&
+            read_vector(is, batch.positions) &&
+            read_vector(is, batch.velocities) &&
+            read_vector(is, batch.colors) &&
+            read_vector(is, batch.flags) &&
+            read_vector(is, batch.lifetimes);
+        const auto count = batch.positions.size();
+        const bool sizes_ok =
+            batch.velocities.size() == count &&
+            batch.colors.size() == count &&
+            batch.flags.size() == count &&
+            (batch.lifetimes.empty() || batch.lifetimes.size() == count);
+        if (!batch_ok || !sizes_ok)
+        {
+            cout << "truncated" << endl;
+            return false;
+        }
+        batch.grouped = grouped;
+        batches.emplace_back(std::move(batch));
+    }
+
+    using CrateData = std::tuple<b2Vec2, float32, b2Vec2, float32, int32, uint8>;
+    std::vector<CrateData> crate_datas;
+    uint32 crate_count = 0;
+    if (!read_pod(is, crate_count))
+    {
+        cout << "truncated" << endl;
+        return false;
+    }
+    for (uint32 kk=0; kk<crate_count; kk++)
+    {
+        CrateData data;
+        const bool crate_ok =
+            read_pod(is, get<0>(data)) &&
+            read_pod(is, get<1>(data)) &&
+            read_pod(is, get<2>(data)) &&
+            read_pod(is, get<3>(data)) &&
+            read_pod(is, get<4>(data)) &&
+            read_pod(is, get<5>(data));
+        if (!crate_ok)
+        {
+            cout << "truncated" << endl;
+            return false;
+        }
+        crate_datas.emplace_back(data);
+    }
+
+    assert(system);
+    restore_particles(*system, batches, max_particle_count);
+
+    for (const auto& data : crate_datas)
+    {
+        addCrate(get<0>(data), get<2>(data), get<1>(data), get<4>(data));
+        auto& body = get<0>(crates.back());
+        body->SetAngularVelocity(get<3>(data));
+        body->SetAwake(get<5>(data));
+    }
+
+    particle_peak_count = std::max(particle_peak_count, system->GetParticleCount());
+
+    cout << batches.size() << " batches " << system->GetParticleCount() << " particles " << crate_datas.size() << " crates" << endl;
+    return true;
+}
+
+void GameState::killOutOfBounds()
+{
+    using std::cout;
+    using std::endl;
+    using std::get;
+
+    assert(world_bounds.IsValid());
+    const auto& lower = world_bounds.lowerBound;
+    const auto& upper = world_bounds.upperBound;
+
+    { // particles
+        assert(system);
+
+        // four slabs surrounding the bounds
+        constexpr float32 depth = 1e4;
+        const auto center = world_bounds.GetCenter();
+        const auto extents = world_bounds.GetExtents() + b2Vec2 { depth, depth };
+        const std::array<std::tuple<b2Vec2, b2Vec2>, 4> slabs {
+            std::make_tuple(b2Vec2 { extents.x, depth / 2 }, b2Vec2 { center.x, lower.y - depth / 2 }),
+            std::make_tuple(b2Vec2 { extents.x, depth / 2 }, b2Vec2 { center.x, upper.y + depth / 2 }),
+            std::make_tuple(b2Vec2 { depth / 2, extents.y }, b2Vec2 { lower.x - depth / 2, center.y }),
+            std::make_tuple(b2Vec2 { depth / 2, extents.y }, b2Vec2 { upper.x + depth / 2, center.y }),
+        };
+
+        b2Transform transform;
+        transform.SetIdentity();
+        for (const auto& slab : slabs)
+        {
+            b2PolygonShape shape;
+            shape.SetAsBox(get<0>(slab).x, get<0>(slab).y, get<1>(slab), 0);
+            killed_particle_count += system->DestroyParticlesInShape(shape, transform);
+        }
+    }
+
+    { // crates
+        const auto is_outside = [&lower, &upper](const std::tuple<UniqueBody, int>& crate) -> bool
+        {
+            const auto& position = get<0>(crate)->GetWorldCenter();
+            return position.x < lower.x || position.y < lower.y || position.x > upper.x || position.y > upper.y;
+        };
+        const auto crates_end = std::remove_if(std::begin(crates), std::end(crates), is_outside);
+        const auto count = std::distance(crates_end, std::end(crates));
+        if (count)
+            cout << "** killOutOfBounds " << count << " crates" << endl;
+        crates.erase(crates_end, std::end(crates));
+        killed_crate_count += count;
+    }
 }
 
 void GameState::resetParticleSystem()
@@ -114,6 +1232,8 @@ void GameState::resetParticleSystem()
     system_def.density = .5;
     system_def.radius = .5;
     //system_def.elasticStrength = 1;
+    system_def.maxCount = max_particle_count;
+    system_def.destroyByAge = true;
     system_def.surfaceTensionPressureStrength = .4;
     system_def.surfaceTensionNormalStrength = .4;
     auto system_ = world.CreateParticleSystem(&system_def);
@@ -138,6 +1258,161 @@ void GameState::resetParticleSystem()
     */
 }
 
+void GameState::trimParticleSystem()
+{
+    using std::cout;
+    using std::endl;
+
+    assert(system);
+
+    // liquidfun never shrinks its particle, contact, body contact and stuck candidate buffers,
+    // live particles are moved to a fresh system sized by the live count instead
+    trim_rss_before = memory::resident_size();
+    cout << "** trimParticleSystem " << particle_peak_count << " -> " << system->GetParticleCount() << " ";
+    cout << "rss " << trim_rss_before / 1024 << "KiB -> ";
+    cout.flush();
+
+    auto old_system = std::move(system);
+    resetParticleSystem();
+    assert(old_system);
+    assert(system);
+
+    system->SetDensity(old_system->GetDensity());
+    system->SetDamping(old_system->GetDamping());
+    system->SetGravityScale(old_system->GetGravityScale());
+
+    // particles are reinserted sorted by grid cell for spatial locality
+    restore_particles(*system, snapshot_particles(*old_system, 4 * old_system->GetRadius()), max_particle_count);
+
+    old_system = nullptr;
+    particle_peak_count = system->GetParticleCount();
+
+    trim_rss_after = memory::resident_size();
+    cout << trim_rss_after / 1024 << "KiB" << endl;
+}
+
+memory::Report GameState::memoryReport() const
+{
+    using std::get;
+
+    memory::Report report;
+
+    { // world
+        size_t fixture_count = 0;
+        size_t fixture_bytes = 0;
+        for (auto body=world.GetBodyList(); body; body=body->GetNext())
+            for (auto fixture=body->GetFixtureList(); fixture; fixture=fixture->GetNext())
+            {
+                const auto shape = fixture->GetShape();
+                assert(shape);
+                fixture_count++;
+                fixture_bytes += sizeof(b2Fixture) + shape->GetChildCount() * sizeof(b2FixtureProxy);
+                switch (shape->GetType())
+                {
+                    case b2Shape::e_circle:
+                        fixture_bytes += sizeof(b2CircleShape);
+                        break;
+                    case b2Shape::e_polygon:
+                        fixture_bytes += sizeof(b2PolygonShape);
+                        break;
+                    case b2Shape::e_chain:
+                        fixture_bytes += sizeof(b2ChainShape) + static_cast<const b2ChainShape*>(shape)->m_count * sizeof(b2Vec2);
+                        break;
+                    default:
+                        fixture_bytes += sizeof(b2PolygonShape) + shape->GetChildCount() * sizeof(b2Vec2);
+                        break;
+                }
+            }
+
+        // a balanced tree holds one internal node per leaf
+        const size_t proxy_count = world.GetProxyCount();
+        const size_t node_count = proxy_count ? 2 * proxy_count - 1 : 0;
+
+        // the state only creates distance joints for links and prismatic joints for doors
+        size_t joint_bytes = 0;
+        for (auto joint=world.GetJointList(); joint; joint=joint->GetNext())
+            switch (joint->GetType())
+            {
+                case e_distanceJoint:
+                    joint_bytes += sizeof(b2DistanceJoint);
+                    break;
+                case e_prismaticJoint:
+                    joint_bytes += sizeof(b2PrismaticJoint);
+                    break;
+                default:
+                    joint_bytes += sizeof(b2Joint);
+                    break;
+            }
+
+        report.emplace_back("world bodies", world.GetBodyCount(), world.GetBodyCount() * sizeof(b2Body));
+        report.emplace_back("world fixtures", fixture_count, fixture_bytes);
+        report.emplace_back("world joints", world.GetJointCount(), joint_bytes);
+        report.emplace_back("world contacts", world.GetContactCount(), world.GetContactCount() * sizeof(b2Contact));
+        report.emplace_back("world dynamic tree", node_count, node_count * sizeof(b2TreeNode));
+    }
+
+    if (system)
+    { // liquidfun keeps its buffer capacities private and never shrinks them,
+      // rows marked min are sized by the peak or current count and underestimate the allocation
+        const size_t peak_count = particle_peak_count;
+
+        size_t particle_bytes =
+            sizeof(uint32) + // flags
+            3 * sizeof(b2Vec2) + // position, velocity, force
+            2 * sizeof(float32) + // weight, accumulation
+            sizeof(b2ParticleColor) +
+            sizeof(b2ParticleGroup*) +
+            2 * sizeof(int32); // proxy
+        if (system->GetExpirationTimeBuffer())
+            particle_bytes += 2 * sizeof(int32);
+
+        report.emplace_back("particle buffers (min)", peak_count, peak_count * particle_bytes);
+        report.emplace_back("particle contacts (min)", system->GetContactCount(), system->GetContactCount() * sizeof(b2ParticleContact));
+        report.emplace_back("particle body contacts (min)", system->GetBodyContactCount(), system->GetBodyContactCount() * sizeof(b2ParticleBodyContact));
+        report.emplace_back("particle stuck candidates (min)", system->GetStuckCandidateCount(), system->GetStuckCandidateCount() * sizeof(int32));
+        report.emplace_back("particle groups", system->GetParticleGroupCount(), system->GetParticleGroupCount() * sizeof(b2ParticleGroup));
+    }
+
+    { // containers
+        size_t door_bytes = doors.capacity() * sizeof(decltype(doors)::value_type);
+        for (const auto& door : doors)
+            door_bytes += get<1>(door).capacity() * sizeof(b2Vec2);
+
+        report.emplace_back("state crates", crates.size(), crates.capacity() * sizeof(decltype(crates)::value_type));
+        report.emplace_back("state doors", doors.size(), door_bytes);
+        report.emplace_back("state emitters", emitters.size(), emitters.capacity() * sizeof(EmitterState));
+        report.emplace_back("state bots", bots.size(), bots.size() * (3 * sizeof(UniqueBody) + 9 * sizeof(float) + sizeof(unsigned int) + sizeof(unsigned char)));
+    }
+
+    if (!chunks.empty())
+    { // streaming
+        size_t chunk_bytes = chunks.capacity() * sizeof(Chunk);
+        size_t particle_count = 0;
+        size_t particle_bytes = 0;
+        size_t crate_count = 0;
+        for (const auto& chunk : chunks)
+        {
+            chunk_bytes += (chunk.pieces.capacity() + chunk.pending_pieces.capacity()) * sizeof(uint32_t);
+            const auto& batch = chunk.particles;
+            particle_count += batch.positions.size();
+            particle_bytes += (batch.positions.capacity() + batch.velocities.capacity()) * sizeof(b2Vec2);
+            particle_bytes += batch.colors.capacity() * sizeof(b2ParticleColor) + batch.flags.capacity() * sizeof(uint32) + batch.lifetimes.capacity() * sizeof(float32);
+            crate_count += chunk.crates.size();
+        }
+        report.emplace_back("state chunks", chunks.size(), chunk_bytes);
+        report.emplace_back("dormant particles", particle_count, particle_bytes);
+        report.emplace_back("dormant crates", crate_count, crate_count * sizeof(decltype(Chunk::crates)::value_type));
+    }
+
+    return report;
+}
+
+size_t GameState::crateBytes()
+{
+    // body, fixture, polygon shape, broadphase proxy with its internal tree node and container slot
+    return sizeof(b2Body) + sizeof(b2Fixture) + sizeof(b2PolygonShape) + sizeof(b2FixtureProxy) + 2 * sizeof(b2TreeNode) + sizeof(decltype(crates)::value_type);
+}
+
 void GameState::dumpCollisionData() const
 {
     using std::cout;
@@ -294,7 +1569,7 @@ void GameState::addWater(const b2Vec2& position, const b2Vec2& size, const size_
     cout << std::bitset<32>(group_def.groupFlags).to_string() << endl;
     group_def.position.Set(position.x, position.y);
     group_def.color.Set(rr, gg, bb, 255u);
-    system->CreateParticleGroup(group_def);
+    create_group(*system, group_def, lattice_count(*system, &group_def.shape, 1), max_particle_count);
 }
 
 void GameState::clearWater(const int group_count)
@@ -313,6 +1588,101 @@ void GameState::clearWater(const int group_count)
         group->DestroyParticles(false);
         count++;
     }
+
+    if (group_count < 0)
+    { // emitted particles are not attached to any group
+        const auto groups = system->GetGroupBuffer();
+        for (auto kk=0, kk_max=system->GetParticleCount(); kk<kk_max; kk++)
+            if (!groups[kk])
+                system->DestroyParticle(kk);
+    }
+}
+
+void GameState::compactWater(const size_t max_joins)
+{
+    using std::cout;
+    using std::endl;
+
+    assert(system);
+
+    const auto can_join = [](const b2ParticleGroup& aa, const b2ParticleGroup& bb) -> bool
+    {
+        if (aa.GetGroupFlags() != bb.GetGroupFlags()) return false;
+        if (aa.GetGroupFlags() & b2_rigidParticleGroup) return false;
+        if (aa.GetParticleCount() == 0 || bb.GetParticleCount() == 0) return true;
+        return aa.GetAllParticleFlags() == bb.GetAllParticleFlags();
+    };
+
+    const auto compute_aabb = [this](const b2ParticleGroup& group) -> b2AABB
+    {
+        const auto margin = 2 * system->GetRadius();
+        const auto positions = system->GetPositionBuffer();
+        b2AABB aabb;
+        aabb.lowerBound = { std::numeric_limits<float32>::max(), std::numeric_limits<float32>::max() };
+        aabb.upperBound = -aabb.lowerBound;
+        for (auto kk=group.GetBufferIndex(), kk_max=kk + group.GetParticleCount(); kk<kk_max; kk++)
+        {
+            aabb.lowerBound = b2Min(aabb.lowerBound, positions[kk]);
+            aabb.upperBound = b2Max(aabb.upperBound, positions[kk]);
+        }
+        aabb.lowerBound -= b2Vec2 { margin, margin };
+        aabb.upperBound += b2Vec2 { margin, margin };
+        return aabb;
+    };
+
+    // each join rotates the particle buffers so that the merged group is contiguous,
+    // groups are listed again after every join since their extent changed
+    size_t joins = 0;
+    bool joined = true;
+    while (joined && joins < max_joins)
+    {
+        joined = false;
+
+        std::vector<std::tuple<b2ParticleGroup*, b2AABB>> groups;
+        for (auto* group = system->GetParticleGroupList(); group; group = group->GetNext())
+            groups.emplace_back(group, compute_aabb(*group));
+
+        for (auto aa=std::cbegin(groups), aa_end=std::cend(groups); !joined && aa!=aa_end; aa++)
+            for (auto bb=std::next(aa); !joined && bb!=aa_end; bb++)
+            {
+                auto* group_aa = std::get<0>(*aa);
+                auto* group_bb = std::get<0>(*bb);
+                if (!can_join(*group_aa, *group_bb))
+                    continue;
+
+                const bool any_empty = group_aa->GetParticleCount() == 0 || group_bb->GetParticleCount() == 0;
+                if (!any_empty && !b2TestOverlap(std::get<1>(*aa), std::get<1>(*bb)))
+                    continue;
+
+                system->JoinParticleGroups(group_aa, group_bb);
+                joined = true;
+                joins++;
+            }
+    }
+
+    if (joins)
+        cout << "** compactWater " << joins << " " << system->GetParticleGroupCount() << endl;
+
+    compaction_join_count += joins;
+}
+
+void GameState::addEmitter(const b2Vec2& position, const b2Vec2& size, const b2Vec2& velocity, const float rate, const float lifetime)
+{
+    using std::cout;
+    using std::endl;
+
+    cout << "** addEmitter " << rate << "/s " << lifetime << "s" << endl;
+
+    std::uniform_int_distribution<int> dist(0, 255);
+
+    EmitterState emitter;
+    emitter.position = position;
+    emitter.size = size;
+    emitter.velocity = velocity;
+    emitter.rate = rate;
+    emitter.lifetime = lifetime;
+    emitter.color.Set(dist(emitter_rng), dist(emitter_rng), dist(emitter_rng), 255u);
+    emitters.emplace_back(emitter);
 }
 
 void GameState::grab()
@@ -359,6 +1729,9 @@ void GameState::step(const float dt)
 {
     using std::get;
 
+    if (ground_grid_count != ground_segments.size())
+        rebuildGroundGrid(); // once per step however many carves happened since
+
     for (auto& door : doors)
     {
         assert(get<0>(door));
@@ -369,6 +1742,30 @@ void GameState::step(const float dt)
         get<0>(door)->SetLinearVelocity(20 * delta_norm);
     }
 
+    if (emitters_enabled)
+    { // emitters
+        assert(system);
+        std::uniform_real_distribution<float32> dist(-1, 1);
+        for (auto& emitter : emitters)
+        {
+            // particles are created ungrouped so that streaming does not rotate group buffers,
+            // liquidfun recycles the oldest ones once max_particle_count is reached
+            emitter.accum = std::min(emitter.accum + emitter.rate * dt, static_cast<float>(max_particle_count));
+
+            b2ParticleDef def;
+            def.flags = b2_waterParticle;
+            def.velocity = emitter.velocity;
+            def.color = emitter.color;
+            def.lifetime = emitter.lifetime;
+            while (emitter.accum >= 1)
+            {
+                def.position = emitter.position + b2Vec2 { dist(emitter_rng) * emitter.size.x, dist(emitter_rng) * emitter.size.y };
+                system->CreateParticle(def);
+                emitter.accum -= 1;
+            }
+        }
+    }
+
     { // ship
         assert(ship);
         const auto angle = ship->GetAngle();
@@ -391,6 +1788,41 @@ void GameState::step(const float dt)
         ship->SetAngularVelocity((ship_state.target_angle - angle) / .05);
     }
 
+    if (bots.size())
+    { // bots, gathered into contiguous arrays so that the control pass vectorizes
+        const auto count = bots.size();
+        for (size_t kk=0; kk<count; kk++)
+            bots.angle[kk] = bots.ships[kk]->GetAngle();
+
+        const float* __restrict thrust = bots.thrust.data();
+        const float* __restrict turn = bots.turn.data();
+        const float* __restrict grabbed = bots.grabbed.data();
+        const float* __restrict mass = bots.mass.data();
+        const float* __restrict angle = bots.angle.data();
+        float* __restrict target_angle = bots.target_angle.data();
+        float* __restrict force_x = bots.force_x.data();
+        float* __restrict force_y = bots.force_y.data();
+        float* __restrict angular_velocity = bots.angular_velocity.data();
+        for (size_t kk=0; kk<count; kk++)
+        {
+            const float force = mass[kk] * thrust[kk] * 2 * (40 + 10 * grabbed[kk]);
+            force_x[kk] = -std::sin(angle[kk]) * force;
+            force_y[kk] = std::cos(angle[kk]) * force;
+            target_angle[kk] += turn[kk] * (2.6f - .6f * grabbed[kk]) * static_cast<float>(M_PI) / 2 * dt;
+            angular_velocity[kk] = (target_angle[kk] - angle[kk]) / .05f;
+        }
+
+        for (size_t kk=0; kk<count; kk++)
+        {
+            auto& ship_ = *bots.ships[kk];
+            if (thrust[kk] > 0)
+                ship_.ApplyForceToCenter({ force_x[kk], force_y[kk] }, true);
+            ship_.SetAngularVelocity(angular_velocity[kk]);
+        }
+
+        std::fill(std::begin(bots.accum_contact), std::end(bots.accum_contact), 0);
+    }
+
     { // step
         ship_state.accum_contact = 0;
         all_accum_contact = 0;
@@ -401,6 +1833,22 @@ void GameState::step(const float dt)
         world.ClearForces();
     }
 
+    { // the cap lifted by create_group comes back once the destroyed particles are gone
+        assert(system);
+        if (system->GetMaxParticleCount() > max_particle_count && system->GetParticleCount() <= max_particle_count)
+            system->SetMaxParticleCount(max_particle_count);
+    }
+
+    if (auto_compact_water)
+    {
+        compaction_timer += dt;
+        if (compaction_timer >= compaction_period)
+        {
+            compaction_timer = 0;
+            compactWater(8);
+        }
+    }
+
     if (clean_stuck_in_door)
     {
         assert(system);
@@ -421,6 +1869,17 @@ void GameState::step(const float dt)
             }
     }
 
+    if (kill_out_of_bounds)
+        killOutOfBounds();
+
+    { // particle buffers trimming
+        assert(system);
+        const auto count = system->GetParticleCount();
+        particle_peak_count = std::max(particle_peak_count, count);
+        if (auto_trim_particles && particle_peak_count > trim_min_count && particle_peak_count > trim_hysteresis * count)
+            trimParticleSystem();
+    }
+
 }
 
 void GameState::BeginContact(b2Contact* contact)
@@ -448,6 +1907,115 @@ void GameState::BeginContact(b2Contact* contact)
     ship_state.touched_wall |= any_ship && any_wall;
     if (any_ship) ship_state.accum_contact++;
     all_accum_contact++;
+
+    const auto bot_contact = [this, &any_wall](const b2Body& body) -> void
+    {
+        const auto index = reinterpret_cast<uintptr_t>(body.GetUserData());
+        if (!index)
+            return;
+        assert(index <= bots.size());
+        bots.accum_contact[index - 1]++;
+        bots.touched_wall[index - 1] |= any_wall;
+    };
+    bot_contact(*aa);
+    bot_contact(*bb);
+}
+
+void GameState::addBots(const size_t count, const b2Vec2& center, const float spacing, const bool with_balls)
+{
+    using std::cout;
+    using std::endl;
+
+    cout << "** addBots " << count << (with_balls ? " with balls" : "") << endl;
+
+    const auto create_body = [this](const b2Vec2& position, const b2Shape& shape, const float density) -> UniqueBody
+    {
+        b2BodyDef def;
+        def.type = b2_dynamicBody;
+        def.position = position;
+
+        b2FixtureDef fixture;
+        fixture.shape = &shape;
+        fixture.density = density;
+        fixture.friction = default_friction;
+        fixture.restitution = default_restitution;
+        fixture.filter.categoryBits = object_category;
+        fixture.filter.maskBits = object_category | ground_category | door_category;
+
+        auto body = world.CreateBody(&def);
+        body->CreateFixture(&fixture);
+        return UniqueBody(body, [this](b2Body* body) -> void { world.DestroyBody(body); });
+    };
+
+    b2PolygonShape ship_shape;
+    static const b2Vec2 points[3] {
+        { -ship_scale, 0 },
+        { ship_scale, 0 },
+        { 0, ship_scale * 2 }
+    };
+    ship_shape.Set(points, 3);
+
+    b2CircleShape ball_shape;
+    ball_shape.m_radius = ball_scale;
+
+    // square grid centered on center, balls hang below their ship
+    const auto side = static_cast<size_t>(std::ceil(std::sqrt(count)));
+    const auto cell = with_balls ? b2Vec2 { spacing, spacing + 15 } : b2Vec2 { spacing, spacing };
+    const auto origin = center - .5f * static_cast<float>(side - 1) * cell;
+    for (size_t kk=0; kk<count; kk++)
+    {
+        const b2Vec2 position = origin + b2Vec2 { static_cast<float>(kk % side) * cell.x, static_cast<float>(kk / side) * cell.y };
+
+        auto ship_ = create_body(position, ship_shape, default_density * 5);
+        ship_->SetUserData(reinterpret_cast<void*>(static_cast<uintptr_t>(bots.size() + 1)));
+
+        if (with_balls)
+        {
+            auto ball_ = create_body(position - b2Vec2 { 0, 15 }, ball_shape, default_density);
+
+            b2DistanceJointDef def;
+            def.Initialize(ship_.get(), ball_.get(), ship_->GetWorldCenter(), ball_->GetWorldCenter());
+            def.frequencyHz = 25.;
+            def.dampingRatio = .2;
+            def.collideConnected = true;
+            auto joint = static_cast<b2DistanceJoint*>(world.CreateJoint(&def));
+
+            bots.links.emplace_back(joint, [this](b2Joint* joint) -> void { world.DestroyJoint(joint); });
+            bots.balls.emplace_back(std::move(ball_));
+        }
+
+        bots.mass.emplace_back(ship_->GetMass());
+        bots.ships.emplace_back(std::move(ship_));
+        bots.thrust.emplace_back(0);
+        bots.turn.emplace_back(0);
+        bots.grabbed.emplace_back(with_balls ? 1 : 0);
+        bots.target_angle.emplace_back(0);
+        bots.accum_contact.emplace_back(0);
+        bots.touched_wall.emplace_back(false);
+    }
+
+    bots.angle.resize(bots.size());
+    bots.force_x.resize(bots.size());
+    bots.force_y.resize(bots.size());
+    bots.angular_velocity.resize(bots.size());
+}
+
+void GameState::clearBots()
+{
+    // joints go before the bodies they connect
+    bots.links.clear();
+    bots = Bots();
+}
+
+void GameState::wanderBots(const float dt)
+{
+    // inputs follow a clamped random walk, thrust is biased toward hovering
+    std::normal_distribution<float> dist(0, 2 * std::sqrt(dt));
+    for (size_t kk=0, kk_max=bots.size(); kk<kk_max; kk++)
+    {
+        bots.thrust[kk] = b2Clamp(bots.thrust[kk] + dist(bot_rng), 0.f, 1.f);
+        bots.turn[kk] = b2Clamp(bots.turn[kk] + dist(bot_rng) - bots.target_angle[kk] * dt, -1.f, 1.f);
+    }
 }
 
 void GameState::addDoor(const b2Vec2& pos, const b2Vec2& size, const b2Vec2& delta)
@@ -570,5 +2138,25 @@ void GameState::clearCrates()
 
 GameState::~GameState()
 {
+    using std::get;
+
     world.SetContactListener(nullptr);
+
+    // the world releases its bodies, joints and particle system on destruction,
+    // destroying them one by one beforehand only updates contacts and broadphase for nothing
+    link.release();
+    for (auto& link_ : bots.links)
+        link_.release();
+    for (auto& ball_ : bots.balls)
+        ball_.release();
+    for (auto& ship_ : bots.ships)
+        ship_.release();
+    for (auto& crate : crates)
+        get<0>(crate).release();
+    for (auto& door : doors)
+        get<0>(door).release();
+    system.release();
+    ball.release();
+    ship.release();
+    ground.release();
 }
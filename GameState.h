@@ -5,11 +5,35 @@
 #include "Box2D/Dynamics/Joints/b2DistanceJoint.h"
 #include "Box2D/Dynamics/Joints/b2PrismaticJoint.h"
 #include "Box2D/Particle/b2ParticleSystem.h"
+#include "Box2D/Collision/b2Collision.h"
+#include "Box2D/Collision/Shapes/b2PolygonShape.h"
+
+#include "ArenaAllocator.h"
+#include "memory_usage.h"
+#include "ground_polygons.h"
+#include "sensors.h"
 
 #include <memory>
 #include <vector>
 #include <random>
 #include <functional>
+#include <iosfwd>
+#include <tuple>
+#include <future>
+
+// particles of one group, or of no group at all, in a form that outlives their system
+struct ParticleBatch
+{
+    bool grouped = true;
+    uint32 group_flags = 0;
+    b2Vec2 linear_velocity = { 0, 0 };
+    float32 angular_velocity = 0;
+    std::vector<b2Vec2> positions;
+    std::vector<b2Vec2> velocities;
+    std::vector<b2ParticleColor> colors;
+    std::vector<uint32> flags;
+    std::vector<float32> lifetimes; // empty when the system does not track lifetimes
+};
 
 struct GameState : public b2ContactListener
 {
@@ -18,6 +42,8 @@ struct GameState : public b2ContactListener
 
     void step(const float dt);
     void dumpCollisionData() const;
+    memory::Report memoryReport() const;
+    static size_t crateBytes();
 
     bool canGrab() const;
     bool isGrabbed() const;
@@ -29,14 +55,53 @@ struct GameState : public b2ContactListener
 
     void addWater(const b2Vec2& pos, const b2Vec2& size, const size_t seed, const unsigned int flags);
     void clearWater(const int group_count);
+    void compactWater(const size_t max_joins);
+
+    void addEmitter(const b2Vec2& pos, const b2Vec2& size, const b2Vec2& velocity, const float rate, const float lifetime);
 
     void addDoor(const b2Vec2& pos, const b2Vec2& size, const b2Vec2& delta);
     void addPath(const std::vector<b2Vec2>& positions, const b2Vec2& size);
 
+    void addBots(const size_t count, const b2Vec2& center, const float spacing, const bool with_balls);
+    void clearBots();
+    void wanderBots(const float dt);
+
     void resetShip(const b2Vec2& pos);
     void resetBall(const b2Vec2& pos);
     void resetParticleSystem();
-    void resetGround(const std::string& map_filename);
+    void trimParticleSystem();
+    void resetGround(const std::string& map_filename, const polygons::GroundOptions& options = polygons::GroundOptions());
+    void resetGround(const polygons::Ground& ground, const float chunk_size = 0);
+    // swaps in a rebuilt ground, fixtures of unchanged pieces and loops stay, returns kept and created fixture counts
+    std::tuple<size_t, size_t> updateGround(const polygons::Ground& ground);
+    // removes a convex counter clockwise polygon from the foreground, only overlapping pieces are cut and replaced,
+    // returns removed and created fixture counts, chain ground is left as is
+    std::tuple<size_t, size_t> carveGround(const polygons::Poly& carve);
+    void rebuildGroundGrid();
+
+    // ground streaming over square chunks of chunk_size world units, zero keeps the whole ground loaded,
+    // chunks closer than radius to the focus get their fixtures back, shapes are prepared on the global pool,
+    // wait finishes those loads before returning, for the spawn area before the first step,
+    // chunks farther than radius plus one chunk lose them, particles and crates in chunks neither loaded nor loading
+    // are kept out of the world and other bodies there are deactivated, returns the loaded chunk count,
+    // only fixtures and simulated objects are bounded, ground_pieces and ground_loops stay whole in memory
+    void resetChunks(const float chunk_size);
+    size_t streamChunks(const b2Vec2& focus, const float radius, const bool wait = false);
+    size_t chunkIndex(const b2Vec2& point) const;
+    b2AABB chunkBounds(const size_t index) const;
+    void binChunkPieces();
+    void startChunkLoad(const size_t index);
+    void finishChunkLoad(const size_t index);
+    void unloadChunk(const size_t index);
+    void storeDormant();
+    void killOutOfBounds();
+
+    // rays against ground, doors, crates, ships, balls and optionally particles
+    void castRays(const sensors::Rays& rays, sensors::Hits& hits, const bool with_particles, const size_t thread_count) const;
+
+    void fillRegions();
+    void saveState(std::ostream& os);
+    bool loadState(std::istream& is);
 
     void BeginContact(b2Contact* contact) override;
 
@@ -48,6 +113,10 @@ struct GameState : public b2ContactListener
     static constexpr float ball_scale = 5;
     static constexpr float crate_scale = 3.5;
 
+    static bool use_arena;
+
+    // must outlive the world whose blocks it holds
+    ArenaAllocator arena { use_arena };
     b2World world = b2World({ 0, -8 });
     UniqueBody ground = nullptr;
     UniqueBody ship = nullptr;
@@ -58,6 +127,70 @@ struct GameState : public b2ContactListener
     std::vector<std::tuple<UniqueBody, int>> crates;
     std::vector<std::tuple<UniqueBody, std::vector<b2Vec2>, size_t>> doors;
 
+    struct EmitterState
+    {
+        b2Vec2 position = { 0, 0 };
+        b2Vec2 size = { 1, 1 };
+        b2Vec2 velocity = { 0, 0 };
+        float rate = 0;
+        float lifetime = 0;
+        float accum = 0;
+        b2ParticleColor color = { 0, 0, 0, 0 };
+    };
+
+    // geometry behind the ground fixtures, fixtures are null for degenerate loops and carved away pieces
+    polygons::PolySoup ground_pieces;
+    polygons::PolySoup ground_loops;
+    std::vector<b2Fixture*> piece_fixtures;
+    std::vector<b2Fixture*> loop_fixtures;
+    std::vector<bool> piece_carved;
+    size_t carved_piece_count = 0;
+
+    static constexpr float carve_min_area = .01; // smaller pieces left by carving are dropped
+
+    struct Chunk
+    {
+        std::vector<uint32_t> pieces; // live pieces binned by vertex average
+        bool loaded = false;
+        std::vector<uint32_t> pending_pieces; // pieces without fixture when the load started, max when carved since
+        std::future<std::vector<b2PolygonShape>> pending_shapes;
+        ParticleBatch particles; // dormant, ungrouped
+        std::vector<std::tuple<b2Vec2, b2Vec2, float, int>> crates; // dormant position, velocity, angle, tag
+    };
+
+    float chunk_size = 0;
+    b2Vec2 chunk_lower = { 0, 0 };
+    int chunk_columns = 0;
+    int chunk_rows = 0;
+    std::vector<Chunk> chunks;
+
+    // convex pieces of the svg regions coded as water or crates, in world space
+    using Region = polygons::Ground::Region;
+    std::vector<Region> water_regions;
+    std::vector<Region> crate_regions;
+
+    // ground outlines in world space for sensors, carving shortens segments and appends crater walls
+    std::vector<sensors::Segment> ground_segments;
+    sensors::Grid ground_grid;
+    size_t ground_grid_count = 0; // segments binned in the grid, rebuilt at the next step when more were appended
+
+    std::vector<EmitterState> emitters;
+    std::default_random_engine emitter_rng;
+    bool emitters_enabled = true;
+    int max_particle_count = 20000; // oldest particles are recycled past it
+
+    bool auto_compact_water = true;
+    float compaction_period = 1;
+    float compaction_timer = 0;
+    unsigned int compaction_join_count = 0;
+
+    bool auto_trim_particles = true;
+    float trim_hysteresis = 4;
+    int trim_min_count = 4096;
+    int particle_peak_count = 0;
+    size_t trim_rss_before = 0;
+    size_t trim_rss_after = 0;
+
     struct ShipState
     {
         bool firing_thruster = false;
@@ -73,7 +206,39 @@ struct GameState : public b2ContactListener
 
     ShipState ship_state;
 
+    // bot ships as a structure of arrays, indexed by the body user data minus one,
+    // controllers write thrust and turn before step
+    struct Bots
+    {
+        std::vector<UniqueBody> ships;
+        std::vector<UniqueBody> balls;
+        std::vector<UniqueDistanceJoint> links;
+        std::vector<float> thrust; // [0, 1]
+        std::vector<float> turn; // [-1, 1], positive turns left
+        std::vector<float> grabbed;
+        std::vector<float> mass;
+        std::vector<float> target_angle;
+        std::vector<unsigned int> accum_contact;
+        std::vector<unsigned char> touched_wall;
+
+        // control pass scratch
+        std::vector<float> angle;
+        std::vector<float> force_x;
+        std::vector<float> force_y;
+        std::vector<float> angular_velocity;
+
+        size_t size() const { return ships.size(); }
+    };
+
+    Bots bots;
+    std::default_random_engine bot_rng;
+
     unsigned int all_accum_contact = 0;
     bool clean_stuck_in_door = true;
+
+    b2AABB world_bounds;
+    bool kill_out_of_bounds = true;
+    unsigned int killed_particle_count = 0;
+    unsigned int killed_crate_count = 0;
 };
 
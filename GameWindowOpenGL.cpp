@@ -3,6 +3,8 @@
 #include "Box2D/Dynamics/b2Fixture.h"
 #include "Box2D/Collision/Shapes/b2PolygonShape.h"
 #include "Box2D/Collision/Shapes/b2CircleShape.h"
+#include "Box2D/Collision/Shapes/b2ChainShape.h"
+#include "carve_polygons.h"
 
 #include "QtImGui.h"
 #include <QDebug>
@@ -11,6 +13,8 @@
 #include <QtMath>
 #include <QFontDatabase>
 #include <QOpenGLShaderProgram>
+#include <QFile>
+#include <QCoreApplication>
 
 #include <imgui.h>
 
@@ -19,11 +23,15 @@
 #include <sstream>
 #include <unordered_set>
 #include <bitset>
+#include <algorithm>
 #include <iomanip>
+#include <chrono>
+#include <thread>
+#include <fstream>
 
-const char* shader_names[] = { "out group + dot speed", "out speed + dot flag", "out flag + dot speed", "out flag + dot group", "dot group", "dot uniform", "dot stuck", "dot flag", "dot speed" };
 const int shader_switch_key = Qt::Key_Q;
 const int level_switch_key = Qt::Key_L;
+const int carve_key = Qt::Key_Z;
 
 constexpr auto ui_window_width = 330;
 constexpr auto ui_window_spacing = 5;
@@ -34,6 +42,7 @@ GameWindowOpenGL::GameWindowOpenGL(QWindow* parent)
 {
     registerFreeKey(shader_switch_key);
     registerFreeKey(level_switch_key);
+    registerFreeKey(carve_key);
     registerFreeKey(Qt::Key_Space);
     registerFreeKey(Qt::Key_Left);
     registerFreeKey(Qt::Key_Right);
@@ -79,7 +88,11 @@ GameWindowOpenGL::GameWindowOpenGL(QWindow* parent)
 
     {
         qDebug() << "========== levels";
-        data = levels::load(":/levels/levels.json");
+        ArenaAllocator::install();
+        const std::string json_filename = ":/levels/levels.json";
+        data = levels::load(json_filename);
+        if (!data.pack_filename.empty() && pack.open(data.pack_filename, levels::source_hash(json_filename, data)))
+            data = pack.getData();
         qDebug() << data.levels.size() << "levels";
         for (const auto& level : data.levels)
             qDebug() << "level" << QString::fromStdString(level.name) << QString::fromStdString(level.map_filename) << level.doors.size();
@@ -93,68 +106,449 @@ void GameWindowOpenGL::resetLevel()
 {
     using std::cout;
     using std::endl;
-    using std::get;
-
-    world_time = 0;
-    world_camera = Camera();
-    ship_camera = Camera();
 
     if (current_level < 0)
-    {
+    { // clearing is immediate, an in flight load is dropped when it completes
         current_level = -1;
+        loaded_level = -1;
+        level_load_requested = false;
         state = nullptr;
+        map_renderer = nullptr;
+        craters.clear();
+        tiles.clear();
+        world_time = 0;
         return;
     }
 
-    assert(current_level >= 0 );
     assert(current_level < static_cast<int>(data.levels.size()));
-    const auto& level = data.levels[current_level];
+    cout << "========== requesting " << std::quoted(data.levels[current_level].name) << endl;
+
+    // the current level keeps running until pollLevelLoad swaps the new one in
+    level_load_requested = true;
+    level_request_time = std::chrono::steady_clock::now();
+}
+
+GameWindowOpenGL::SharedAssets GameWindowOpenGL::prefetchAssets(const int index)
+{
+    using std::cout;
+    using std::endl;
+
+    assert(index >= 0);
+    assert(index < static_cast<int>(data.levels.size()));
+
+    const auto iter = prefetched_assets.find(index);
+    if (iter != std::cend(prefetched_assets))
+        return iter->second;
+
+    cout << "** prefetch " << index << endl;
+
+    // build_ground runs its decompositions on the global pool, so it must not run on that pool itself
+    auto future = std::async(std::launch::async, [this, index]() -> std::shared_ptr<const LevelAssets> {
+        const auto& level = data.levels[index];
+
+        auto assets = std::make_shared<LevelAssets>();
+        if (!pack.isOpen() || !pack.readGround(index, assets->ground))
+            assets->ground = polygons::build_ground(level.map_filename, level.ground_options, levels_dir.empty() ? nullptr : &ground_cache);
+
+        assets->renderer = std::make_shared<QSvgRenderer>();
+        const auto load_ok = assets->renderer->load(QString::fromStdString(level.map_filename));
+        assert(assets->renderer->isValid());
+        assert(load_ok);
+        assets->view_box = assets->renderer->viewBoxF();
+        assets->renderer->moveToThread(QCoreApplication::instance()->thread());
+
+        return assets;
+    });
 
-    cout << "========== loading " << std::quoted(level.name) << endl;
+    const auto shared_future = future.share();
+    prefetched_assets.emplace(index, shared_future);
+    return shared_future;
+}
+
+std::unique_ptr<GameState> GameWindowOpenGL::buildState(const int index, const SharedAssets& assets_future) const
+{
+    using std::get;
 
+    assert(index >= 0);
+    assert(index < static_cast<int>(data.levels.size()));
+    const auto& level = data.levels[index];
+    const auto assets = assets_future.get();
+    assert(assets);
+
+    auto state_ = std::make_unique<GameState>();
+    state_->resetGround(assets->ground, level.chunk_size);
+
+    if (level.has_world_bounds)
     {
-        state = std::make_unique<GameState>();
-        state->resetGround(level.map_filename);
-        loadBackground(level.map_filename);
+        state_->world_bounds.lowerBound = level.world_bounds_lower;
+        state_->world_bounds.upperBound = level.world_bounds_upper;
+    }
+
+    // the spawn area has its ground before anything is dropped on it, the rest streams in from the first frame
+    if (!state_->chunks.empty())
+        state_->streamChunks(level.ship_spawn, level.ship_screen_height, true);
 
-        for (const auto& door : level.doors)
-            state->addDoor(get<0>(door), get<1>(door), get<2>(door));
+    for (const auto& door : level.doors)
+        state_->addDoor(get<0>(door), get<1>(door), get<2>(door));
 
-        for (const auto& path : level.paths)
-            state->addPath(get<0>(path), get<1>(path));
+    for (const auto& path : level.paths)
+        state_->addPath(get<0>(path), get<1>(path));
 
-        state->dumpCollisionData();
+    for (const auto& emitter : level.emitters)
+        state_->addEmitter(get<0>(emitter), get<1>(emitter), get<2>(emitter), get<3>(emitter), get<4>(emitter));
+
+    { // settled water and crates baked by bake_states, the svg regions are filled in bulk otherwise
+        bool state_loaded = false;
+        if (!level.initial_state.empty())
+        {
+            QFile handle(QString::fromStdString(level.initial_state));
+            if (handle.open(QIODevice::ReadOnly))
+            {
+                std::istringstream is(handle.readAll().toStdString());
+                state_loaded = state_->loadState(is);
+            }
+        }
+        if (!state_loaded)
+            state_->fillRegions();
     }
 
+    state_->resetShip(level.ship_spawn);
+    state_->resetBall(level.ball_spawn);
+    state_->dumpCollisionData();
+
+    return state_;
+}
+
+void GameWindowOpenGL::pollLevelLoad()
+{
+    using std::cout;
+    using std::endl;
+
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<float, std::milli>;
+
+    if (pending_state.valid() && pending_state.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
     {
-        world_camera.position = { level.world_camera_position.x, level.world_camera_position.y };
-        world_camera.screen_height = level.world_screen_height;
-        ship_camera.screen_height = level.ship_screen_height;
+        auto state_ = pending_state.get();
+        const auto index = pending_level;
+        pending_level = -1;
+
+        if (!level_load_requested && index == current_level)
+        { // swap
+            const auto& level = data.levels[index];
+
+            {
+                const auto start = Clock::now();
+                state = nullptr;
+                level_teardown_ms = Milliseconds(Clock::now() - start).count();
+            }
+
+            state = std::move(state_);
+            ArenaAllocator::setCurrent(GameState::use_arena ? &state->arena : nullptr);
+            loaded_level = index;
+
+            const auto assets = prefetchAssets(index).get();
+            map_renderer = assets->renderer;
+            map_view_box = assets->view_box;
+            craters.clear();
+            tiles.clear();
+
+            world_time = 0;
+            world_camera = Camera();
+            ship_camera = Camera();
+            world_camera.position = { level.world_camera_position.x, level.world_camera_position.y };
+            world_camera.screen_height = level.world_screen_height;
+            ship_camera.screen_height = level.ship_screen_height;
+
+            ship_spawn = level.ship_spawn;
+            ball_spawn = level.ball_spawn;
+            crate_spawn = level.crate_spawn;
+            water_spawn = level.water_spawn;
+            water_drop_size = level.water_drop_size;
+
+            enforceCallbackValues();
+
+            level_load_ms = Milliseconds(Clock::now() - level_request_time).count();
+            cout << "========== loaded " << std::quoted(level.name) << " ";
+            cout << "teardown " << level_teardown_ms << "ms request to swap " << level_load_ms << "ms" << endl;
+
+            { // keep the neighbours ready and drop the rest
+                const int count = data.levels.size();
+                const std::array<int, 3> kept { index, (index + 1) % count, (index + count - 1) % count };
+                for (const auto& kk : kept)
+                    prefetchAssets(kk);
+                // releasing the last future of an std::async task blocks until it completes, in flight ones are dropped at a later load
+                for (auto iter=std::begin(prefetched_assets); iter!=std::end(prefetched_assets);)
+                    if (std::find(std::cbegin(kept), std::cend(kept), iter->first) == std::cend(kept) &&
+                        iter->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                        iter = prefetched_assets.erase(iter);
+                    else
+                        iter++;
+            }
+        }
+        // otherwise a newer request superseded this load, its state is dropped here
     }
 
+    if (!pending_state.valid() && level_load_requested && current_level >= 0)
     {
-        assert(state->ship);
-        assert(state->ball);
-        ship_spawn = level.ship_spawn;
-        ball_spawn = level.ball_spawn;
-        crate_spawn = level.crate_spawn;
-        water_spawn = level.water_spawn;
-        water_drop_size = level.water_drop_size;
-        state->resetShip(ship_spawn);
-        state->resetBall(ball_spawn);
+        level_load_requested = false;
+        pending_level = current_level;
+        const auto assets = prefetchAssets(pending_level);
+        pending_state = std::async(std::launch::async, [this, assets](const int index) -> std::unique_ptr<GameState> {
+            // the state arena is current while it is built here and handed to the main thread afterwards
+            ArenaAllocator::Scope arena_scope;
+            return buildState(index, assets);
+        }, pending_level);
     }
+}
+
+void GameWindowOpenGL::waitLevelLoads()
+{
+    if (pending_state.valid())
+        pending_state.wait();
+    for (const auto& pair : prefetched_assets)
+        pair.second.wait();
+}
+
+void GameWindowOpenGL::watchLevels(const std::string& levels_dir_)
+{
+    levels_dir = levels_dir_;
+
+    reload_timer.setSingleShot(true);
+    reload_timer.setInterval(100);
+    connect(&level_watcher, &QFileSystemWatcher::fileChanged, this, [this](const QString& path) -> void {
+        // files replaced on save drop out of the watcher
+        if (!level_watcher.files().contains(path) && QFile::exists(path))
+            level_watcher.addPath(path);
+        changed_files.emplace(path.toStdString());
+        reload_timer.start();
+    });
+    connect(&reload_timer, &QTimer::timeout, this, [this]() -> void {
+        const auto changed_files_ = std::move(changed_files);
+        changed_files.clear();
+        if (changed_files_.count(levels_dir + "/levels.json"))
+        {
+            reloadLevels();
+            return;
+        }
+        for (const auto& map_filename : changed_files_)
+            reloadMap(map_filename);
+    });
+
+    // replaces the levels loaded by the constructor
+    reloadLevels();
+}
+
+void GameWindowOpenGL::reloadLevels()
+{
+    using std::cout;
+    using std::endl;
+
+    // tasks in flight read data
+    waitLevelLoads();
+    prefetched_assets.clear();
+
+    // the sources win over the baked pack
+    pack.close();
+
+    const auto json_filename = levels_dir + "/levels.json";
+    data = levels::load(json_filename);
+    const std::string prefix = ":/levels/";
+    for (auto& level : data.levels)
+        if (level.map_filename.compare(0, prefix.size(), prefix) == 0)
+            level.map_filename = levels_dir + "/" + level.map_filename.substr(prefix.size());
 
-    enforceCallbackValues();
+    const auto files = level_watcher.files();
+    if (!files.isEmpty())
+        level_watcher.removePaths(files);
+    level_watcher.addPath(QString::fromStdString(json_filename));
+    for (const auto& level : data.levels)
+        level_watcher.addPath(QString::fromStdString(level.map_filename));
+
+    cout << "========== watching " << std::quoted(levels_dir) << " " << data.levels.size() << " levels" << endl;
+
+    if (current_level < 0 || current_level >= static_cast<int>(data.levels.size()))
+        current_level = data.default_level;
+    resetLevel();
+}
+
+void GameWindowOpenGL::reloadMap(const std::string& map_filename)
+{
+    using std::cout;
+    using std::endl;
+
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<float, std::milli>;
+
+    waitLevelLoads();
+    for (auto iter=std::begin(prefetched_assets); iter!=std::end(prefetched_assets);)
+        if (data.levels[iter->first].map_filename == map_filename)
+            iter = prefetched_assets.erase(iter);
+        else
+            iter++;
+
+    if (!state || loaded_level < 0 || data.levels[loaded_level].map_filename != map_filename)
+        return;
+
+    // unchanged polygons come from the cache and keep their fixtures, the running state goes on
+    const auto start = Clock::now();
+    const auto& level = data.levels[loaded_level];
+    const auto ground = polygons::build_ground(map_filename, level.ground_options, &ground_cache);
+    size_t kept_count, created_count;
+    std::tie(kept_count, created_count) = state->updateGround(ground);
+    craters.clear();
+    tiles.clear();
+
+    auto renderer = std::make_shared<QSvgRenderer>();
+    if (renderer->load(QString::fromStdString(map_filename)) && renderer->isValid())
+    {
+        map_renderer = renderer;
+        map_view_box = renderer->viewBoxF();
+    }
+
+    cout << "========== hot reload " << std::quoted(map_filename) << " " << Milliseconds(Clock::now() - start).count() << "ms ";
+    cout << kept_count << " fixtures kept " << created_count << " created" << endl;
+}
+
+void GameWindowOpenGL::updateTiles()
+{
+    assert(state);
+    if (!map_renderer)
+        return;
+
+    // world units to tile pixels
+    constexpr float tile_density = 8;
+    const auto tile_size = std::min(1024, static_cast<int>(std::ceil(state->chunk_size * tile_density)));
+
+    for (size_t kk=0; kk<state->chunks.size(); kk++)
+    {
+        auto iter = tiles.find(kk);
+        if (!state->chunks[kk].loaded)
+        { // dropping a pending future does not wait for its task
+            if (iter != std::end(tiles))
+                tiles.erase(iter);
+            continue;
+        }
+
+        if (iter == std::end(tiles))
+        {
+            const auto bounds = state->chunkBounds(kk);
+            const auto renderer = map_renderer;
+            // the document spans the svg unit square, the tile is its top left corner and size in that square
+            const auto& view_box = map_view_box;
+            const auto left = bounds.lowerBound.x / polygons::world_scale + .5f;
+            const auto top = .25f - bounds.upperBound.y / polygons::world_scale;
+            const auto size = (bounds.upperBound.x - bounds.lowerBound.x) / polygons::world_scale;
+            const QRectF tile_view_box(view_box.x() + left * view_box.width(), view_box.y() + top * view_box.height(), size * view_box.width(), size * view_box.height());
+            tiles[kk].pending = tile_pool.submit([renderer, tile_view_box, tile_size]() -> QImage {
+                QImage image(tile_size, tile_size, QImage::Format_ARGB32_Premultiplied);
+                image.fill(Qt::transparent);
+                QPainter painter(&image);
+                // only the tile area is mapped onto the image, qt svg still walks the whole tree but clips everything else
+                renderer->setViewBox(tile_view_box);
+                renderer->render(&painter, QRectF(0, 0, tile_size, tile_size));
+                return image;
+            });
+            continue;
+        }
+
+        auto& tile = iter->second;
+        if (tile.pending.valid() && tile.pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            tile.image = tile.pending.get();
+    }
+}
+
+memory::Report GameWindowOpenGL::memoryReport()
+{
+    using std::get;
+
+    auto report = state ? state->memoryReport() : memory::Report();
+
+    { // gl buffers
+        size_t bytes = 0;
+        for (const auto& vbo : vbos)
+        {
+            GLint size = 0;
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            glGetBufferParameteriv(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
+            bytes += size;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        assertNoError();
+        report.emplace_back("gl buffers", vbos.size(), bytes);
+    }
+
+    { // textures, rgba with mipmaps
+        size_t count = 0;
+        size_t bytes = 0;
+        if (crate_texture)
+        {
+            count++;
+            for (auto level=0; level<crate_texture->mipLevels(); level++)
+                bytes += 4 * std::max(1, crate_texture->width() >> level) * std::max(1, crate_texture->height() >> level);
+        }
+        report.emplace_back("gl textures", count, bytes);
+    }
+
+    report.emplace_back("logo image", 1, logo.bytesPerLine() * logo.height());
+
+    { // streamed svg tiles
+        size_t bytes = 0;
+        for (const auto& pair : tiles)
+            bytes += pair.second.image.bytesPerLine() * pair.second.image.height();
+        report.emplace_back("svg tiles", tiles.size(), bytes);
+    }
+
+    if (loaded_level >= 0)
+    { // svg document size as a proxy for the renderer tree
+        assert(loaded_level < static_cast<int>(data.levels.size()));
+        const QFile handle(QString::fromStdString(data.levels[loaded_level].map_filename));
+        report.emplace_back("svg background", 1, handle.size());
+    }
+
+    return report;
+}
+
+memory::Derived GameWindowOpenGL::memoryDerived(const memory::Report& report) const
+{
+    using std::get;
+
+    memory::Derived derived;
+
+    if (state && state->system && state->system->GetParticleCount())
+    {
+        size_t particle_bytes = 0;
+        for (const auto& entry : report)
+            if (get<0>(entry).find("particle") == 0)
+                particle_bytes += get<2>(entry);
+        derived.emplace_back("bytes_per_particle", static_cast<float>(particle_bytes) / state->system->GetParticleCount());
+    }
+
+    derived.emplace_back("bytes_per_crate", GameState::crateBytes());
+
+    if (state)
+    { // measured b2Alloc usage
+        const auto& stats = state->arena.getStats();
+        derived.emplace_back("b2alloc_arena_bytes", stats.chunk_bytes);
+        derived.emplace_back("b2alloc_heap_bytes", stats.heap_live_bytes);
+    }
 
+    return derived;
 }
 
-void GameWindowOpenGL::loadBackground(const std::string& map_filename)
+void GameWindowOpenGL::dumpMemoryReport(const std::string& filename)
 {
-    auto& renderer = map_renderer;
-    const auto load_ok = renderer.load(QString::fromStdString(map_filename));
-    //qDebug() << "renderer" << renderer.isValid() << load_ok;
-    assert(renderer.isValid());
-    assert(load_ok);
+    using std::cout;
+    using std::endl;
+
+    makeCurrent();
+    const auto report = memoryReport();
+    doneCurrent();
+
+    std::ofstream handle(filename);
+    handle << memory::to_json(report, memoryDerived(report));
+
+    cout << "** memory report " << std::quoted(filename) << " " << memory::total_bytes(report) << " bytes" << endl;
 }
 
 void GameWindowOpenGL::setMuted(const bool muted)
@@ -238,34 +632,7 @@ void GameWindowOpenGL::initializePrograms()
         assertNoError();
     }
 
-    {
-        assert(!particle_program);
-        particle_program = loadAndCompileProgram(":/shaders/particle_vertex.glsl", ":/shaders/particle_fragment.glsl", ":/shaders/particle_geometry.glsl");
-
-        assert(particle_program);
-        const auto init_ok = initLocations(*particle_program, {
-                { "posAttr", particle_pos_attr },
-                { "colAttr", particle_col_attr },
-                { "speedAttr", particle_speed_attr },
-                { "flagAttr", particle_flag_attr },
-                }, {
-                { "waterColor", particle_water_color_unif },
-                { "foamColor", particle_foam_color_unif },
-                { "radius", particle_radius_unif },
-                { "radiusFactor", particle_radius_factor_unif },
-                { "mode", particle_mode_unif },
-                { "poly", particle_poly_unif },
-                { "maxSpeed", particle_max_speed_unif },
-                { "alpha", particle_alpha_unif },
-                { "viscousColor", particle_viscous_color_unif },
-                { "tensibleColor", particle_tensible_color_unif },
-                { "mixColor", particle_mix_unif },
-                { "cameraMatrix", particle_camera_mat_unif },
-                { "worldMatrix", particle_world_mat_unif },
-                });
-        assert(init_ok);
-        assertNoError();
-    }
+    particle_renderer.initialize();
 
     {
         assert(!crate_texture);
@@ -294,7 +661,7 @@ void GameWindowOpenGL::initializePrograms()
 
 void GameWindowOpenGL::initializeBuffers(BufferLoader& loader)
 {
-    loader.init(12);
+    loader.init(9);
 
     // ship
     loader.loadBuffer3(0, {
@@ -313,7 +680,7 @@ void GameWindowOpenGL::initializeBuffers(BufferLoader& loader)
             { 0, 0, 0, 1 },
             { 0, 0, 0, 1 },
             });
-    loader.loadIndices(11, { // ship indices
+    loader.loadIndices(8, { // ship indices
             0, 1, 2,
             4, 3, 5,
             0, 3, 1,
@@ -331,7 +698,7 @@ void GameWindowOpenGL::initializeBuffers(BufferLoader& loader)
             { -1, 1, 0 },
             { 1, 1, 0 },
             });
-    loader.loadBuffer4(10, { // morpheus den gradient colors
+    loader.loadBuffer4(7, { // morpheus den gradient colors
             { 0x30 / 255., 0xcf / 255., 0xd0 / 255., 1 },
             { 0x30 / 255., 0xcf / 255., 0xd0 / 255., 1 },
             { 0x33 / 255., 0x08 / 255., 0x67 / 255., 1 },
@@ -364,11 +731,36 @@ void GameWindowOpenGL::initializeBuffers(BufferLoader& loader)
             3, 7, 0, 4, 1, 5, 2, 6,
             });
 
-    // buffers 6, 7 & 8 are used by particle system
-    loader.reserve(6); // position
-    loader.reserve(7); // color
-    loader.reserve(8); // speed
-    loader.reserve(9); // flag
+    // particle positions, colors, speeds and flags are streamed every frame, sized for 10k particles
+    loader.initStream(6, 10000 * ParticleRenderer::particle_bytes);
+}
+
+ParticleRenderer::Shading GameWindowOpenGL::particleShading() const
+{
+    ParticleRenderer::Shading shading;
+    shading.mode = shader_selection;
+    shading.poly = poly_selection;
+    shading.radius_factor = radius_factor;
+    shading.max_speed = shading_max_speed;
+    shading.alpha = shading_alpha;
+    shading.mix_ratio = mix_ratio;
+    shading.water_color = water_color;
+    shading.foam_color = foam_color;
+    shading.viscous_color = viscous_color;
+    shading.tensible_color = tensible_color;
+    shading.viewport_width = width() * devicePixelRatio();
+    return shading;
+}
+
+// same table as bench_particles, with the current shading at the camera
+void GameWindowOpenGL::benchParticleBackends(const QMatrix4x4& camera_matrix)
+{
+    const auto& camera = use_world_camera ? world_camera : ship_camera;
+    const float radius = state && state->system ? state->system->GetRadius() : .5f;
+    const auto shading = particleShading();
+
+    particle_bench_rows = particle_renderer.bench(shading, camera_matrix, b2Vec2(camera.position[0], camera.position[1]), radius);
+    particle_renderer.printBench(particle_bench_rows, shading, width() * devicePixelRatio(), height() * devicePixelRatio());
 }
 
 void GameWindowOpenGL::drawOrigin(QPainter& painter) const
@@ -434,6 +826,13 @@ void GameWindowOpenGL::drawBody(QPainter& painter, const b2Body& body, const QCo
             {
                 painter.drawEllipse(QPointF(0, 0), circle->m_radius, circle->m_radius);
             }
+            if (const auto* chain = dynamic_cast<const b2ChainShape*>(shape))
+            {
+                QPolygonF poly_;
+                for (int kk=0; kk<chain->m_count; kk++)
+                    poly_ << QPointF(chain->m_vertices[kk].x, chain->m_vertices[kk].y);
+                painter.drawPolygon(poly_);
+            }
             //assert(shape);
             //qDebug() << shape->GetType();
             fixture = fixture->GetNext();
@@ -466,6 +865,50 @@ void GameWindowOpenGL::drawBody(QPainter& painter, const b2Body& body, const QCo
     }
 }
 
+void GameWindowOpenGL::drawSensors(QPainter& painter)
+{
+    assert(state);
+    assert(state->ship);
+
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<float, std::milli>;
+
+    constexpr int ray_count = 64;
+    constexpr float max_length = 100;
+
+    const auto& origin = state->ship->GetWorldCenter();
+    sensors::Rays rays;
+    for (auto kk=0; kk<ray_count; kk++)
+    {
+        const float angle = 2 * M_PI * kk / ray_count;
+        rays.emplace_back(origin, { std::cos(angle), std::sin(angle) }, max_length);
+    }
+
+    sensors::Hits hits;
+    const auto start = Clock::now();
+    state->castRays(rays, hits, true, std::thread::hardware_concurrency());
+    sensors_ms = Milliseconds(Clock::now() - start).count();
+
+    const std::array<QColor, 6> category_colors {
+        Qt::gray, // none
+        Qt::red, // ground
+        Qt::yellow, // door
+        QColor(0xff, 0x80, 0), // crate
+        Qt::cyan, // water
+        Qt::green, // object
+    };
+
+    painter.save();
+    painter.setBrush(Qt::NoBrush);
+    for (size_t kk=0; kk<rays.size(); kk++)
+    {
+        const auto end = rays.origins[kk] + hits.distances[kk] * rays.directions[kk];
+        painter.setPen(QPen(category_colors[hits.categories[kk]], 0));
+        painter.drawLine(QPointF(origin.x, origin.y), QPointF(end.x, end.y));
+    }
+    painter.restore();
+}
+
 void GameWindowOpenGL::drawShip(QPainter& painter)
 {
     assert(state);
@@ -592,6 +1035,9 @@ void GameWindowOpenGL::paintUI()
             ImGui::Combo(ss.str().c_str(), &current_level, level_names.data(), level_names.size());
             if (level_selection_prev != current_level)
                 resetLevel();
+
+            if (current_level >= 0 && (level_load_requested || pending_state.valid()))
+                ImGui::Text("loading %s...", data.levels[current_level].name.c_str());
         }
         ImGui::Separator();
 
@@ -600,6 +1046,7 @@ void GameWindowOpenGL::paintUI()
             assert(state);
 
             ImGui::SliderFloat("ship thrust", &state->ship_state.thrust_factor, .5, 10);
+            ImGui::SliderFloat("carve radius", &carve_radius, 1, 30);
 
             { // ship density
                 const auto& body = state->ship;
@@ -639,6 +1086,14 @@ void GameWindowOpenGL::paintUI()
         {
             const auto& io = ImGui::GetIO();
             ImGui::Text("%.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
+            ImGui::Text("level teardown %.2fms load %.2fms", level_teardown_ms, level_load_ms);
+            ImGui::Checkbox("arena allocator", &GameState::use_arena);
+            if (state)
+            {
+                const auto& stats = state->arena.getStats();
+                ImGui::Text("arena %zu/%zu allocs %.1fMiB chunks", stats.free_count, stats.alloc_count, stats.chunk_bytes / 1048576.f);
+                ImGui::Text("arena %zu heap allocs %.1fMiB live", stats.heap_alloc_count, stats.heap_live_bytes / 1048576.f);
+            }
             //ImGui::Text("left %d right %d", io.KeysDown[ImGuiKey_LeftArrow], io.KeysDown[ImGuiKey_RightArrow]);
         }
 
@@ -648,8 +1103,20 @@ void GameWindowOpenGL::paintUI()
             assert(state->ship);
             ImGui::Text("ship m=%.2f x=%.2f y=%.2f", state->ship->GetMass(), state->ship->GetPosition().x, state->ship->GetPosition().y);
             ImGui::Text("ball m=%.2f x=%.2f y=%.2f", state->ball->GetMass(), state->ball->GetPosition().x, state->ball->GetPosition().y);
-            if (state->system) ImGui::Text("particles %d %d(%d)", state->system->GetParticleGroupCount(), state->system->GetParticleCount(), state->system->GetStuckCandidateCount());
+            if (state->system) ImGui::Text("particles %d %d/%d(%d)", state->system->GetParticleGroupCount(), state->system->GetParticleCount(), state->system->GetMaxParticleCount(), state->system->GetStuckCandidateCount());
             ImGui::Text("crates %d", static_cast<int>(state->crates.size()));
+            {
+                const auto& touched = state->bots.touched_wall;
+                const auto crashed = std::count(std::cbegin(touched), std::cend(touched), true);
+                ImGui::Text("bots %d crashed %d step %.2fms", static_cast<int>(state->bots.size()), static_cast<int>(crashed), step_ms);
+                ImGui::Checkbox("bots wander", &bots_wander);
+            }
+            if (show_sensors)
+                ImGui::Text("sensors %.3fms", sensors_ms);
+            if (!state->chunks.empty())
+                ImGui::Text("chunks %d/%d loaded %d tiles", static_cast<int>(loaded_chunk_count), static_cast<int>(state->chunks.size()), static_cast<int>(tiles.size()));
+            ImGui::Text("ground %d pieces %d segments carve %.3fms", static_cast<int>(state->ground_pieces.size() - state->carved_piece_count), static_cast<int>(state->ground_segments.size()), carve_ms);
+            ImGui::Text("out of bounds %u particles %u crates", state->killed_particle_count, state->killed_crate_count);
 
             std::stringstream ss;
             for (unsigned int kk=0, kk_max=std::min(state->all_accum_contact, 10u); kk<kk_max; kk++)
@@ -670,6 +1137,34 @@ void GameWindowOpenGL::paintUI()
         end_left();
     }
 
+    if (show_memory)
+    { // memory window
+        using std::get;
+
+        begin_left("Memory");
+
+        // walking the world and querying gl buffers is too slow for every frame
+        if (ImGui::Button("refresh"))
+            memory_report_pending = true;
+        if (memory_report_pending)
+        {
+            memory_report = memoryReport();
+            memory_derived = memoryDerived(memory_report);
+            memory_rss = memory::resident_size();
+            memory_report_pending = false;
+        }
+
+        for (const auto& entry : memory_report)
+            ImGui::Text("%-32s %7zu %9.1fKiB", get<0>(entry).c_str(), get<1>(entry), get<2>(entry) / 1024.f);
+        ImGui::Separator();
+        for (const auto& value : memory_derived)
+            ImGui::Text("%-32s %9.1f", get<0>(value).c_str(), get<1>(value));
+        ImGui::Separator();
+        ImGui::Text("total %.1fMiB rss %.1fMiB", memory::total_bytes(memory_report) / 1048576.f, memory_rss / 1048576.f);
+
+        end_left();
+    }
+
     { // shading window
         begin_right("Shading");
 
@@ -685,12 +1180,12 @@ void GameWindowOpenGL::paintUI()
                 ImGui::SliderFloat("mix ratio", &mix_ratio, 0, 1);
 
                 {
-                    shader_selection %= IM_ARRAYSIZE(shader_names);
+                    shader_selection %= IM_ARRAYSIZE(ParticleRenderer::shader_names);
                     const std::string key_name = QKeySequence(shader_switch_key).toString().toStdString();
                     std::stringstream ss;
                     ss << "shader (" << key_name << ")";
-                    ImGui::Combo(ss.str().c_str(), &shader_selection, shader_names, IM_ARRAYSIZE(shader_names));
-                    shader_selection %= IM_ARRAYSIZE(shader_names);
+                    ImGui::Combo(ss.str().c_str(), &shader_selection, ParticleRenderer::shader_names, IM_ARRAYSIZE(ParticleRenderer::shader_names));
+                    shader_selection %= IM_ARRAYSIZE(ParticleRenderer::shader_names);
                 }
 
                 {
@@ -699,10 +1194,29 @@ void GameWindowOpenGL::paintUI()
                     ImGui::Combo("poly", &poly_selection, poly_names, IM_ARRAYSIZE(poly_names));
                 }
 
+                {
+                    particle_backend %= IM_ARRAYSIZE(ParticleRenderer::backend_names);
+                    ImGui::Combo("backend", &particle_backend, ParticleRenderer::backend_names, IM_ARRAYSIZE(ParticleRenderer::backend_names));
+                }
+
+                {
+                    const char* stream_mode_names[] = { "unsynchronized ring", "orphaning" };
+                    int stream_mode = static_cast<int>(stream_buffer.getMode());
+                    if (ImGui::Combo("upload", &stream_mode, stream_mode_names, IM_ARRAYSIZE(stream_mode_names)))
+                        stream_buffer.setMode(static_cast<StreamBuffer::Mode>(stream_mode));
+                    ImGui::Text("upload %.3fms wait %.3fms %.1fKiB/%.1fKiB", stream_buffer.upload_ms, stream_buffer.wait_ms, stream_buffer.used_bytes / 1024.f, stream_buffer.frame_bytes / 1024.f);
+                    ImGui::Text("%zu stalls %zu orphans %zu resizes", stream_buffer.stall_count, stream_buffer.orphan_count, stream_buffer.resize_count);
+                }
+
                 ImGui::SliderFloat("radius factor", &radius_factor, 0.0f, 1.0f);
                 ImGui::SliderFloat("alpha", &shading_alpha, -1, 1);
                 ImGui::SliderFloat("max speed", &shading_max_speed, 0, 100);
 
+                if (ImGui::Button("bench backends"))
+                    bench_particles_pending = true;
+                for (const auto& row : particle_bench_rows)
+                    ImGui::Text("%s %zu particles %.3fms upload %.3fms %zu stalls", ParticleRenderer::backend_names[std::get<0>(row)], std::get<1>(row), std::get<2>(row), std::get<3>(row), std::get<4>(row));
+
                 if (state && state->system)
                 {
                     ImGui::Separator();
@@ -784,6 +1298,21 @@ void GameWindowOpenGL::paintUI()
 
         ImGui::SliderFloat2("drop size", reinterpret_cast<float*>(&water_drop_size), 0, 20);
         ImGui::Checkbox("clean stuck in door", &state->clean_stuck_in_door);
+        ImGui::Checkbox("auto trim", &state->auto_trim_particles);
+        ImGui::SameLine();
+        if (ImGui::Button("trim buffers"))
+            state->trimParticleSystem();
+        if (state->trim_rss_before)
+            ImGui::Text("last trim rss %.1fMiB -> %.1fMiB", state->trim_rss_before / 1048576.f, state->trim_rss_after / 1048576.f);
+        ImGui::Checkbox("auto compact", &state->auto_compact_water);
+        ImGui::SameLine();
+        ImGui::Text("%u groups joined", state->compaction_join_count);
+        if (!state->emitters.empty())
+        {
+            ImGui::Checkbox("emitters", &state->emitters_enabled);
+            ImGui::SameLine();
+            ImGui::Text("%d streaming", static_cast<int>(state->emitters.size()));
+        }
 
         {
             ImGui::Separator();
@@ -817,6 +1346,8 @@ void GameWindowOpenGL::paintScene()
 {
     using std::get;
 
+    pollLevelLoad();
+
     {
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glEnable(GL_BLEND);
@@ -831,7 +1362,7 @@ void GameWindowOpenGL::paintScene()
                 glEnableVertexAttribArray(main_pos_attr);
                 assertNoError();
 
-                glBindBuffer(GL_ARRAY_BUFFER, vbos[10]);
+                glBindBuffer(GL_ARRAY_BUFFER, vbos[7]);
                 glVertexAttribPointer(main_col_attr, 4, GL_FLOAT, GL_FALSE, 0, 0);
                 glEnableVertexAttribArray(main_col_attr);
                 assertNoError();
@@ -891,8 +1422,25 @@ void GameWindowOpenGL::paintScene()
         state->ship_state.turning_right = io.KeysDown[ImGuiKey_RightArrow];
     }
 
+    if (bots_wander)
+        state->wanderBots(dt);
+
+    if (!state->chunks.empty())
+    { // chunks covering the ship camera view
+        const auto aspect_ratio = width() / static_cast<float>(height());
+        const auto radius = .5f * ship_camera.screen_height * std::sqrt(1 + aspect_ratio * aspect_ratio);
+        loaded_chunk_count = state->streamChunks(state->ship->GetWorldCenter(), radius);
+        updateTiles();
+    }
+
     if (!skip_state_step)
+    {
+        using Clock = std::chrono::steady_clock;
+        using Milliseconds = std::chrono::duration<float, std::milli>;
+        const auto start = Clock::now();
         state->step(dt);
+        step_ms = Milliseconds(Clock::now() - start).count();
+    }
 
     {
         assert(state);
@@ -918,7 +1466,32 @@ void GameWindowOpenGL::paintScene()
                 constexpr double scale = 600;
                 painter.save();
                 painter.scale(scale, scale);
-                map_renderer.render(&painter, QRectF(-.5, -.75, 1, -1));
+                if (map_renderer && state->chunks.empty())
+                    map_renderer->render(&painter, QRectF(-.5, -.75, 1, -1));
+                painter.restore();
+            }
+
+            for (const auto& pair : tiles)
+            { // top row first
+                const auto& image = pair.second.image;
+                if (image.isNull())
+                    continue;
+                const auto bounds = state->chunkBounds(pair.first);
+                const auto scale = state->chunk_size / image.width();
+                painter.save();
+                painter.translate(bounds.lowerBound.x, bounds.upperBound.y);
+                painter.scale(scale, -scale);
+                painter.drawImage(QPointF(0, 0), image);
+                painter.restore();
+            }
+
+            if (!craters.empty())
+            { // background color
+                painter.save();
+                painter.setBrush(QColor::fromRgbF(.8, .8, .8));
+                painter.setPen(Qt::NoPen);
+                for (const auto& crater : craters)
+                    painter.drawPolygon(crater);
                 painter.restore();
             }
 
@@ -933,6 +1506,9 @@ void GameWindowOpenGL::paintScene()
             for (auto& door : state->doors)
                 drawBody(painter, *std::get<0>(door), Qt::yellow);
 
+            if (show_sensors)
+                drawSensors(painter);
+
             //drawParticleSystem(painter, state->system);
 
             if (state->link)
@@ -975,86 +1551,29 @@ void GameWindowOpenGL::paintScene()
 
         const auto camera_matrix = camera.cameraMatrix(*this);
 
-        { // draw with particle program
-            ProgramBinder binder(*this, particle_program);
-
-            particle_program->setUniformValue(particle_camera_mat_unif, camera_matrix);
-
-            { // particle system
-                const auto& system = state->system;
-                assert(system);
-
-                const b2Vec2* positions = system->GetPositionBuffer();
-                const b2ParticleColor* colors = system->GetColorBuffer();
-                const b2Vec2* speeds = system->GetVelocityBuffer();
-
-                const auto kk_max = system->GetParticleCount();
-                std::vector<GLuint> flags(kk_max);
-                {
-                    static_assert(sizeof(GLuint) == sizeof(uint32), "mismatching size");
-                    const GLuint* flags_ = system->GetFlagsBuffer();
-                    std::copy(flags_, flags_ + kk_max, std::begin(flags));
-                    const auto candidates = system->GetStuckCandidates();
-                    for (auto ll=0, ll_max=system->GetStuckCandidateCount(); ll < ll_max; ll++)
-                        flags[candidates[ll]] |= 1 << 31;
-                }
-
-                const auto radius = system->GetRadius();
-
-                QMatrix4x4 world_matrix;
-                world_matrix.translate(0, 0, 0);
-
-                particle_program->setUniformValue(particle_radius_unif, radius);
-                particle_program->setUniformValue(particle_radius_factor_unif, radius_factor);
-                particle_program->setUniformValue(particle_mode_unif, shader_selection);
-                particle_program->setUniformValue(particle_poly_unif, poly_selection);
-                particle_program->setUniformValue(particle_max_speed_unif, shading_max_speed);
-                particle_program->setUniformValue(particle_alpha_unif, shading_alpha);
-
-                //            const auto& color = QColor::fromRgb(0x6cu, 0xc3u, 0xf6u, 0xffu);
-                particle_program->setUniformValue(particle_water_color_unif, QColor::fromRgbF(water_color[0], water_color[1], water_color[2], water_color[3]));
-                particle_program->setUniformValue(particle_foam_color_unif, QColor::fromRgbF(foam_color[0], foam_color[1], foam_color[2], foam_color[3]));
-                particle_program->setUniformValue(particle_viscous_color_unif, QColor::fromRgbF(viscous_color[0], viscous_color[1], viscous_color[2], viscous_color[3]));
-                particle_program->setUniformValue(particle_tensible_color_unif, QColor::fromRgbF(tensible_color[0], tensible_color[1], tensible_color[2], tensible_color[3]));
-                particle_program->setUniformValue(particle_mix_unif, mix_ratio);
-                particle_program->setUniformValue(particle_world_mat_unif, world_matrix);
-                assertNoError();
-
-                glBindBuffer(GL_ARRAY_BUFFER, vbos[6]);
-                glBufferData(GL_ARRAY_BUFFER, kk_max * 2 * sizeof(GLfloat), positions, GL_DYNAMIC_DRAW);
-                glVertexAttribPointer(particle_pos_attr, 2, GL_FLOAT, GL_FALSE, 0, 0);
-                glEnableVertexAttribArray(particle_pos_attr);
-                assertNoError();
-
-                static_assert(std::is_same<GLubyte, decltype(b2ParticleColor::r)>::value, "mismatching color types");
-
-                glBindBuffer(GL_ARRAY_BUFFER, vbos[7]);
-                glBufferData(GL_ARRAY_BUFFER, kk_max * 4 * sizeof(GLubyte), colors, GL_DYNAMIC_DRAW);
-                glVertexAttribPointer(particle_col_attr, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, 0);
-                glEnableVertexAttribArray(particle_col_attr);
-                assertNoError();
-
-                glBindBuffer(GL_ARRAY_BUFFER, vbos[8]);
-                glBufferData(GL_ARRAY_BUFFER, kk_max * 2 * sizeof(GLfloat), speeds, GL_DYNAMIC_DRAW);
-                glVertexAttribPointer(particle_speed_attr, 2, GL_FLOAT, GL_FALSE, 0, 0);
-                glEnableVertexAttribArray(particle_speed_attr);
-                assertNoError();
-
-                glBindBuffer(GL_ARRAY_BUFFER, vbos[9]);
-                glBufferData(GL_ARRAY_BUFFER, kk_max * sizeof(GLuint), flags.data(), GL_DYNAMIC_DRAW);
-                glVertexAttribIPointer(particle_flag_attr, 1, GL_UNSIGNED_INT, 0, 0);
-                glEnableVertexAttribArray(particle_flag_attr);
-                assertNoError();
+        if (bench_particles_pending)
+        {
+            bench_particles_pending = false;
+            benchParticleBackends(camera_matrix);
+        }
 
-                glDrawArrays(GL_POINTS, 0, kk_max);
-                assertNoError();
+        { // particle system
+            const auto& system = state->system;
+            assert(system);
 
-                glDisableVertexAttribArray(particle_flag_attr);
-                glDisableVertexAttribArray(particle_speed_attr);
-                glDisableVertexAttribArray(particle_col_attr);
-                glDisableVertexAttribArray(particle_pos_attr);
-                assertNoError();
+            const auto kk_max = system->GetParticleCount();
+            std::vector<GLuint> flags(kk_max);
+            {
+                static_assert(sizeof(GLuint) == sizeof(uint32), "mismatching size");
+                const GLuint* flags_ = system->GetFlagsBuffer();
+                std::copy(flags_, flags_ + kk_max, std::begin(flags));
+                const auto candidates = system->GetStuckCandidates();
+                for (auto ll=0, ll_max=system->GetStuckCandidateCount(); ll < ll_max; ll++)
+                    flags[candidates[ll]] |= 1 << 31;
             }
+
+            particle_renderer.draw(static_cast<ParticleBackend>(particle_backend), particleShading(), camera_matrix, system->GetRadius(),
+                system->GetPositionBuffer(), system->GetColorBuffer(), system->GetVelocityBuffer(), flags.data(), kk_max);
         }
 
         //glClear(GL_DEPTH_BUFFER_BIT);
@@ -1097,7 +1616,7 @@ void GameWindowOpenGL::paintScene()
 
             const auto blit_ship = [this]() -> void
             {
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbos[11]);
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vbos[8]);
                 assertNoError();
 
                 glBindBuffer(GL_ARRAY_BUFFER, vbos[0]);
@@ -1188,6 +1707,17 @@ void GameWindowOpenGL::paintScene()
                     blit_wing();
                 }
             }
+
+            for (const auto& bot : state->bots.ships)
+            { // bot ships, hull only
+                QMatrix4x4 world_matrix;
+                const auto& pos = bot->GetPosition();
+                world_matrix.translate(pos.x, pos.y);
+                world_matrix.rotate(180. * bot->GetAngle() / M_PI, 0, 0, 1);
+                world_matrix.scale(GameState::ship_scale, GameState::ship_scale, GameState::ship_scale);
+                main_program->setUniformValue(main_world_mat_unif, world_matrix);
+                blit_ship();
+            }
         }
 
         { // draw with crate program
@@ -1274,6 +1804,18 @@ void GameWindowOpenGL::paintScene()
 
                 blit_square();
             }
+
+            for (const auto& ball : state->bots.balls)
+            { // bot balls
+                QMatrix4x4 world_matrix;
+                const auto& pos = ball->GetWorldCenter();
+                world_matrix.translate(pos.x, pos.y);
+                world_matrix.rotate(qRadiansToDegrees(ball->GetAngle()), 0, 0, 1);
+                world_matrix.scale(GameState::ball_scale, GameState::ball_scale, GameState::ball_scale);
+                ball_program->setUniformValue(ball_world_mat_unif, world_matrix);
+                ball_program->setUniformValue(ball_angular_speed_unif, ball->GetAngularVelocity());
+                blit_square();
+            }
         }
 
         if (state && state->canGrab())
@@ -1343,18 +1885,18 @@ void GameWindowOpenGL::keyPressEvent(QKeyEvent* event)
 {
     if (event->key() == shader_switch_key)
     {
-        assert(IM_ARRAYSIZE(shader_names) > 0);
+        assert(IM_ARRAYSIZE(ParticleRenderer::shader_names) > 0);
         const auto modifiers = event->modifiers();
         if (modifiers == Qt::ShiftModifier)
         {
-            shader_selection += IM_ARRAYSIZE(shader_names) - 1;
-            shader_selection %= IM_ARRAYSIZE(shader_names);
+            shader_selection += IM_ARRAYSIZE(ParticleRenderer::shader_names) - 1;
+            shader_selection %= IM_ARRAYSIZE(ParticleRenderer::shader_names);
             return;
         }
         if (modifiers == Qt::NoModifier)
         {
             shader_selection++;
-            shader_selection %= IM_ARRAYSIZE(shader_names);
+            shader_selection %= IM_ARRAYSIZE(ParticleRenderer::shader_names);
             return;
         }
     }
@@ -1394,6 +1936,25 @@ void GameWindowOpenGL::keyPressEvent(QKeyEvent* event)
             }
     }
 
+    if (event->key() == carve_key && state)
+    { // crater ahead of the ship
+        using Clock = std::chrono::steady_clock;
+        using Milliseconds = std::chrono::duration<float, std::milli>;
+
+        assert(state->ship);
+        const auto center = state->ship->GetWorldPoint({ 0, carve_radius + 2 });
+        const auto start = Clock::now();
+        const auto carve = polygons::circle_polygon(center, carve_radius, 16);
+        state->carveGround(carve);
+        carve_ms = Milliseconds(Clock::now() - start).count();
+
+        QPolygonF crater;
+        for (const auto& point : carve)
+            crater << QPointF(point.x, point.y);
+        craters.emplace_back(crater);
+        return;
+    }
+
     if (event->key() == Qt::Key_Space)
     {
         assert(state);
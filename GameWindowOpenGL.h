@@ -1,16 +1,26 @@
 #pragma once
 
 #include "load_levels.h"
+#include "level_pack.h"
 #include "GameState.h"
 #include "Camera.h"
 #include "RasterWindowOpenGL.h"
+#include "ParticleRenderer.h"
+#include "memory_usage.h"
+#include "ThreadPool.h"
 
 #include <QOpenGLPaintDevice>
 #include <QSoundEffect>
 #include <QSvgRenderer>
 #include <QOpenGLTexture>
+#include <QFileSystemWatcher>
+#include <QTimer>
 
 #include <random>
+#include <future>
+#include <map>
+#include <chrono>
+#include <set>
 
 class GameWindowOpenGL : public RasterWindowOpenGL
 {
@@ -18,8 +28,15 @@ class GameWindowOpenGL : public RasterWindowOpenGL
     public:
         GameWindowOpenGL(QWindow* parent = nullptr);
         void setMuted(const bool muted);
-        void loadBackground(const std::string& map_filename);
         void resetLevel();
+        memory::Report memoryReport();
+        memory::Derived memoryDerived(const memory::Report& report) const;
+        void dumpMemoryReport(const std::string& filename);
+        // reloads levels.json and the svg maps from levels_dir whenever they are saved, the baked pack is ignored,
+        // call before the window is shown
+        void watchLevels(const std::string& levels_dir);
+
+        using ParticleBackend = ParticleRenderer::Backend;
 
     protected:
         void keyPressEvent(QKeyEvent* event) override;
@@ -28,6 +45,25 @@ class GameWindowOpenGL : public RasterWindowOpenGL
         void drawBody(QPainter& painter, const b2Body& body, const QColor& color = Qt::black) const;
         void drawParticleSystem(QPainter& painter, const b2ParticleSystem& system, const QColor& color = Qt::black) const;
         void drawShip(QPainter& painter);
+        void drawSensors(QPainter& painter);
+
+        struct LevelAssets
+        {
+            polygons::Ground ground;
+            std::shared_ptr<QSvgRenderer> renderer;
+            QRectF view_box; // as loaded, tiles move the renderer one
+        };
+        using SharedAssets = std::shared_future<std::shared_ptr<const LevelAssets>>;
+
+        SharedAssets prefetchAssets(const int index);
+        std::unique_ptr<GameState> buildState(const int index, const SharedAssets& assets) const;
+        void pollLevelLoad();
+        void waitLevelLoads();
+        void reloadLevels();
+        void reloadMap(const std::string& map_filename);
+        void updateTiles();
+        ParticleRenderer::Shading particleShading() const;
+        void benchParticleBackends(const QMatrix4x4& camera_matrix);
 
         void initializeUI() override;
         void initializeBuffers(BufferLoader& loader) override;
@@ -37,6 +73,7 @@ class GameWindowOpenGL : public RasterWindowOpenGL
 
     public:
         levels::MainData data;
+        levels::PackFile pack;
         std::unique_ptr<GameState> state = nullptr;
         std::default_random_engine flame_rng;
         std::array<float, 4> water_color = { 108 / 255., 195 / 255., 246 / 255., 1 };
@@ -49,16 +86,35 @@ class GameWindowOpenGL : public RasterWindowOpenGL
         int crate_max_tag = 10;
         float mix_ratio = .2;
         bool draw_debug = false;
+        bool show_memory = false;
+        bool memory_report_pending = true; // the memory window shows the report computed when it was opened or refreshed
+        memory::Report memory_report;
+        memory::Derived memory_derived;
+        size_t memory_rss = 0;
+        bool show_sensors = false;
+        float sensors_ms = 0;
         int shader_selection = 8;
         int poly_selection = 3;
+        int particle_backend = static_cast<int>(ParticleBackend::geometry_shader);
+        bool bench_particles_pending = false;
+        std::vector<ParticleRenderer::BenchRow> particle_bench_rows;
         float radius_factor = 1;
         int current_level = -1;
+        int loaded_level = -1;
         float shading_max_speed = 60;
         float shading_alpha = -.65;
         unsigned int water_flags = b2_viscousParticle | b2_tensileParticle;
         bool skip_state_step = false;
         bool use_painter = true;
         float world_time = 0;
+        float level_load_ms = 0;
+        float level_teardown_ms = 0;
+        float step_ms = 0;
+        bool bots_wander = true;
+        float carve_radius = 6;
+        float carve_ms = 0;
+        std::vector<QPolygonF> craters; // painted over the svg, which still shows carved ground
+        size_t loaded_chunk_count = 0;
 
         bool use_world_camera = false;
         Camera ship_camera;
@@ -78,7 +134,28 @@ class GameWindowOpenGL : public RasterWindowOpenGL
         QImage logo;
         //QSoundEffect back_click_sfx;
 
-        QSvgRenderer map_renderer;
+        // declared after pack and data, in flight tasks read them until these are destroyed
+        polygons::GroundCache ground_cache;
+        std::string levels_dir;
+        QFileSystemWatcher level_watcher;
+        QTimer reload_timer; // editors write files in several steps, changes are collected before reloading
+        std::set<std::string> changed_files;
+        std::shared_ptr<QSvgRenderer> map_renderer;
+        QRectF map_view_box;
+
+        // svg rendered per loaded chunk when the level streams, the single worker is the only renderer user
+        struct Tile
+        {
+            std::future<QImage> pending;
+            QImage image;
+        };
+        std::map<size_t, Tile> tiles;
+        ThreadPool tile_pool { 1 };
+        std::map<int, SharedAssets> prefetched_assets;
+        std::future<std::unique_ptr<GameState>> pending_state;
+        int pending_level = -1;
+        bool level_load_requested = false;
+        std::chrono::steady_clock::time_point level_request_time;
 
         bool is_muted = false;
 
@@ -107,24 +184,7 @@ class GameWindowOpenGL : public RasterWindowOpenGL
         int grab_camera_mat_unif = -1;
         int grab_world_mat_unif = -1;
 
-        std::unique_ptr<QOpenGLShaderProgram> particle_program = nullptr;
-        int particle_pos_attr = -1;
-        int particle_col_attr = -1;
-        int particle_speed_attr = -1;
-        int particle_flag_attr = -1;
-        int particle_water_color_unif = -1;
-        int particle_foam_color_unif = -1;
-        int particle_radius_unif = -1;
-        int particle_radius_factor_unif = -1;
-        int particle_mode_unif = -1;
-        int particle_poly_unif = -1;
-        int particle_max_speed_unif = -1;
-        int particle_alpha_unif = -1;
-        int particle_viscous_color_unif = -1;
-        int particle_tensible_color_unif = -1;
-        int particle_mix_unif = -1;
-        int particle_camera_mat_unif = -1;
-        int particle_world_mat_unif = -1;
+        ParticleRenderer particle_renderer { stream_buffer };
 
         std::unique_ptr<QOpenGLShaderProgram> crate_program = nullptr;
         int crate_pos_attr = -1;
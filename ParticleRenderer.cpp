@@ -0,0 +1,266 @@
+#include "ParticleRenderer.h"
+#include "gl_utils.h"
+
+#include <QColor>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <type_traits>
+#include <cassert>
+
+const char* const ParticleRenderer::backend_names[3] = { "geometry shader", "instanced quads", "point sprites" };
+const char* const ParticleRenderer::shader_names[9] = { "out group + dot speed", "out speed + dot flag", "out flag + dot speed", "out flag + dot group", "dot group", "dot uniform", "dot stuck", "dot flag", "dot speed" };
+constexpr size_t ParticleRenderer::particle_bytes;
+
+const GLint poly_firsts[] = { 0, 8, 14, 18 }; // in the corner buffer
+const GLsizei poly_counts[] = { 8, 6, 4, 3 };
+
+ParticleRenderer::ParticleRenderer(StreamBuffer& stream_buffer_)
+    : stream_buffer(stream_buffer_)
+{
+}
+
+void ParticleRenderer::initialize()
+{
+    initializeOpenGLFunctions();
+
+    for (const auto backend : { Backend::geometry_shader, Backend::instanced_quads, Backend::point_sprites })
+    {
+        auto& particle = programs[static_cast<size_t>(backend)];
+        assert(!particle.program);
+        switch (backend)
+        {
+            case Backend::geometry_shader:
+                particle.program = gl_utils::load_program(":/shaders/particle_vertex.glsl", ":/shaders/particle_fragment.glsl", ":/shaders/particle_geometry.glsl");
+                break;
+            case Backend::instanced_quads:
+                particle.program = gl_utils::load_program(":/shaders/particle_instanced_vertex.glsl", ":/shaders/particle_fragment.glsl");
+                break;
+            case Backend::point_sprites:
+                particle.program = gl_utils::load_program(":/shaders/particle_points_vertex.glsl", ":/shaders/particle_fragment.glsl", "", { "POINT_SPRITES" });
+                break;
+        }
+
+        assert(particle.program);
+        gl_utils::Locations attr_locations {
+                { "posAttr", particle.pos_attr },
+                { "colAttr", particle.col_attr },
+                { "speedAttr", particle.speed_attr },
+                { "flagAttr", particle.flag_attr },
+                };
+        gl_utils::Locations unif_locations {
+                { "waterColor", particle.water_color_unif },
+                { "foamColor", particle.foam_color_unif },
+                { "radius", particle.radius_unif },
+                { "radiusFactor", particle.radius_factor_unif },
+                { "mode", particle.mode_unif },
+                { "maxSpeed", particle.max_speed_unif },
+                { "alpha", particle.alpha_unif },
+                { "viscousColor", particle.viscous_color_unif },
+                { "tensibleColor", particle.tensible_color_unif },
+                { "mixColor", particle.mix_unif },
+                { "cameraMatrix", particle.camera_mat_unif },
+                { "worldMatrix", particle.world_mat_unif },
+                };
+        if (backend == Backend::geometry_shader)
+            unif_locations.emplace("poly", particle.poly_unif);
+        if (backend == Backend::instanced_quads)
+            attr_locations.emplace("cornerAttr", particle.corner_attr);
+        if (backend == Backend::point_sprites)
+            unif_locations.emplace("viewportWidth", particle.viewport_width_unif);
+        const auto init_ok = gl_utils::init_locations(*particle.program, attr_locations, unif_locations);
+        assert(init_ok);
+        gl_utils::assert_no_error(*this);
+    }
+
+    // the attribute pointers into the stream buffer are state of this vao
+    assert(!vao);
+    glGenVertexArrays(1, &vao);
+
+    const GLfloat third = 1 / 3.f;
+    const GLfloat sqrt3 = std::sqrt(3.f);
+    const std::vector<std::array<GLfloat, 2>> corners {
+            { -third, -1 }, { third, -1 }, { -1, -third }, { 1, -third }, { -1, third }, { 1, third }, { -third, 1 }, { third, 1 }, // octogon
+            { -.5, -sqrt3 / 2 }, { .5, -sqrt3 / 2 }, { -1, 0 }, { 1, 0 }, { -.5, sqrt3 / 2 }, { .5, sqrt3 / 2 }, // hexagon
+            { -1, -1 }, { 1, -1 }, { -1, 1 }, { 1, 1 }, // square
+            { -3, -sqrt3 }, { 3, -sqrt3 }, { 0, 2 * sqrt3 }, // triangle
+            };
+    assert(!corner_buffer);
+    glGenBuffers(1, &corner_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, corner_buffer);
+    glBufferData(GL_ARRAY_BUFFER, corners.size() * 2 * sizeof(GLfloat), corners.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    gl_utils::assert_no_error(*this);
+}
+
+void ParticleRenderer::draw(const Backend backend, const Shading& shading, const QMatrix4x4& camera_matrix, const float radius,
+    const b2Vec2* positions, const b2ParticleColor* colors, const b2Vec2* speeds, const GLuint* flags, const size_t count)
+{
+    auto& particle = programs[static_cast<size_t>(backend)];
+    assert(particle.program);
+    auto& program = *particle.program;
+    program.bind();
+    glBindVertexArray(vao);
+
+    QMatrix4x4 world_matrix;
+    world_matrix.translate(0, 0, 0);
+
+    const auto to_color = [](const std::array<float, 4>& color) -> QColor { return QColor::fromRgbF(color[0], color[1], color[2], color[3]); };
+    program.setUniformValue(particle.camera_mat_unif, camera_matrix);
+    program.setUniformValue(particle.world_mat_unif, world_matrix);
+    program.setUniformValue(particle.radius_unif, radius);
+    program.setUniformValue(particle.radius_factor_unif, shading.radius_factor);
+    program.setUniformValue(particle.mode_unif, shading.mode);
+    program.setUniformValue(particle.max_speed_unif, shading.max_speed);
+    program.setUniformValue(particle.alpha_unif, shading.alpha);
+    program.setUniformValue(particle.water_color_unif, to_color(shading.water_color));
+    program.setUniformValue(particle.foam_color_unif, to_color(shading.foam_color));
+    program.setUniformValue(particle.viscous_color_unif, to_color(shading.viscous_color));
+    program.setUniformValue(particle.tensible_color_unif, to_color(shading.tensible_color));
+    program.setUniformValue(particle.mix_unif, shading.mix_ratio);
+    if (backend == Backend::geometry_shader)
+        program.setUniformValue(particle.poly_unif, shading.poly);
+    if (backend == Backend::point_sprites)
+        program.setUniformValue(particle.viewport_width_unif, static_cast<GLfloat>(shading.viewport_width));
+    gl_utils::assert_no_error(*this);
+
+    // instanced quads advance per particle attributes once per instance, the divisors are vao state
+    const GLuint divisor = backend == Backend::instanced_quads ? 1 : 0;
+
+    static_assert(std::is_same<GLubyte, decltype(b2ParticleColor::r)>::value, "mismatching color types");
+    const auto position_bytes = count * 2 * sizeof(GLfloat);
+    const auto color_bytes = count * 4 * sizeof(GLubyte);
+    const auto speed_bytes = count * 2 * sizeof(GLfloat);
+    const auto flag_bytes = count * sizeof(GLuint);
+    stream_buffer.reserve(position_bytes + color_bytes + speed_bytes + flag_bytes);
+
+    const auto position_offset = stream_buffer.push(positions, position_bytes);
+    glVertexAttribPointer(particle.pos_attr, 2, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<const void*>(position_offset));
+    glVertexAttribDivisor(particle.pos_attr, divisor);
+    glEnableVertexAttribArray(particle.pos_attr);
+    gl_utils::assert_no_error(*this);
+
+    const auto color_offset = stream_buffer.push(colors, color_bytes);
+    glVertexAttribPointer(particle.col_attr, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, reinterpret_cast<const void*>(color_offset));
+    glVertexAttribDivisor(particle.col_attr, divisor);
+    glEnableVertexAttribArray(particle.col_attr);
+    gl_utils::assert_no_error(*this);
+
+    const auto speed_offset = stream_buffer.push(speeds, speed_bytes);
+    glVertexAttribPointer(particle.speed_attr, 2, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<const void*>(speed_offset));
+    glVertexAttribDivisor(particle.speed_attr, divisor);
+    glEnableVertexAttribArray(particle.speed_attr);
+    gl_utils::assert_no_error(*this);
+
+    const auto flag_offset = stream_buffer.push(flags, flag_bytes);
+    glVertexAttribIPointer(particle.flag_attr, 1, GL_UNSIGNED_INT, 0, reinterpret_cast<const void*>(flag_offset));
+    glVertexAttribDivisor(particle.flag_attr, divisor);
+    glEnableVertexAttribArray(particle.flag_attr);
+    gl_utils::assert_no_error(*this);
+
+    switch (backend)
+    {
+        case Backend::geometry_shader:
+            glDrawArrays(GL_POINTS, 0, count);
+            break;
+        case Backend::instanced_quads:
+        {
+            const auto poly = shading.poly % (sizeof(poly_counts) / sizeof(poly_counts[0]));
+            glBindBuffer(GL_ARRAY_BUFFER, corner_buffer);
+            glVertexAttribPointer(particle.corner_attr, 2, GL_FLOAT, GL_FALSE, 0, 0);
+            glEnableVertexAttribArray(particle.corner_attr);
+            glDrawArraysInstanced(GL_TRIANGLE_STRIP, poly_firsts[poly], poly_counts[poly], count);
+            glDisableVertexAttribArray(particle.corner_attr);
+            break;
+        }
+        case Backend::point_sprites:
+            glEnable(GL_PROGRAM_POINT_SIZE);
+            glDrawArrays(GL_POINTS, 0, count);
+            glDisable(GL_PROGRAM_POINT_SIZE);
+            break;
+    }
+    gl_utils::assert_no_error(*this);
+
+    for (const auto attr : { particle.flag_attr, particle.speed_attr, particle.col_attr, particle.pos_attr })
+    {
+        glVertexAttribDivisor(attr, 0);
+        glDisableVertexAttribArray(attr);
+    }
+
+    glBindVertexArray(0);
+    program.release();
+    gl_utils::assert_no_error(*this);
+}
+
+std::vector<ParticleRenderer::BenchRow> ParticleRenderer::bench(const Shading& shading, const QMatrix4x4& camera_matrix, const b2Vec2& center, const float radius)
+{
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    constexpr int repeats = 10;
+
+    // overlapping draws would fail the depth test
+    const auto depth_test = glIsEnabled(GL_DEPTH_TEST);
+    glDisable(GL_DEPTH_TEST);
+
+    std::vector<BenchRow> rows;
+    for (const size_t count : { 1000, 10000, 100000 })
+    {
+        const auto side = static_cast<size_t>(std::ceil(std::sqrt(count)));
+        std::vector<b2Vec2> positions;
+        std::vector<b2ParticleColor> colors;
+        std::vector<b2Vec2> speeds;
+        std::vector<GLuint> flags;
+        for (size_t kk=0; kk<count; kk++)
+        {
+            positions.emplace_back(center.x + 2 * radius * (kk % side - side / 2.f), center.y + 2 * radius * (kk / side - side / 2.f));
+            colors.emplace_back(kk % 256, 128, 255 - kk % 256, 255);
+            speeds.emplace_back(kk % 61, 0);
+            flags.emplace_back(kk % 3 == 0 ? b2_viscousParticle : kk % 3 == 1 ? b2_tensileParticle : b2_viscousParticle | b2_tensileParticle);
+        }
+
+        for (int backend=0; backend<static_cast<int>(programs.size()); backend++)
+        {
+            // like one particle pass per frame in game
+            double upload_ms = 0;
+            const auto draw_ = [&]() -> void
+            {
+                stream_buffer.endFrame();
+                stream_buffer.beginFrame();
+                draw(static_cast<Backend>(backend), shading, camera_matrix, radius, positions.data(), colors.data(), speeds.data(), flags.data(), count);
+                upload_ms += stream_buffer.upload_ms;
+            };
+
+            draw_();
+            glFinish();
+            upload_ms = 0;
+            const auto stall_count = stream_buffer.stall_count;
+            const auto start = Clock::now();
+            for (auto repeat=0; repeat<repeats; repeat++)
+                draw_();
+            glFinish();
+            rows.emplace_back(backend, count, Milliseconds(Clock::now() - start).count() / repeats, upload_ms / repeats, stream_buffer.stall_count - stall_count);
+        }
+    }
+
+    if (depth_test)
+        glEnable(GL_DEPTH_TEST);
+
+    return rows;
+}
+
+void ParticleRenderer::printBench(const std::vector<BenchRow>& rows, const Shading& shading, const int width, const int height) const
+{
+    using std::cout;
+    using std::endl;
+    using std::get;
+    using std::setw;
+
+    cout << "========== particle backends " << shader_names[shading.mode] << " " << (stream_buffer.getMode() == StreamBuffer::Mode::orphaning ? "orphaning" : "unsynchronized") << " " << width << "x" << height << endl;
+    cout << std::fixed << std::setprecision(3);
+    cout << setw(18) << "backend" << setw(11) << "particles" << setw(10) << "ms" << setw(11) << "upload ms" << setw(8) << "stalls" << endl;
+    for (const auto& row : rows)
+        cout << setw(18) << backend_names[get<0>(row)] << setw(11) << get<1>(row) << setw(10) << get<2>(row) << setw(11) << get<3>(row) << setw(8) << get<4>(row) << endl;
+}
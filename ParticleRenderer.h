@@ -0,0 +1,91 @@
+#pragma once
+
+#include "StreamBuffer.h"
+
+#include "Box2D/Common/b2Math.h"
+#include "Box2D/Particle/b2Particle.h"
+
+#include <QOpenGLExtraFunctions>
+#include <QOpenGLShaderProgram>
+#include <QMatrix4x4>
+
+#include <array>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+// particle draws shared by the game window and bench_particles, every backend is shaded by particle_fragment.glsl.
+// needs a current 3.3 core context, vertex data goes through the given stream buffer between its begin and end frame
+class ParticleRenderer : protected QOpenGLExtraFunctions
+{
+    public:
+        enum class Backend
+        {
+            geometry_shader, // points expanded by particle_geometry.glsl
+            instanced_quads, // polygons from a static corner buffer, one instance per particle
+            point_sprites, // squares rasterized from GL_POINTS
+        };
+
+        static const char* const backend_names[3];
+        static const char* const shader_names[9];
+        static constexpr size_t particle_bytes = 2 * sizeof(GLfloat) + 4 * sizeof(GLubyte) + 2 * sizeof(GLfloat) + sizeof(GLuint); // streamed per particle
+
+        struct Shading
+        {
+            int mode = 8; // in shader_names
+            int poly = 3; // octogon, hexagon, square, triangle
+            float radius_factor = 1;
+            float max_speed = 60;
+            float alpha = -.65;
+            float mix_ratio = .2;
+            std::array<float, 4> water_color = { 108 / 255., 195 / 255., 246 / 255., 1 };
+            std::array<float, 4> foam_color = { 1, 1, 1, 1 };
+            std::array<float, 4> viscous_color = { 1, 0, 1, 1 };
+            std::array<float, 4> tensible_color = { 0, 1, 1, 1 };
+            float viewport_width = 1; // pixels, point sprites
+        };
+
+        using BenchRow = std::tuple<int, size_t, double, double, size_t>; // backend, particles, ms per draw, upload ms per draw, stalls
+
+        ParticleRenderer(StreamBuffer& stream_buffer);
+
+        void initialize(); // compiles the programs and loads the corner buffer
+        void draw(const Backend backend, const Shading& shading, const QMatrix4x4& camera_matrix, const float radius,
+            const b2Vec2* positions, const b2ParticleColor* colors, const b2Vec2* speeds, const GLuint* flags, const size_t count);
+
+        // draws square blocks of 1k, 10k and 100k synthetic particles around center with every backend,
+        // each draw is a stream buffer frame of its own and glFinish brackets them so that timings cover uploads and rasterization
+        std::vector<BenchRow> bench(const Shading& shading, const QMatrix4x4& camera_matrix, const b2Vec2& center, const float radius);
+        void printBench(const std::vector<BenchRow>& rows, const Shading& shading, const int width, const int height) const;
+
+    protected:
+        // locations unused by a backend stay at -1
+        struct Program
+        {
+            std::unique_ptr<QOpenGLShaderProgram> program = nullptr;
+            int pos_attr = -1;
+            int col_attr = -1;
+            int speed_attr = -1;
+            int flag_attr = -1;
+            int corner_attr = -1; // instanced quads
+            int water_color_unif = -1;
+            int foam_color_unif = -1;
+            int radius_unif = -1;
+            int radius_factor_unif = -1;
+            int mode_unif = -1;
+            int poly_unif = -1; // geometry shader
+            int max_speed_unif = -1;
+            int alpha_unif = -1;
+            int viscous_color_unif = -1;
+            int tensible_color_unif = -1;
+            int mix_unif = -1;
+            int camera_mat_unif = -1;
+            int world_mat_unif = -1;
+            int viewport_width_unif = -1; // point sprites
+        };
+
+        StreamBuffer& stream_buffer;
+        std::array<Program, 3> programs;
+        GLuint vao = 0;
+        GLuint corner_buffer = 0; // polygons of particle_geometry.glsl in particle radii, triangle strips
+};
@@ -1,4 +1,5 @@
 #include "RasterWindowOpenGL.h"
+#include "gl_utils.h"
 
 #include <QKeyEvent>
 
@@ -9,58 +10,17 @@
 #include <unordered_set>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 RasterWindowOpenGL::RasterWindowOpenGL(QWindow* parent)
-    : QOpenGLWindow(QOpenGLWindow::NoPartialUpdate, parent)
+    : QOpenGLWindow(QOpenGLWindow::NoPartialUpdate, parent), stream_buffer(*this)
 {
     registerFreeKey(Qt::Key_A);
 }
 
 void RasterWindowOpenGL::assertNoError()
 {
-#if !defined(NDEBUG)
-    const auto gl_error = glGetError();
-
-    using std::cerr;
-    using std::endl;
-
-    switch (gl_error)
-    {
-        default:
-        case GL_NO_ERROR:
-            break;
-        case GL_INVALID_ENUM:
-            cerr << "GL_INVALID_ENUM" << endl;
-            cerr << "An unacceptable value is specified for an enumerated argument. The offending command is ignored and has no other side effect than to set the error flag." << endl;
-            break;
-        case GL_INVALID_VALUE:
-            cerr << "GL_INVALID_VALUE" << endl;
-            cerr << "A numeric argument is out of range. The offending command is ignored and has no other side effect than to set the error flag." << endl;
-            break;
-        case GL_INVALID_OPERATION:
-            cerr << "GL_INVALID_OPERATION" << endl;
-            cerr << "The specified operation is not allowed in the current state. The offending command is ignored and has no other side effect than to set the error flag." << endl;
-            break;
-        case GL_INVALID_FRAMEBUFFER_OPERATION:
-            cerr << "GL_INVALID_FRAMEBUFFER_OPERATION" << endl;
-            cerr << "The framebuffer object is not complete. The offending command is ignored and has no other side effect than to set the error flag." << endl;
-            break;
-        case GL_OUT_OF_MEMORY:
-            cerr << "GL_OUT_OF_MEMORY" << endl;
-            cerr << "There is not enough memory left to execute the command. The state of the GL is undefined, except for the state of the error flags, after this error is recorded." << endl;
-            break;
-        case GL_STACK_UNDERFLOW:
-            cerr << "GL_STACK_UNDERFLOW" << endl;
-            cerr << "An attempt has been made to perform an operation that would cause an internal stack to underflow." << endl;
-            break;
-        case GL_STACK_OVERFLOW:
-            cerr << "GL_STACK_OVERFLOW" << endl;
-            cerr << "An attempt has been made to perform an operation that would cause an internal stack to overflow." << endl;
-            break;
-    }
-#endif
-
-    assert(gl_error == GL_NO_ERROR);
+    gl_utils::assert_no_error(*this);
 }
 
 void RasterWindowOpenGL::setAnimated(const bool value)
@@ -251,102 +211,24 @@ void RasterWindowOpenGL::BufferLoader::loadIndices(const size_t kk, const std::v
     view.assertNoError();
 }
 
-std::unique_ptr<QOpenGLShaderProgram> RasterWindowOpenGL::loadAndCompileProgram(const std::string& vertex_filename, const std::string& fragment_filename, const std::string& geometry_filename)
+void RasterWindowOpenGL::BufferLoader::initStream(const size_t kk, const size_t frame_bytes)
 {
-    using std::cerr;
-    using std::cout;
-    using std::endl;
-
-    cout << "========== compile shader" << endl;
-    auto program = std::make_unique<QOpenGLShaderProgram>();
+    reserve(kk);
+    view.glBindVertexArray(vao);
+    view.stream_buffer.init(vbos[kk], frame_bytes);
+    view.glBindVertexArray(0);
+    view.assertNoError();
+}
 
-    const auto load_shader = [&program](const QOpenGLShader::ShaderType type, const std::string& filename) -> bool
-    {
-        cout << "compiling ";
-        switch (type)
-        {
-            case QOpenGLShader::Vertex:
-                cout << "vertex ";
-                break;
-            case QOpenGLShader::Geometry:
-                cout << "geometry ";
-                break;
-            case QOpenGLShader::Fragment:
-                cout << "fragment ";
-                break;
-            default:
-                assert(false);
-                break;
-        };
-        cout << std::quoted(filename) << " ";
-        cout.flush();
-
-        QFile handle(QString::fromStdString(filename));
-        if (!handle.open(QIODevice::ReadOnly))
-            return false;
-        const auto& source = handle.readAll();
-        const auto compile_ok = program->addShaderFromSourceCode(type, source);
-
-        cout << (compile_ok ? "OK" : "ERROR") << endl;
-
-        return compile_ok;
-    };
-
-    const auto vertex_load_ok = load_shader(QOpenGLShader::Vertex, vertex_filename);
-    const auto geometry_load_ok = geometry_filename.empty() ? true : load_shader(QOpenGLShader::Geometry, geometry_filename);
-    const auto fragment_load_ok = load_shader(QOpenGLShader::Fragment, fragment_filename);
-
-    cout << "linking ";
-    cout.flush();
-    const auto link_ok = program->link();
-    cout << (link_ok ? "OK" : "ERROR") << endl;
-
-    const auto gl_ok = glGetError() == GL_NO_ERROR;
-    const auto all_ok = vertex_load_ok && fragment_load_ok && geometry_load_ok && link_ok && gl_ok;
-    if (!all_ok) {
-        cerr << program->log().toStdString() << endl;
-        return nullptr;
-    }
-    assertNoError();
-    assert(all_ok);
 
-    return program;
+std::unique_ptr<QOpenGLShaderProgram> RasterWindowOpenGL::loadAndCompileProgram(const std::string& vertex_filename, const std::string& fragment_filename, const std::string& geometry_filename, const std::vector<std::string>& defines)
+{
+    return gl_utils::load_program(vertex_filename, fragment_filename, geometry_filename, defines);
 }
 
 bool RasterWindowOpenGL::initLocations(const QOpenGLShaderProgram& program, const Locations& attr_locations, const Locations& unif_locations)
 {
-    using std::cout;
-    using std::endl;
-
-    cout << "========== init locations" << endl;
-
-    bool found_all = true;
-
-    for (auto& pair : attr_locations)
-    {
-        cout << "attr " << std::quoted(pair.first) << " ";
-        cout.flush();
-
-        pair.second = program.attributeLocation(QString::fromStdString(pair.first));
-        const bool found = pair.second >= 0;
-        cout << (found ? "OK": "ERROR") << endl;
-
-        found_all &= found;
-    }
-
-    for (auto& pair : unif_locations)
-    {
-        cout << "unif " << std::quoted(pair.first) << " ";
-        cout.flush();
-
-        pair.second = program.uniformLocation(QString::fromStdString(pair.first));
-        const bool found = pair.second >= 0;
-        cout << (found ? "OK": "ERROR") << endl;
-
-        found_all &= found;
-    }
-
-    return found_all;
+    return gl_utils::init_locations(program, attr_locations, unif_locations);
 }
 
 void RasterWindowOpenGL::initializeGL()
@@ -478,7 +360,9 @@ void RasterWindowOpenGL::paintGL()
     glViewport(0, 0, width() * retinaScale, height() * retinaScale);
     assertNoError();
 
+    stream_buffer.beginFrame();
     paintScene();
+    stream_buffer.endFrame();
     assertNoError();
 
     QtImGui::newFrame();
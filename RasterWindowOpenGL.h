@@ -1,5 +1,8 @@
 #pragma once
 
+#include "StreamBuffer.h"
+#include "gl_utils.h"
+
 #include <QOpenGLWindow>
 #include <QOpenGLExtraFunctions>
 #include <QOpenGLShaderProgram>
@@ -49,6 +52,7 @@ class RasterWindowOpenGL : public QOpenGLWindow, public QOpenGLExtraFunctions
                 void loadBuffer3(const size_t kk, const std::vector<std::array<GLfloat, 3>>& values);
                 void loadBuffer4(const size_t kk, const std::vector<std::array<GLfloat, 4>>& values);
                 void loadIndices(const size_t kk, const std::vector<GLuint>& indices);
+                void initStream(const size_t kk, const size_t frame_bytes);
 
             protected:
                 RasterWindowOpenGL& view;
@@ -58,9 +62,10 @@ class RasterWindowOpenGL : public QOpenGLWindow, public QOpenGLExtraFunctions
         };
         virtual void initializeBuffers(BufferLoader& loader) = 0;
 
-        std::unique_ptr<QOpenGLShaderProgram> loadAndCompileProgram(const std::string& vertex_filename, const std::string& fragment_filename, const std::string& geometry_filename = "");
+        // defines are inserted after the version line of every stage
+        std::unique_ptr<QOpenGLShaderProgram> loadAndCompileProgram(const std::string& vertex_filename, const std::string& fragment_filename, const std::string& geometry_filename = "", const std::vector<std::string>& defines = {});
 
-        using Locations = std::unordered_map<std::string, int&>;
+        using Locations = gl_utils::Locations;
         bool initLocations(const QOpenGLShaderProgram& program, const Locations& attr_locations, const Locations& unif_locations);
 
         virtual void initializePrograms() = 0;
@@ -94,6 +99,7 @@ class RasterWindowOpenGL : public QOpenGLWindow, public QOpenGLExtraFunctions
 
         GLuint vao = 0;
         std::vector<GLuint> vbos;
+        StreamBuffer stream_buffer;
 };
 
 
@@ -0,0 +1,145 @@
+#include "StreamBuffer.h"
+#include "gl_utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cassert>
+
+constexpr size_t StreamBuffer::frame_count;
+
+StreamBuffer::StreamBuffer(QOpenGLExtraFunctions& gl_)
+    : gl(gl_)
+{
+}
+
+void StreamBuffer::init(const GLuint buffer_, const size_t frame_bytes_)
+{
+    assert(buffer == 0);
+    assert(buffer_ != 0);
+    buffer = buffer_;
+    allocate(frame_bytes_);
+}
+
+void StreamBuffer::allocate(const size_t frame_bytes_)
+{
+    assert(buffer);
+    assert(frame_bytes_ > 0);
+
+    // draws already issued keep the orphaned storage, its fences no longer guard anything
+    frame_bytes = frame_bytes_;
+    used_bytes = 0;
+    gl.glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    gl.glBufferData(GL_ARRAY_BUFFER, frame_count * frame_bytes, nullptr, GL_STREAM_DRAW);
+    for (auto& fence : fences)
+        if (fence)
+        {
+            gl.glDeleteSync(fence);
+            fence = nullptr;
+        }
+    gl_utils::assert_no_error(gl);
+}
+
+void StreamBuffer::setMode(const Mode mode_)
+{
+    if (mode_ == mode)
+        return;
+
+    // orphaning writes are not fenced
+    mode = mode_;
+    if (buffer)
+        allocate(frame_bytes);
+}
+
+StreamBuffer::Mode StreamBuffer::getMode() const
+{
+    return mode;
+}
+
+void StreamBuffer::beginFrame()
+{
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    frame_index = (frame_index + 1) % frame_count;
+    used_bytes = 0;
+    needs_orphan = mode == Mode::orphaning;
+    upload_ms = 0;
+    wait_ms = 0;
+
+    auto& fence = fences[frame_index];
+    if (!fence)
+        return;
+
+    const auto start = Clock::now();
+    auto status = gl.glClientWaitSync(fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+    {
+        stall_count++;
+        while (status == GL_TIMEOUT_EXPIRED)
+            status = gl.glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    }
+    assert(status != GL_WAIT_FAILED);
+    gl.glDeleteSync(fence);
+    fence = nullptr;
+    wait_ms = Milliseconds(Clock::now() - start).count();
+    upload_ms += wait_ms;
+}
+
+void StreamBuffer::endFrame()
+{
+    if (mode != Mode::unsynchronized || used_bytes == 0)
+        return;
+
+    auto& fence = fences[frame_index];
+    assert(!fence);
+    fence = gl.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    gl_utils::assert_no_error(gl);
+}
+
+void StreamBuffer::reserve(const size_t size)
+{
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    const auto start = Clock::now();
+    if (size > frame_bytes)
+    {
+        resize_count++;
+        allocate(std::max(size, 2 * frame_bytes));
+    }
+    else if (needs_orphan || used_bytes + size > frame_bytes)
+    {
+        orphan_count++;
+        allocate(frame_bytes);
+    }
+    needs_orphan = false;
+    upload_ms += Milliseconds(Clock::now() - start).count();
+}
+
+GLintptr StreamBuffer::push(const void* data, const size_t size)
+{
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    assert(buffer);
+    assert(size % 4 == 0); // keeps attribute offsets aligned
+    assert(used_bytes + size <= frame_bytes);
+
+    const auto start = Clock::now();
+    const GLintptr offset = frame_index * frame_bytes + used_bytes;
+    gl.glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (size > 0)
+    {
+        auto mapped = gl.glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        assert(mapped);
+        std::memcpy(mapped, data, size);
+        const auto unmap_ok = gl.glUnmapBuffer(GL_ARRAY_BUFFER);
+        assert(unmap_ok);
+    }
+    used_bytes += size;
+    gl_utils::assert_no_error(gl);
+    upload_ms += Milliseconds(Clock::now() - start).count();
+
+    return offset;
+}
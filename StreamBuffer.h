@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QOpenGLExtraFunctions>
+
+#include <array>
+
+// per frame vertex data sub-allocated from one buffer split in frame_count regions, writes go through
+// unsynchronized mapped ranges and a region is reused once the fence of the frame that last used it has signaled.
+// a frame that overflows its region orphans the storage, orphaning mode does so every frame instead of fencing
+class StreamBuffer
+{
+    public:
+        enum class Mode { unsynchronized, orphaning };
+        static constexpr size_t frame_count = 3;
+
+        StreamBuffer(QOpenGLExtraFunctions& gl);
+
+        void init(const GLuint buffer, const size_t frame_bytes);
+        void setMode(const Mode mode);
+        Mode getMode() const;
+        void beginFrame();
+        void endFrame();
+        void reserve(const size_t size); // before the pushes of a draw so that their offsets share the same storage
+        GLintptr push(const void* data, const size_t size); // binds the buffer to GL_ARRAY_BUFFER, returns the offset for glVertexAttribPointer
+
+        size_t frame_bytes = 0; // region size, grows to the largest reserve
+        size_t used_bytes = 0; // this frame
+        double upload_ms = 0; // this frame, waits included
+        double wait_ms = 0; // this frame, waiting for the region fence
+        size_t stall_count = 0;
+        size_t orphan_count = 0;
+        size_t resize_count = 0;
+
+    protected:
+        void allocate(const size_t frame_bytes);
+
+        QOpenGLExtraFunctions& gl;
+        Mode mode = Mode::unsynchronized;
+        GLuint buffer = 0;
+        size_t frame_index = 0;
+        bool needs_orphan = false;
+        std::array<GLsync, frame_count> fences = {};
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads consuming a fifo of tasks.
+// A task must not wait on futures of tasks submitted to the same pool,
+// every worker could end up waiting.
+class ThreadPool
+{
+    public:
+        ThreadPool(const size_t thread_count = std::thread::hardware_concurrency());
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        template <typename Func>
+        std::future<typename std::result_of<Func()>::type> submit(Func func);
+
+        size_t getThreadCount() const;
+
+        // shared pool for short cpu bound batches, created on first use
+        static ThreadPool& global();
+
+    protected:
+        void run();
+
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<std::function<void()>> tasks;
+        bool stopping = false;
+};
+
+template <typename Func>
+std::future<typename std::result_of<Func()>::type> ThreadPool::submit(Func func)
+{
+    using Result = typename std::result_of<Func()>::type;
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::move(func));
+    auto future = task->get_future();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.emplace_back([task]() -> void { (*task)(); });
+    }
+    condition.notify_one();
+    return future;
+}
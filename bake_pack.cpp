@@ -0,0 +1,40 @@
+#include "level_pack.h"
+
+#include <QCoreApplication>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+
+// extracts and decomposes every map referenced by levels.json into a single pack,
+// rocket maps it at startup when the json pack key names it
+int main(int argc, char* argv[])
+{
+    using std::cout;
+    using std::endl;
+
+    QCoreApplication app(argc, argv);
+
+    const std::string json_filename = ":/levels/levels.json";
+    const auto data = levels::load(json_filename);
+    const std::string filename = argc > 1 ? argv[1] : data.pack_filename.empty() ? "levels.pack" : data.pack_filename;
+
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<float, std::milli>;
+
+    std::vector<polygons::Ground> grounds;
+    for (const auto& level : data.levels)
+    {
+        cout << "========== baking " << std::quoted(level.name) << endl;
+        const auto start = Clock::now();
+        grounds.emplace_back(polygons::build_ground(level.map_filename, level.ground_options));
+        cout << grounds.back().pieces.size() << " pieces " << Milliseconds(Clock::now() - start).count() << "ms" << endl;
+    }
+
+    std::ofstream handle(filename, std::ios::binary);
+    levels::write_pack(handle, data, grounds, levels::source_hash(json_filename, data));
+    cout << "wrote " << std::quoted(filename) << " " << handle.tellp() / 1024 << "KiB" << endl;
+
+    return 0;
+}
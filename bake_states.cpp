@@ -0,0 +1,91 @@
+#include "load_levels.h"
+#include "GameState.h"
+
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QDir>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+
+// simulates the water and crate regions of every level until they settle
+// and writes the resulting state next to the maps, to be referenced by the level initial_state key
+int main(int argc, char* argv[])
+{
+    using std::cout;
+    using std::endl;
+    using std::get;
+
+    QCoreApplication app(argc, argv);
+
+    const QDir output_dir(argc > 1 ? argv[1] : ".");
+    const float max_time = argc > 2 ? std::stof(argv[2]) : 60;
+    constexpr float dt = 1 / 60.;
+    constexpr float rest_speed = .5;
+
+    const auto data = levels::load(":/levels/levels.json");
+
+    for (const auto& level : data.levels)
+    {
+        cout << "========== baking " << std::quoted(level.name) << endl;
+
+        GameState state;
+        state.resetGround(level.map_filename, level.ground_options);
+
+        if (level.has_world_bounds)
+        {
+            state.world_bounds.lowerBound = level.world_bounds_lower;
+            state.world_bounds.upperBound = level.world_bounds_upper;
+        }
+
+        for (const auto& door : level.doors)
+            state.addDoor(get<0>(door), get<1>(door), get<2>(door));
+
+        for (const auto& path : level.paths)
+            state.addPath(get<0>(path), get<1>(path));
+
+        state.resetShip(level.ship_spawn);
+        state.resetBall(level.ball_spawn);
+        state.fillRegions();
+
+        assert(state.system);
+        if (!state.system->GetParticleCount() && state.crates.empty())
+        {
+            cout << "nothing to bake" << endl;
+            continue;
+        }
+
+        const auto is_settled = [&state, &rest_speed]() -> bool
+        {
+            const auto velocities = state.system->GetVelocityBuffer();
+            for (auto kk=0, kk_max=state.system->GetParticleCount(); kk<kk_max; kk++)
+                if (velocities[kk].LengthSquared() > rest_speed * rest_speed)
+                    return false;
+            for (const auto& crate : state.crates)
+                if (get<0>(crate)->IsAwake())
+                    return false;
+            return true;
+        };
+
+        float time = 0;
+        bool settled = false;
+        while (!settled && time < max_time)
+        {
+            for (auto kk=0; kk<60; kk++)
+                state.step(dt);
+            time += 60 * dt;
+            settled = is_settled();
+        }
+
+        cout << (settled ? "settled" : "not settled") << " after " << time << "s ";
+        cout << state.system->GetParticleCount() << " particles " << state.crates.size() << " crates" << endl;
+
+        const auto filename = output_dir.filePath(QFileInfo(QString::fromStdString(level.map_filename)).completeBaseName() + ".state").toStdString();
+        std::ofstream handle(filename, std::ios::binary);
+        state.saveState(handle);
+        cout << "wrote " << std::quoted(filename) << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "load_levels.h"
+#include "GameState.h"
+
+#include <QCoreApplication>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+
+// steps a level with a growing number of wandering bot ships and reports the cost per step
+int main(int argc, char* argv[])
+{
+    using std::cout;
+    using std::endl;
+
+    QCoreApplication app(argc, argv);
+
+    const auto data = levels::load(":/levels/levels.json");
+    assert(!data.levels.empty());
+
+    const int level_index = argc > 1 ? std::stoi(argv[1]) : std::max(data.default_level, 0);
+    const bool with_balls = argc > 2 && std::string(argv[2]) == "balls";
+    assert(level_index >= 0);
+    assert(level_index < static_cast<int>(data.levels.size()));
+    const auto& level = data.levels[level_index];
+
+    constexpr float dt = 1 / 60.;
+    constexpr int warmup_steps = 60;
+    constexpr int measured_steps = 300;
+
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    cout << "level " << std::quoted(level.name) << (with_balls ? " with balls" : "") << endl;
+    cout << std::setw(6) << "bots" << std::setw(12) << "ms/step" << std::setw(14) << "us/bot/step" << std::setw(10) << "crashed" << endl;
+
+    for (const size_t count : { 0, 1, 10, 100, 1000 })
+    {
+        GameState state;
+        state.resetGround(level.map_filename, level.ground_options);
+        state.resetShip(level.ship_spawn);
+        state.resetBall(level.ball_spawn);
+        state.addBots(count, level.ship_spawn + b2Vec2 { 0, 100 }, 8, with_balls);
+
+        for (auto kk=0; kk<warmup_steps; kk++)
+        {
+            state.wanderBots(dt);
+            state.step(dt);
+        }
+
+        const auto start = Clock::now();
+        for (auto kk=0; kk<measured_steps; kk++)
+        {
+            state.wanderBots(dt);
+            state.step(dt);
+        }
+        const auto step_ms = Milliseconds(Clock::now() - start).count() / measured_steps;
+
+        const auto& touched = state.bots.touched_wall;
+        const auto crashed = std::count(std::cbegin(touched), std::cend(touched), true);
+
+        cout << std::setw(6) << count << std::setw(12) << std::fixed << std::setprecision(3) << step_ms;
+        cout << std::setw(14) << (count ? 1e3 * step_ms / count : 0.) << std::setw(10) << crashed << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "load_levels.h"
+#include "GameState.h"
+
+#include <QCoreApplication>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+// even-odd rule against every foreground outline
+static bool inside_ground(const polygons::Ground& ground, const b2Vec2& point)
+{
+    bool inside = false;
+    const auto& outlines = ground.outlines;
+    for (size_t ll=0; ll<outlines.size(); ll++)
+        for (size_t kk=0, kk_max=outlines.count(ll); kk<kk_max; kk++)
+        {
+            const auto& aa = outlines.begin(ll)[kk];
+            const auto& bb = outlines.begin(ll)[(kk + 1) % kk_max];
+            if ((aa.y > point.y) == (bb.y > point.y))
+                continue;
+            const auto xx = aa.x + (point.y - aa.y) * (bb.x - aa.x) / (bb.y - aa.y);
+            if (point.x < xx)
+                inside = !inside;
+        }
+    return inside;
+}
+
+// loads every level with polygon and chain ground, drops water and compares load time, fixtures,
+// step time and particles that end up inside the solid ground or out of bounds
+int main(int argc, char* argv[])
+{
+    using std::cout;
+    using std::endl;
+    using std::get;
+    using std::setw;
+
+    QCoreApplication app(argc, argv);
+
+    const auto data = levels::load(":/levels/levels.json");
+
+    const int level_index = argc > 1 ? std::stoi(argv[1]) : -1;
+    const float duration = argc > 2 ? std::stof(argv[2]) : 10;
+    assert(level_index < static_cast<int>(data.levels.size()));
+    constexpr float dt = 1 / 60.;
+    const int step_count = static_cast<int>(duration / dt);
+
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    using Row = std::tuple<std::string, std::string, double, size_t, size_t, double, int, int, int>; // level, mode, load ms, fixtures, proxies, ms/step, particles, leaked, lost
+    std::vector<Row> rows;
+    for (int index=0; index<static_cast<int>(data.levels.size()); index++)
+    {
+        if (level_index >= 0 && index != level_index)
+            continue;
+        const auto& level = data.levels[index];
+
+        for (const bool use_chains : { false, true })
+        {
+            auto options = level.ground_options;
+            options.use_chains = use_chains;
+
+            GameState state;
+
+            const auto load_start = Clock::now();
+            const auto ground = polygons::build_ground(level.map_filename, options);
+            state.resetGround(ground);
+            const auto load_ms = Milliseconds(Clock::now() - load_start).count();
+
+            if (level.has_world_bounds)
+            {
+                state.world_bounds.lowerBound = level.world_bounds_lower;
+                state.world_bounds.upperBound = level.world_bounds_upper;
+            }
+
+            size_t fixture_count = 0;
+            size_t proxy_count = 0;
+            assert(state.ground);
+            for (auto fixture=state.ground->GetFixtureList(); fixture; fixture=fixture->GetNext())
+            {
+                fixture_count++;
+                proxy_count += fixture->GetShape()->GetChildCount();
+            }
+
+            state.fillRegions();
+            state.addWater(level.water_spawn, level.water_drop_size, 0, b2_viscousParticle | b2_tensileParticle);
+            assert(state.system);
+            const auto particle_count = state.system->GetParticleCount();
+
+            const auto step_start = Clock::now();
+            for (auto kk=0; kk<step_count; kk++)
+                state.step(dt);
+            const auto step_ms = Milliseconds(Clock::now() - step_start).count() / std::max(step_count, 1);
+
+            int leaked = 0;
+            const auto positions = state.system->GetPositionBuffer();
+            for (auto kk=0, kk_max=state.system->GetParticleCount(); kk<kk_max; kk++)
+                if (inside_ground(ground, positions[kk]))
+                    leaked++;
+
+            rows.emplace_back(level.name, use_chains ? "chains" : "polygons", load_ms, fixture_count, proxy_count, step_ms,
+                particle_count, leaked, particle_count - state.system->GetParticleCount());
+        }
+    }
+
+    cout << std::fixed << std::setprecision(2);
+    cout << setw(12) << "level" << setw(10) << "mode" << setw(10) << "load ms" << setw(10) << "fixtures" << setw(10) << "proxies";
+    cout << setw(10) << "ms/step" << setw(11) << "particles" << setw(8) << "leaked" << setw(8) << "lost" << endl;
+    for (const auto& row : rows)
+    {
+        cout << setw(12) << get<0>(row) << setw(10) << get<1>(row) << setw(10) << get<2>(row) << setw(10) << get<3>(row) << setw(10) << get<4>(row);
+        cout << setw(10) << get<5>(row) << setw(11) << get<6>(row) << setw(8) << get<7>(row) << setw(8) << get<8>(row) << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include "extract_polygons.h"
+#include "simplify_polygons.h"
+#include "decompose_polygons.h"
+#include "partition_polygons.h"
+#include "merge_polygons.h"
+#include "ground_polygons.h"
+
+#include <QCoreApplication>
+#include <QDir>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+// decomposes the simplified foreground of every map with each method,
+// reports time, pieces, vertices of the largest piece, largest concavity in world units and pieces left after merging and splitting like build_ground,
+// the fastest method whose pieces are convex within the flatten tolerance is starred
+int main(int argc, char* argv[])
+{
+    using std::cout;
+    using std::endl;
+    using std::get;
+    using std::setw;
+
+    QCoreApplication app(argc, argv);
+
+    const int repeats = argc > 1 ? std::max(1, std::stoi(argv[1])) : 10;
+
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    const polygons::GroundOptions options;
+    const auto tolerance = options.simplify_tolerance / polygons::world_scale;
+    const auto min_area = options.min_piece_area / (polygons::world_scale * polygons::world_scale);
+    const std::vector<polygons::Decomposition> methods {
+        polygons::Decomposition::acd2d,
+        polygons::Decomposition::ear_clipping,
+        polygons::Decomposition::bayazit,
+    };
+
+    cout << std::fixed << std::setprecision(3);
+    cout << setw(10) << "map" << setw(14) << "method" << setw(10) << "vertices" << setw(10) << "ms" << setw(10) << "pieces" << setw(10) << "largest" << setw(12) << "concavity" << setw(10) << "merged" << endl;
+
+    const auto maps = QDir(":/levels").entryList({ "map*.svg" }, QDir::Files, QDir::Name);
+    for (const auto& map : maps)
+    {
+        const auto polys = polygons::extract(":/levels/" + map.toStdString(), options.flatten_tolerance / polygons::world_scale);
+
+        std::vector<polygons::Poly> outlines;
+        size_t vertex_count = 0;
+        const auto& brush_polys = get<1>(polys);
+        for (size_t kk=0; kk<brush_polys.size(); kk++)
+        {
+            if (!polygons::isForeground(brush_polys.colors[kk]))
+                continue;
+            auto outline = polygons::simplify(brush_polys.begin(kk), brush_polys.count(kk), tolerance);
+            polygons::ensure_cw(outline.data(), outline.size());
+            vertex_count += outline.size();
+            outlines.emplace_back(std::move(outline));
+        }
+
+        using Row = std::tuple<double, size_t, float, size_t, size_t>; // ms, pieces, concavity, merged pieces, largest piece vertices
+        std::vector<Row> rows;
+        for (const auto& method : methods)
+        {
+            polygons::PolySoup pieces;
+            const auto start = Clock::now();
+            for (auto repeat=0; repeat<repeats; repeat++)
+            {
+                pieces.clear();
+                for (const auto& outline : outlines)
+                    pieces.append(polygons::decompose(outline.data(), outline.size(), 1e-5, method));
+            }
+            const auto elapsed = Milliseconds(Clock::now() - start).count() / repeats;
+
+            float max_concavity = 0;
+            size_t max_count = 0;
+            for (size_t kk=0; kk<pieces.size(); kk++)
+            {
+                max_concavity = std::fmax(max_concavity, polygons::concavity(pieces.begin(kk), pieces.count(kk)));
+                max_count = std::max(max_count, pieces.count(kk));
+            }
+
+            // merging only joins pieces of the same outline
+            size_t merged_count = 0;
+            for (const auto& outline : outlines)
+                merged_count += polygons::split_convex(polygons::merge_convex(polygons::decompose(outline.data(), outline.size(), 1e-5, method), b2_maxPolygonVertices, min_area), b2_maxPolygonVertices).size();
+
+            rows.emplace_back(elapsed, pieces.size(), max_concavity * polygons::world_scale, merged_count, max_count);
+        }
+
+        size_t best = rows.size();
+        for (size_t kk=0; kk<rows.size(); kk++)
+            if (get<2>(rows[kk]) <= options.flatten_tolerance && (best == rows.size() || get<0>(rows[kk]) < get<0>(rows[best])))
+                best = kk;
+
+        for (size_t kk=0; kk<rows.size(); kk++)
+        {
+            const auto& row = rows[kk];
+            cout << setw(10) << map.toStdString() << setw(14) << polygons::decomposition_names[static_cast<size_t>(methods[kk])] << setw(10) << vertex_count;
+            cout << setw(10) << get<0>(row) << setw(10) << get<1>(row) << setw(10) << get<4>(row) << setw(12) << get<2>(row) << setw(10) << get<3>(row) << (kk == best ? " *" : "") << endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include "load_levels.h"
+#include "ground_polygons.h"
+
+#include <QCoreApplication>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+
+// builds every level ground with successive pipeline stages enabled,
+// reports outline vertices, fixtures and build time for each
+int main(int argc, char* argv[])
+{
+    using std::cout;
+    using std::endl;
+    using std::get;
+    using std::setw;
+
+    QCoreApplication app(argc, argv);
+
+    const auto data = levels::load(":/levels/levels.json");
+
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    using Row = std::tuple<std::string, std::string, size_t, size_t, double>; // level, stages, vertices, fixtures, ms
+    std::vector<Row> rows;
+    for (const auto& level : data.levels)
+    {
+        auto raw_options = level.ground_options;
+        raw_options.simplify_tolerance = 0;
+        raw_options.merge_pieces = false;
+        auto simplified_options = level.ground_options;
+        simplified_options.merge_pieces = false;
+
+        const std::vector<std::tuple<std::string, polygons::GroundOptions>> configs {
+            std::make_tuple("raw", raw_options),
+            std::make_tuple("simplified", simplified_options),
+            std::make_tuple("level", level.ground_options),
+        };
+
+        for (const auto& config : configs)
+        {
+            const auto start = Clock::now();
+            const auto ground = polygons::build_ground(level.map_filename, get<1>(config));
+            const auto elapsed = Milliseconds(Clock::now() - start).count();
+
+            rows.emplace_back(level.name, get<0>(config), ground.outlines.vertices.size(), ground.pieces.size(), elapsed);
+        }
+    }
+
+    cout << std::fixed << std::setprecision(1);
+    cout << setw(12) << "level" << setw(12) << "stages" << setw(10) << "vertices" << setw(10) << "fixtures" << setw(10) << "ms" << endl;
+    for (const auto& row : rows)
+        cout << setw(12) << get<0>(row) << setw(12) << get<1>(row) << setw(10) << get<2>(row) << setw(10) << get<3>(row) << setw(10) << get<4>(row) << endl;
+
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "ParticleRenderer.h"
+#include "StreamBuffer.h"
+#include "Camera.h"
+
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QSurfaceFormat>
+
+#include <iostream>
+#include <string>
+#include <cassert>
+
+// times every particle backend offscreen and prints the table of the particles panel bench button,
+// draws go to a framebuffer of the given size with the default shading, particles are .5 in radius like the game
+int main(int argc, char* argv[])
+{
+    using std::cout;
+    using std::endl;
+
+    QGuiApplication app(argc, argv);
+
+    const int width = argc > 1 ? std::stoi(argv[1]) : 1280;
+    const int height = argc > 2 ? std::stoi(argv[2]) : 720;
+    const bool orphaning = argc > 3 && std::string(argv[3]) == "orphaning";
+    assert(width > 0 && height > 0);
+
+    QSurfaceFormat format;
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CoreProfile);
+    format.setDepthBufferSize(16);
+
+    QOpenGLContext context;
+    context.setFormat(format);
+    if (!context.create())
+    {
+        cout << "can't create a 3.3 core context" << endl;
+        return 1;
+    }
+
+    QOffscreenSurface surface;
+    surface.setFormat(context.format());
+    surface.create();
+    if (!context.makeCurrent(&surface))
+    {
+        cout << "can't make the context current" << endl;
+        return 1;
+    }
+
+    // the offscreen surface has no default framebuffer that can be relied on
+    QOpenGLFramebufferObject framebuffer(width, height, QOpenGLFramebufferObject::Depth);
+    framebuffer.bind();
+
+    QOpenGLExtraFunctions gl(&context);
+    gl.glViewport(0, 0, width, height);
+    gl.glClearColor(.8, .8, .8, 1);
+    gl.glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    GLuint buffer = 0;
+    gl.glGenBuffers(1, &buffer);
+    StreamBuffer stream_buffer(gl);
+    stream_buffer.init(buffer, 10000 * ParticleRenderer::particle_bytes);
+    stream_buffer.setMode(orphaning ? StreamBuffer::Mode::orphaning : StreamBuffer::Mode::unsynchronized);
+
+    ParticleRenderer renderer(stream_buffer);
+    renderer.initialize();
+
+    // the biggest block spans 316 radii, the world camera of the stress levels sees about as much
+    Camera camera;
+    camera.screen_height = 200;
+    const auto camera_matrix = camera.cameraMatrix(width / static_cast<float>(height));
+
+    ParticleRenderer::Shading shading;
+    shading.viewport_width = width;
+
+    stream_buffer.beginFrame();
+    const auto rows = renderer.bench(shading, camera_matrix, b2Vec2(camera.position[0], camera.position[1]), .5);
+    stream_buffer.endFrame();
+    renderer.printBench(rows, shading, width, height);
+
+    framebuffer.release();
+    gl.glDeleteBuffers(1, &buffer);
+    context.doneCurrent();
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "load_levels.h"
+#include "extract_polygons.h"
+#include "GameState.h"
+
+#include <QCoreApplication>
+#include <QFileInfo>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <limits>
+
+// times each stage of loading and playing a level: svg extraction, the rest of build_ground
+// (simplification, decomposition and merging), resetGround with every chunk loaded and particle steps with the level doors,
+// levels.json is a resource or a file whose :/levels/ maps are read next to it, like gen_stress_maps writes
+int main(int argc, char* argv[])
+{
+    using std::cout;
+    using std::endl;
+    using std::get;
+    using std::setw;
+
+    QCoreApplication app(argc, argv);
+
+    const std::string json_filename = argc > 1 ? argv[1] : ":/levels/levels.json";
+    const int level_index = argc > 2 ? std::stoi(argv[2]) : -1;
+    const float duration = argc > 3 ? std::stof(argv[3]) : 2;
+
+    auto data = levels::load(json_filename);
+    assert(level_index < static_cast<int>(data.levels.size()));
+    if (json_filename.compare(0, 2, ":/") != 0)
+    {
+        const auto levels_dir = QFileInfo(QString::fromStdString(json_filename)).path().toStdString();
+        const std::string prefix = ":/levels/";
+        for (auto& level : data.levels)
+            if (level.map_filename.compare(0, prefix.size(), prefix) == 0)
+                level.map_filename = levels_dir + "/" + level.map_filename.substr(prefix.size());
+    }
+
+    constexpr float dt = 1 / 60.;
+    const int step_count = static_cast<int>(duration / dt);
+
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    using Row = std::tuple<std::string, size_t, double, double, size_t, double, int, double>; // level, vertices, extract ms, decompose ms, fixtures, reset ms, particles, ms/step
+    std::vector<Row> rows;
+    for (int index=0; index<static_cast<int>(data.levels.size()); index++)
+    {
+        if (level_index >= 0 && index != level_index)
+            continue;
+        const auto& level = data.levels[index];
+        const auto& options = level.ground_options;
+
+        const auto extract_start = Clock::now();
+        const auto polys = polygons::extract(level.map_filename, options.flatten_tolerance / polygons::world_scale);
+        const auto extract_ms = Milliseconds(Clock::now() - extract_start).count();
+
+        size_t vertex_count = 0;
+        const auto& brush_polys = get<1>(polys);
+        for (size_t kk=0; kk<brush_polys.size(); kk++)
+            if (polygons::isForeground(brush_polys.colors[kk]))
+                vertex_count += brush_polys.count(kk);
+
+        // build_ground extracts again, its own extraction is not counted twice
+        const auto build_start = Clock::now();
+        const auto ground = polygons::build_ground(level.map_filename, options);
+        const auto decompose_ms = std::max(0., Milliseconds(Clock::now() - build_start).count() - extract_ms);
+
+        GameState state;
+
+        // chunked levels get every chunk loaded here so that the steps run against the whole ground
+        const auto reset_start = Clock::now();
+        state.resetGround(ground, level.chunk_size);
+        if (!state.chunks.empty())
+            state.streamChunks(level.ship_spawn, std::numeric_limits<float>::max(), true);
+        const auto reset_ms = Milliseconds(Clock::now() - reset_start).count();
+
+        if (level.has_world_bounds)
+        {
+            state.world_bounds.lowerBound = level.world_bounds_lower;
+            state.world_bounds.upperBound = level.world_bounds_upper;
+        }
+
+        size_t fixture_count = 0;
+        assert(state.ground);
+        for (auto fixture=state.ground->GetFixtureList(); fixture; fixture=fixture->GetNext())
+            fixture_count++;
+
+        for (const auto& door : level.doors)
+            state.addDoor(get<0>(door), get<1>(door), get<2>(door));
+
+        state.fillRegions();
+        state.addWater(level.water_spawn, level.water_drop_size, 0, b2_viscousParticle | b2_tensileParticle);
+        assert(state.system);
+        const auto particle_count = state.system->GetParticleCount();
+
+        const auto step_start = Clock::now();
+        for (auto kk=0; kk<step_count; kk++)
+            state.step(dt);
+        const auto step_ms = Milliseconds(Clock::now() - step_start).count() / std::max(step_count, 1);
+
+        rows.emplace_back(level.name, vertex_count, extract_ms, decompose_ms, fixture_count, reset_ms, particle_count, step_ms);
+    }
+
+    cout << std::fixed << std::setprecision(2);
+    cout << setw(14) << "level" << setw(10) << "vertices" << setw(12) << "extract ms" << setw(14) << "decompose ms";
+    cout << setw(10) << "fixtures" << setw(10) << "reset ms" << setw(11) << "particles" << setw(10) << "ms/step" << endl;
+    for (const auto& row : rows)
+    {
+        cout << setw(14) << get<0>(row) << setw(10) << get<1>(row) << setw(12) << get<2>(row) << setw(14) << get<3>(row);
+        cout << setw(10) << get<4>(row) << setw(10) << get<5>(row) << setw(11) << get<6>(row) << setw(10) << get<7>(row) << endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include "carve_polygons.h"
+#include "merge_polygons.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using polygons::Poly;
+using polygons::PolySoup;
+using polygons::Segment;
+
+// keeps the side of the line through aa and bb where side * cross is positive, points on the line stay on both sides,
+// intersections only depend on the line so that both sides share them exactly
+static Poly clip_half_plane(const Poly& poly, const b2Vec2& aa, const b2Vec2& bb, const float side)
+{
+    Poly clipped;
+    const auto edge = bb - aa;
+    const auto count = poly.size();
+    for (size_t kk=0; kk<count; kk++)
+    {
+        const auto& current = poly[kk];
+        const auto& next = poly[(kk + 1) % count];
+        const auto dist = b2Cross(edge, current - aa);
+        const auto dist_next = b2Cross(edge, next - aa);
+        if (side * dist >= 0)
+            clipped.emplace_back(current);
+        if ((dist < 0 && dist_next > 0) || (dist > 0 && dist_next < 0))
+            clipped.emplace_back(current + (dist / (dist - dist_next)) * (next - current));
+    }
+    return clipped;
+}
+
+// parameter range of the segment inside the convex polygon, empty when first >= second
+static std::tuple<float, float> convex_interval(const Segment& segment, const b2Vec2* convex, const size_t count)
+{
+    const auto& origin = std::get<0>(segment);
+    const auto direction = std::get<1>(segment) - origin;
+    float tt_min = 0;
+    float tt_max = 1;
+    for (size_t kk=0; kk<count && tt_min < tt_max; kk++)
+    {
+        const auto& aa = convex[kk];
+        const auto edge = convex[(kk + 1) % count] - aa;
+        const auto dist = b2Cross(edge, origin - aa);
+        const auto rate = b2Cross(edge, direction);
+        if (rate == 0)
+        {
+            if (dist < 0)
+                return std::make_tuple(1.f, 0.f);
+            continue;
+        }
+        const auto tt = -dist / rate;
+        if (rate > 0)
+            tt_min = std::max(tt_min, tt);
+        else
+            tt_max = std::min(tt_max, tt);
+    }
+    return std::make_tuple(tt_min, tt_max);
+}
+
+bool polygons::convex_disjoint(const b2Vec2* aa, const size_t aa_count, const b2Vec2* bb, const size_t bb_count)
+{
+    const auto separates = [](const b2Vec2* edges, const size_t edge_count, const b2Vec2* points, const size_t count) -> bool
+    {
+        for (size_t kk=0; kk<edge_count; kk++)
+        {
+            const auto& origin = edges[kk];
+            const auto edge = edges[(kk + 1) % edge_count] - origin;
+            if (std::all_of(points, points + count, [&origin, &edge](const b2Vec2& point) -> bool { return b2Cross(edge, point - origin) <= 0; }))
+                return true;
+        }
+        return false;
+    };
+    return separates(aa, aa_count, bb, bb_count) || separates(bb, bb_count, aa, aa_count);
+}
+
+Poly polygons::circle_polygon(const b2Vec2& center, const float radius, const size_t count)
+{
+    assert(count >= 3);
+    Poly poly;
+    for (size_t kk=0; kk<count; kk++)
+    {
+        const auto angle = 2 * static_cast<float>(M_PI) * kk / count;
+        poly.emplace_back(center + radius * b2Vec2 { std::cos(angle), std::sin(angle) });
+    }
+    return poly;
+}
+
+PolySoup polygons::subtract_convex(const b2Vec2* piece, const size_t count, const b2Vec2* carve, const size_t carve_count, const size_t max_vertices, const float weld_distance, const float min_area)
+{
+    assert(max_vertices >= 3);
+
+    PolySoup pieces;
+    const auto push_piece = [&pieces, &max_vertices, &weld_distance, &min_area](const Poly& poly) -> void
+    {
+        Poly welded;
+        for (const auto& point : poly)
+            if (welded.empty() || b2DistanceSquared(welded.back(), point) > weld_distance * weld_distance)
+                welded.emplace_back(point);
+        while (welded.size() > 1 && b2DistanceSquared(welded.back(), welded.front()) <= weld_distance * weld_distance)
+            welded.pop_back();
+        if (welded.size() < 3 || signed_area(welded) < min_area)
+            return;
+
+        // fan from the first vertex, convex chunks stay convex
+        for (size_t start=1; start + 1<welded.size();)
+        {
+            const auto end = std::min(start + max_vertices - 2, welded.size() - 1);
+            Poly chunk { welded.front() };
+            chunk.insert(std::end(chunk), std::begin(welded) + start, std::begin(welded) + end + 1);
+            if (signed_area(chunk) >= min_area)
+                pieces.push(chunk);
+            start = end;
+        }
+    };
+
+    if (convex_disjoint(piece, count, carve, carve_count))
+    {
+        push_piece(Poly(piece, piece + count));
+        return pieces;
+    }
+
+    // the part outside each carve edge but inside the previous ones is convex, the remainder shrinks toward the carve
+    Poly remaining(piece, piece + count);
+    for (size_t kk=0; kk<carve_count; kk++)
+    {
+        const auto& aa = carve[kk];
+        const auto& bb = carve[(kk + 1) % carve_count];
+        push_piece(clip_half_plane(remaining, aa, bb, -1));
+        remaining = clip_half_plane(remaining, aa, bb, 1);
+        if (remaining.size() < 3 || signed_area(remaining) <= 0)
+            break;
+    }
+
+    return pieces;
+}
+
+bool polygons::clip_segment(const Segment& segment, const b2Vec2* convex, const size_t count, Segment& clipped)
+{
+    float tt_min, tt_max;
+    std::tie(tt_min, tt_max) = convex_interval(segment, convex, count);
+    if (tt_min >= tt_max)
+        return false;
+
+    const auto& origin = std::get<0>(segment);
+    const auto direction = std::get<1>(segment) - origin;
+    clipped = std::make_tuple(origin + tt_min * direction, origin + tt_max * direction);
+    return true;
+}
+
+void polygons::subtract_segment(const Segment& segment, const b2Vec2* carve, const size_t carve_count, std::vector<Segment>& parts)
+{
+    float tt_min, tt_max;
+    std::tie(tt_min, tt_max) = convex_interval(segment, carve, carve_count);
+    if (tt_min >= tt_max)
+    {
+        parts.emplace_back(segment);
+        return;
+    }
+
+    const auto& origin = std::get<0>(segment);
+    const auto direction = std::get<1>(segment) - origin;
+    if (tt_min > 0)
+        parts.emplace_back(origin, origin + tt_min * direction);
+    if (tt_max < 1)
+        parts.emplace_back(origin + tt_max * direction, std::get<1>(segment));
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "data_polygons.h"
+
+namespace polygons
+{
+
+// boolean ops against a convex carving polygon, counter clockwise like the ground pieces
+
+using Segment = std::tuple<b2Vec2, b2Vec2>;
+
+// regular polygon inscribed in the circle, counter clockwise
+Poly circle_polygon(const b2Vec2& center, const float radius, const size_t count);
+
+// separating axis among the edges of both convex polygons, touching counts as disjoint
+bool convex_disjoint(const b2Vec2* aa, const size_t aa_count, const b2Vec2* bb, const size_t bb_count);
+
+// convex piece minus carve as disjoint convex pieces of at most max_vertices,
+// vertices closer than weld_distance are merged and pieces smaller than min_area dropped
+PolySoup subtract_convex(const b2Vec2* piece, const size_t count, const b2Vec2* carve, const size_t carve_count, const size_t max_vertices, const float weld_distance, const float min_area);
+
+// part of the segment inside the convex polygon, false when it misses
+bool clip_segment(const Segment& segment, const b2Vec2* convex, const size_t count, Segment& clipped);
+
+// appends the zero to two parts of the segment outside the carve
+void subtract_segment(const Segment& segment, const b2Vec2* carve, const size_t carve_count, std::vector<Segment>& parts);
+
+}
@@ -1,6 +1,10 @@
 #version 330 core
 
+#if defined(POINT_SPRITES)
+vec4 pos; // from the sprite coordinates
+#else
 in vec4 pos;
+#endif
 in float speed;
 in vec4 col;
 flat in uint flag;
@@ -32,6 +36,9 @@ bool is_flag_set(uint value, const uint flag)
 
 void main()
 {
+#if defined(POINT_SPRITES)
+  pos = radius * vec4(2 * gl_PointCoord.x - 1, 1 - 2 * gl_PointCoord.y, 0, 0);
+#endif
   float dotRadius = radiusFactor * radius;
   bool in_dot = pos.x * pos.x + pos.y * pos.y + pos.z * pos.z < dotRadius * dotRadius;
   if (mode > 3 && !in_dot)
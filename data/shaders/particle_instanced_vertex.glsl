@@ -0,0 +1,27 @@
+#version 330 core
+
+// one instance per particle, the corner buffer holds the polygons of particle_geometry.glsl in particle radii
+
+in vec2 cornerAttr;
+in vec2 posAttr;
+in vec2 speedAttr;
+in uint flagAttr;
+in vec4 colAttr;
+
+uniform mat4 cameraMatrix;
+uniform mat4 worldMatrix;
+uniform float radius;
+
+out vec4 pos;
+out float speed;
+flat out uint flag;
+out vec4 col;
+
+void main()
+{
+  pos = radius * vec4(cornerAttr, 0, 0);
+  speed = length(speedAttr);
+  col = colAttr;
+  flag = flagAttr;
+  gl_Position = cameraMatrix * worldMatrix * (vec4(posAttr, 0, 1) + pos);
+}
@@ -0,0 +1,30 @@
+#version 330 core
+
+// squares of half side radius like the square poly, sizes above the implementation point size range are clamped
+
+in vec2 posAttr;
+in vec2 speedAttr;
+in uint flagAttr;
+in vec4 colAttr;
+
+uniform mat4 cameraMatrix;
+uniform mat4 worldMatrix;
+uniform float radius;
+uniform float viewportWidth;
+
+out float speed;
+flat out uint flag;
+out vec4 col;
+
+void main()
+{
+  speed = length(speedAttr);
+  col = colAttr;
+  flag = flagAttr;
+
+  mat4 matrix = cameraMatrix * worldMatrix;
+  vec4 center = matrix * vec4(posAttr, 0, 1);
+  vec4 side = matrix * vec4(posAttr + vec2(radius, 0), 0, 1);
+  gl_Position = center;
+  gl_PointSize = viewportWidth * length(side.xy / side.w - center.xy / center.w);
+}
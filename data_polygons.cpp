@@ -23,14 +23,82 @@ bool polygons::isForeground(const Color& aa)
     return colorDistance(aa, foreground_color) == 0;
 }
 
+bool polygons::isWater(const Color& aa)
+{
+    const polygons::Color water_color { 0, 1, 1, 1 };
+    return colorDistance(aa, water_color) == 0;
+}
+
+bool polygons::isCrate(const Color& aa)
+{
+    const polygons::Color crate_color { 1, 128 / 255.f, 0, 1 };
+    return colorDistance(aa, crate_color) < 1e-3;
+}
+
 size_t polygons::PolyHasher::operator()(const Poly& poly) const
+{
+    return (*this)(poly.data(), poly.size());
+}
+
+size_t polygons::PolyHasher::operator()(const b2Vec2* points, const size_t count) const
 {
     size_t seed = 0x1fac1e5b;
-    for (const auto& point : poly)
+    for (size_t kk=0; kk<count; kk++)
     {
-        hash_combine(seed, point.x);
-        hash_combine(seed, point.y);
+        hash_combine(seed, points[kk].x);
+        hash_combine(seed, points[kk].y);
     }
     return seed;
 }
 
+void polygons::PolySoup::clear()
+{
+    vertices.clear();
+    offsets.assign(1, 0);
+    colors.clear();
+}
+
+void polygons::PolySoup::push(const b2Vec2* points, const size_t count, const Color& color)
+{
+    vertices.insert(std::end(vertices), points, points + count);
+    offsets.emplace_back(vertices.size());
+    colors.emplace_back(color);
+}
+
+void polygons::PolySoup::append(const PolySoup& other)
+{
+    const auto base = vertices.size();
+    vertices.insert(std::end(vertices), std::cbegin(other.vertices), std::cend(other.vertices));
+    for (size_t kk=1; kk<other.offsets.size(); kk++)
+        offsets.emplace_back(base + other.offsets[kk]);
+    colors.insert(std::end(colors), std::cbegin(other.colors), std::cend(other.colors));
+}
+
+bool polygons::PolySoup::operator==(const PolySoup& other) const
+{
+    if (vertices.size() != other.vertices.size() || offsets != other.offsets || colors.size() != other.colors.size())
+        return false;
+    for (size_t kk=0; kk<vertices.size(); kk++)
+        if (!(vertices[kk] == other.vertices[kk]))
+            return false;
+    for (size_t kk=0; kk<colors.size(); kk++)
+        if (colors[kk].x != other.colors[kk].x || colors[kk].y != other.colors[kk].y || colors[kk].z != other.colors[kk].z || colors[kk].w != other.colors[kk].w)
+            return false;
+    return true;
+}
+
+bool polygons::UniquePolySoup::push(const Poly& poly, const Color& color)
+{
+    const auto hash = PolyHasher()(poly);
+    const auto range = hashes.equal_range(hash);
+    for (auto iter=range.first; iter!=range.second; iter++)
+    {
+        const auto kk = iter->second;
+        if (soup.count(kk) == poly.size() && std::equal(std::cbegin(poly), std::cend(poly), soup.begin(kk)))
+            return false;
+    }
+    hashes.emplace(hash, soup.size());
+    soup.push(poly, color);
+    return true;
+}
+
@@ -3,6 +3,7 @@
 #include <Box2D/Common/b2Math.h>
 
 #include <vector>
+#include <cstdint>
 #include <unordered_map>
 #include <unordered_set>
 #include <tuple>
@@ -14,6 +15,8 @@ namespace polygons
 using Color = b2Vec4;
 
 bool isForeground(const Color& aa);
+bool isWater(const Color& aa);
+bool isCrate(const Color& aa);
 //float colorDistance(const Color& aa, const Color& bb);
 
 using Poly = std::vector<b2Vec2>;
@@ -21,10 +24,41 @@ using Poly = std::vector<b2Vec2>;
 struct PolyHasher
 {
     size_t operator()(const Poly& poly) const;
+    size_t operator()(const b2Vec2* points, const size_t count) const;
 };
 
+// polygons stored back to back, polygon kk spans vertices [offsets[kk], offsets[kk + 1]) and has colors[kk]
+struct PolySoup
+{
+    std::vector<b2Vec2> vertices;
+    std::vector<uint32_t> offsets = { 0 };
+    std::vector<Color> colors;
+
+    size_t size() const { return colors.size(); }
+    bool empty() const { return colors.empty(); }
+    size_t count(const size_t kk) const { return offsets[kk + 1] - offsets[kk]; }
+    const b2Vec2* begin(const size_t kk) const { return vertices.data() + offsets[kk]; }
+    const b2Vec2* end(const size_t kk) const { return vertices.data() + offsets[kk + 1]; }
+    b2Vec2* begin(const size_t kk) { return vertices.data() + offsets[kk]; }
+    b2Vec2* end(const size_t kk) { return vertices.data() + offsets[kk + 1]; }
+    Poly poly(const size_t kk) const { return Poly(begin(kk), end(kk)); }
+
+    void clear();
+    void push(const b2Vec2* points, const size_t count, const Color& color = { 0, 0, 0, 1 });
+    void push(const Poly& poly, const Color& color = { 0, 0, 0, 1 }) { push(poly.data(), poly.size(), color); }
+    void append(const PolySoup& other);
+
+    bool operator==(const PolySoup& other) const;
+};
+
+// soup without exact duplicates, the first color pushed wins
+struct UniquePolySoup
+{
+    PolySoup soup;
+    std::unordered_multimap<size_t, uint32_t> hashes; // polygon hash to soup index
 
-using PolyToColors = std::unordered_map<Poly, Color, PolyHasher>;
+    bool push(const Poly& poly, const Color& color); // false when already present
+};
 
 }
 
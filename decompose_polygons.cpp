@@ -1,9 +1,13 @@
 #include "decompose_polygons.h"
 
+#include "partition_polygons.h"
+
 #include <acd2d_core.h>
 #include <acd2d_concavity.h>
 #include <acd2d_edge_visibility.h>
 
+#include <algorithm>
+
 class StraightMesure : public acd2d::IConcavityMeasure
 {
     public:
@@ -45,36 +49,42 @@ double StraightMesure::findDist(const acd2d::Vector2d& n, const acd2d::Point2d&
 
 ///////////////////////////////////////////////////////////////////////////////
 
-polygons::Poly
-polygons::ensure_cw(const polygons::Poly& vertices)
+void
+polygons::ensure_cw(b2Vec2* vertices, const size_t count)
 {
-    if (vertices.size() < 3)
-        return vertices;
+    if (count < 3)
+        return;
 
     using Scalar = decltype(b2Vec2::x);
 
     Scalar area = 0;
-    for (size_t kk=0, kk_max=vertices.size(); kk<kk_max; kk++)
+    for (size_t kk=0; kk<count; kk++)
     {
-        const auto kk_next = (kk + 1) % kk_max;
+        const auto kk_next = (kk + 1) % count;
         const auto pp = vertices[kk];
         const auto pp_next = vertices[kk_next];
         area += b2Cross(pp, pp_next);
     }
 
     if (area >= 0)
-        return vertices;
+        return;
 
-    Poly vertices_;
-    vertices_.reserve(vertices.size());
-    std::copy(std::crbegin(vertices), std::crend(vertices), std::back_inserter(vertices_));
-
-    return vertices_;
+    std::reverse(vertices, vertices + count);
 }
 
-std::list<polygons::Poly>
-polygons::decompose(const polygons::Poly& vertices, const double margin)
+polygons::PolySoup
+polygons::decompose(const b2Vec2* vertices, const size_t count, const double margin, const Decomposition method)
 {
+    switch (method)
+    {
+        case Decomposition::ear_clipping:
+            return decompose_ear_clipping(vertices, count);
+        case Decomposition::bayazit:
+            return decompose_bayazit(vertices, count);
+        case Decomposition::acd2d:
+            break;
+    }
+
     using Poly = acd2d::cd_poly;
     using Polygon = acd2d::cd_polygon;
     using Decomposition = acd2d::cd_2d;
@@ -82,17 +92,21 @@ polygons::decompose(const polygons::Poly& vertices, const double margin)
     using Measure = StraightMesure;
     using Scalar = decltype(b2Vec2::x);
 
-    assert(vertices.size() > 2);
+    assert(count > 2);
 
-    if (vertices.size() == 3)
-        return { vertices };
+    polygons::PolySoup subpolys;
+    if (count == 3)
+    {
+        subpolys.push(vertices, count);
+        return subpolys;
+    }
 
     Polygon polygon;
     {
         Poly poly(Poly::POUT);
         poly.beginPoly();
-        for (const auto& point : vertices)
-            poly.addVertex(point.x, point.y);
+        for (size_t kk=0; kk<count; kk++)
+            poly.addVertex(vertices[kk].x, vertices[kk].y);
         poly.endPoly();
         //poly.scale(1);
         polygon.emplace_back(poly);
@@ -107,25 +121,25 @@ polygons::decompose(const polygons::Poly& vertices, const double margin)
     decomp.decomposeAll(margin, &measure);
     assert(decomp.getTodoList().empty());
 
-    std::list<polygons::Poly> subpolys;
     for (const Polygon& subpolygon : decomp.getDoneList())
     {
         assert(subpolygon.size() == 1);
         const auto& subpoly = subpolygon.front();
 
-        polygons::Poly subpoly_;
+        // written straight into the soup, the offset closes the piece
         const auto head = subpoly.getHead();
         auto ptr = head;
         do
         {
             assert(ptr);
             const auto& position = ptr->getPos();
-            subpoly_.emplace_back(b2Vec2 { static_cast<Scalar>(position[0]), static_cast<Scalar>(position[1]) });
+            subpolys.vertices.emplace_back(b2Vec2 { static_cast<Scalar>(position[0]), static_cast<Scalar>(position[1]) });
             ptr=ptr->getNext();
         }
         while (ptr != head);
 
-        subpolys.emplace_back(subpoly_);
+        subpolys.offsets.emplace_back(subpolys.vertices.size());
+        subpolys.colors.emplace_back(polygons::Color { 0, 0, 0, 1 });
     }
 
     return subpolys;
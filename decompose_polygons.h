@@ -2,16 +2,28 @@
 
 #include "data_polygons.h"
 
-#include <list>
+#include <array>
 
 namespace polygons
 {
 
-std::list<Poly>
-decompose(const Poly& vertices, const double margin);
+enum class Decomposition : uint8_t
+{
+    acd2d, // approximate, pieces may stay concave up to margin
+    ear_clipping, // ear clipping and hertel-mehlhorn, see partition_polygons.h
+    bayazit,
+};
+
+// level json names, in enum order
+constexpr std::array<const char*, 3> decomposition_names = {{ "acd2d", "ear_clipping", "bayazit" }};
+
+// convex pieces of a single clockwise polygon, appended to a fresh soup, margin only applies to acd2d
+PolySoup
+decompose(const b2Vec2* vertices, const size_t count, const double margin, const Decomposition method = Decomposition::acd2d);
 
-Poly
-ensure_cw(const Poly& vertices);
+// reverses the range in place when it winds counter clockwise
+void
+ensure_cw(b2Vec2* vertices, const size_t count);
 
 }
 
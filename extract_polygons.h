@@ -5,7 +5,9 @@
 namespace polygons
 {
 
-std::tuple<PolyToColors, PolyToColors> extract(const std::string& filename);
+// reads files and qt resources alike with QFile, see parse_svg,
+// curves are flattened until no point strays more than tolerance from them in the unit square
+std::tuple<PolySoup, PolySoup> extract(const std::string& filename, const float tolerance);
 
 }
 
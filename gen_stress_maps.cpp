@@ -0,0 +1,227 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <vector>
+#include <string>
+#include <tuple>
+#include <cmath>
+#include <cassert>
+
+// world space like GameState, the svg unit square spans 600 world units centered on x = 0 with y = .25 at the origin
+constexpr double world_scale = 600;
+constexpr double cave_x = 0;
+constexpr double cave_y = -150;
+constexpr double cave_radius = 200; // mean radius of the cave wall
+constexpr double frame_radius = 285; // outer edge of the wall pieces
+constexpr double island_ring = 110; // distance of the islands to the cave center
+constexpr double door_ring = 155; // between the islands and the cave wall
+
+using Point = std::tuple<double, double>;
+using Outline = std::vector<Point>;
+
+struct StressOptions
+{
+    size_t vertices = 1000; // foreground vertices, walls and islands
+    size_t polygons = 16; // wall pieces around the cave, at least 2
+    size_t holes = 4; // rock islands inside the cave
+    size_t doors = 4;
+    unsigned int seed = 0;
+};
+
+// smooth noise keeps outlines star shaped, per vertex jitter is bounded by the vertex spacing so edges never cross
+static double wall_radius(const double angle, const std::vector<double>& phases)
+{
+    return cave_radius * (1 + .08 * std::sin(3 * angle + phases[0]) + .04 * std::sin(7 * angle + phases[1]) + .02 * std::sin(13 * angle + phases[2]));
+}
+
+static Point cave_point(const double angle, const double radius)
+{
+    return Point { cave_x + radius * std::cos(angle), cave_y + radius * std::sin(angle) };
+}
+
+static void write_path(std::ostream& os, const Outline& outline, const std::string& color)
+{
+    assert(outline.size() >= 3);
+    os << "  <path style=\"fill:" << color << ";stroke:none\" d=\"M";
+    for (const auto& point : outline)
+        os << " " << (std::get<0>(point) / world_scale + .5) << "," << (.25 - std::get<1>(point) / world_scale);
+    os << " Z\" />" << std::endl;
+}
+
+// writes the svg and returns the level json entry, doors are spread on a ring between the islands and the wall
+static std::string generate(const std::string& output_dir, const std::string& name, const StressOptions& options, double& density)
+{
+    assert(options.polygons >= 2);
+
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<double> unit(0, 1);
+    const auto pi = std::acos(-1.);
+
+    std::vector<double> phases;
+    for (auto kk=0; kk<3; kk++)
+        phases.emplace_back(2 * pi * unit(rng));
+
+    // vertices are spread evenly along the cave wall and island outlines, the outer arcs are kept coarse
+    const double island_radius = std::min(20., .3 * 2 * pi * island_ring / std::max<size_t>(options.holes, 1));
+    const size_t arc_count = 8; // outer arc vertices per wall piece
+    const double length = 2 * pi * cave_radius + options.holes * 2 * pi * island_radius;
+    const auto budget = options.vertices > options.polygons * arc_count ? options.vertices - options.polygons * arc_count : 0;
+    density = std::max(budget / length, 1e-3);
+
+    std::vector<Outline> walls;
+    const size_t inner_count = std::max<size_t>(2, std::lround(density * 2 * pi * cave_radius / options.polygons));
+    for (size_t ll=0; ll<options.polygons; ll++)
+    {
+        const auto start = 2 * pi * ll / options.polygons;
+        const auto stop = 2 * pi * (ll + 1) / options.polygons;
+        const auto spacing = (stop - start) * cave_radius / inner_count;
+
+        // shared end points without jitter so that neighbour pieces meet exactly
+        Outline wall;
+        for (size_t kk=0; kk<=inner_count; kk++)
+        {
+            const auto angle = start + (stop - start) * kk / inner_count;
+            const auto jitter = kk == 0 || kk == inner_count ? 0 : .4 * spacing * (2 * unit(rng) - 1);
+            wall.emplace_back(cave_point(angle, wall_radius(angle, phases) + jitter));
+        }
+        for (size_t kk=0; kk<arc_count; kk++)
+        {
+            const auto angle = stop + (start - stop) * kk / (arc_count - 1);
+            wall.emplace_back(cave_point(angle, frame_radius));
+        }
+        walls.emplace_back(std::move(wall));
+    }
+
+    std::vector<Outline> islands;
+    const size_t island_count = std::max<size_t>(8, std::lround(density * 2 * pi * island_radius));
+    for (size_t ll=0; ll<options.holes; ll++)
+    {
+        const auto center_angle = 2 * pi * (ll + .5) / options.holes;
+        const auto center_x = cave_x + island_ring * std::cos(center_angle);
+        const auto center_y = cave_y + island_ring * std::sin(center_angle);
+        const auto phase = 2 * pi * unit(rng);
+        const auto spacing = 2 * pi * island_radius / island_count;
+
+        Outline island;
+        for (size_t kk=0; kk<island_count; kk++)
+        {
+            const auto angle = 2 * pi * kk / island_count;
+            const auto radius = island_radius * (1 + .15 * std::sin(3 * angle + phase)) + .4 * spacing * (2 * unit(rng) - 1);
+            island.emplace_back(center_x + radius * std::cos(angle), center_y + radius * std::sin(angle));
+        }
+        islands.emplace_back(std::move(island));
+    }
+
+    {
+        std::ofstream svg(output_dir + "/" + name + ".svg");
+        assert(svg.good());
+        svg << std::setprecision(9);
+        svg << "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>" << std::endl;
+        svg << "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"800\" height=\"800\" viewBox=\"0 0 1 1\">" << std::endl;
+        svg << "  <rect style=\"fill:#6cc3f6;stroke:none\" x=\"0\" y=\"0\" width=\"1\" height=\"1\" />" << std::endl;
+        for (const auto& wall : walls)
+            write_path(svg, wall, "#000000");
+        for (const auto& island : islands)
+            write_path(svg, island, "#000000");
+        svg << "</svg>" << std::endl;
+    }
+
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(2);
+    json << "    {" << std::endl;
+    json << "      \"name\": \"" << name << "\"," << std::endl;
+    json << "      \"map\": \":/levels/" << name << ".svg\"," << std::endl;
+    json << "      \"world_camera_x\": " << cave_x << ", \"world_camera_y\": " << cave_y << ", \"world_screen_height\": " << 2 * frame_radius + 40 << "," << std::endl;
+    json << "      \"ship_spawn_x\": " << cave_x << ", \"ship_spawn_y\": " << cave_y << "," << std::endl;
+    json << "      \"ball_spawn_x\": " << cave_x + 20 << ", \"ball_spawn_y\": " << cave_y << "," << std::endl;
+    json << "      \"crate_spawn_x\": " << cave_x - 20 << ", \"crate_spawn_y\": " << cave_y << "," << std::endl;
+    json << "      \"water_spawn_x\": " << cave_x << ", \"water_spawn_y\": " << cave_y + 40 << "," << std::endl;
+    json << "      \"water_drop_width\": 60, \"water_drop_height\": 30," << std::endl;
+    json << "      \"doors\": [";
+    for (size_t ll=0; ll<options.doors; ll++)
+    {
+        const auto angle = 2 * pi * ll / options.doors;
+        const auto center = cave_point(angle, door_ring);
+        json << (ll ? "," : "") << std::endl;
+        json << "        { \"cx\": " << std::get<0>(center) << ", \"cy\": " << std::get<1>(center);
+        json << ", \"dx\": " << -20 * std::cos(angle) << ", \"dy\": " << -20 * std::sin(angle) << ", \"width\": 2, \"height\": 10 }";
+    }
+    json << std::endl << "      ]" << std::endl;
+    json << "    }";
+
+    return json.str();
+}
+
+// writes stress levels of growing vertex count in output_dir: one svg per level, a levels.json
+// that rocket output_dir can watch and a run_stress.sh that times each pipeline stage with bench_pipeline
+int main(int argc, char* argv[])
+{
+    using std::cout;
+    using std::endl;
+    using std::setw;
+
+    if (argc < 2)
+    {
+        cout << "usage: " << argv[0] << " output_dir [max_vertices] [polygons] [holes] [doors] [seed]" << endl;
+        return 1;
+    }
+
+    const std::string output_dir = argv[1];
+    const size_t max_vertices = argc > 2 ? std::stoul(argv[2]) : 100000;
+    StressOptions options;
+    options.polygons = argc > 3 ? std::max<size_t>(2, std::stoul(argv[3])) : options.polygons;
+    options.holes = argc > 4 ? std::stoul(argv[4]) : options.holes;
+    options.doors = argc > 5 ? std::stoul(argv[5]) : options.doors;
+    options.seed = argc > 6 ? std::stoul(argv[6]) : options.seed;
+
+    // decades up to max_vertices
+    std::vector<size_t> vertex_counts;
+    for (size_t count=1000; count<max_vertices; count*=10)
+        vertex_counts.emplace_back(count);
+    vertex_counts.emplace_back(max_vertices);
+
+    cout << std::fixed << std::setprecision(2);
+    cout << setw(14) << "level" << setw(10) << "vertices" << setw(10) << "polygons" << setw(8) << "holes" << setw(8) << "doors" << setw(10) << "density" << endl;
+
+    std::vector<std::string> entries;
+    for (const auto& vertex_count : vertex_counts)
+    {
+        options.vertices = vertex_count;
+        const auto name = "stress" + std::to_string(vertex_count);
+        double density = 0;
+        entries.emplace_back(generate(output_dir, name, options, density));
+        cout << setw(14) << name << setw(10) << vertex_count << setw(10) << options.polygons << setw(8) << options.holes << setw(8) << options.doors << setw(10) << density << endl;
+    }
+
+    {
+        std::ofstream json(output_dir + "/levels.json");
+        assert(json.good());
+        json << "{" << endl;
+        json << "  \"default_level\": 0," << endl;
+        json << "  \"levels\": [" << endl;
+        for (size_t kk=0; kk<entries.size(); kk++)
+            json << entries[kk] << (kk + 1 < entries.size() ? "," : "") << endl;
+        json << "  ]" << endl;
+        json << "}" << endl;
+    }
+
+    {
+        std::ofstream script(output_dir + "/run_stress.sh");
+        assert(script.good());
+        script << "#!/bin/sh" << endl;
+        script << "# generated by gen_stress_maps, polygons " << options.polygons << " holes " << options.holes << " doors " << options.doors << " seed " << options.seed << endl;
+        script << "# times extract, decomposition, resetGround and particle steps of every level, one level per run" << endl;
+        script << "# usage: sh run_stress.sh [seconds], BENCH_PIPELINE points to the bench_pipeline binary" << endl;
+        script << "set -e" << endl;
+        script << "bench=\"${BENCH_PIPELINE:-./bench_pipeline}\"" << endl;
+        script << "dir=\"$(dirname \"$0\")\"" << endl;
+        for (size_t kk=0; kk<entries.size(); kk++)
+            script << "\"$bench\" \"$dir/levels.json\" " << kk << " \"${1:-2}\" | tail -n " << (kk ? 1 : 2) << endl;
+    }
+
+    cout << "wrote " << vertex_counts.size() << " levels to " << std::quoted(output_dir) << endl;
+
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include "gl_utils.h"
+
+#include <QOpenGLContext>
+#include <QFile>
+
+#include <iostream>
+#include <iomanip>
+#include <cassert>
+
+void gl_utils::assert_no_error(QOpenGLFunctions& gl)
+{
+#if !defined(NDEBUG)
+    const auto gl_error = gl.glGetError();
+
+    using std::cerr;
+    using std::endl;
+
+    switch (gl_error)
+    {
+        default:
+        case GL_NO_ERROR:
+            break;
+        case GL_INVALID_ENUM:
+            cerr << "GL_INVALID_ENUM" << endl;
+            cerr << "An unacceptable value is specified for an enumerated argument. The offending command is ignored and has no other side effect than to set the error flag." << endl;
+            break;
+        case GL_INVALID_VALUE:
+            cerr << "GL_INVALID_VALUE" << endl;
+            cerr << "A numeric argument is out of range. The offending command is ignored and has no other side effect than to set the error flag." << endl;
+            break;
+        case GL_INVALID_OPERATION:
+            cerr << "GL_INVALID_OPERATION" << endl;
+            cerr << "The specified operation is not allowed in the current state. The offending command is ignored and has no other side effect than to set the error flag." << endl;
+            break;
+        case GL_INVALID_FRAMEBUFFER_OPERATION:
+            cerr << "GL_INVALID_FRAMEBUFFER_OPERATION" << endl;
+            cerr << "The framebuffer object is not complete. The offending command is ignored and has no other side effect than to set the error flag." << endl;
+            break;
+        case GL_OUT_OF_MEMORY:
+            cerr << "GL_OUT_OF_MEMORY" << endl;
+            cerr << "There is not enough memory left to execute the command. The state of the GL is undefined, except for the state of the error flags, after this error is recorded." << endl;
+            break;
+        case GL_STACK_UNDERFLOW:
+            cerr << "GL_STACK_UNDERFLOW" << endl;
+            cerr << "An attempt has been made to perform an operation that would cause an internal stack to underflow." << endl;
+            break;
+        case GL_STACK_OVERFLOW:
+            cerr << "GL_STACK_OVERFLOW" << endl;
+            cerr << "An attempt has been made to perform an operation that would cause an internal stack to overflow." << endl;
+            break;
+    }
+#endif
+
+    assert(gl_error == GL_NO_ERROR);
+}
+
+std::unique_ptr<QOpenGLShaderProgram> gl_utils::load_program(const std::string& vertex_filename, const std::string& fragment_filename, const std::string& geometry_filename, const std::vector<std::string>& defines)
+{
+    using std::cerr;
+    using std::cout;
+    using std::endl;
+
+    cout << "========== compile shader" << endl;
+    auto program = std::make_unique<QOpenGLShaderProgram>();
+
+    const auto load_shader = [&program, &defines](const QOpenGLShader::ShaderType type, const std::string& filename) -> bool
+    {
+        cout << "compiling ";
+        switch (type)
+        {
+            case QOpenGLShader::Vertex:
+                cout << "vertex ";
+                break;
+            case QOpenGLShader::Geometry:
+                cout << "geometry ";
+                break;
+            case QOpenGLShader::Fragment:
+                cout << "fragment ";
+                break;
+            default:
+                assert(false);
+                break;
+        };
+        cout << std::quoted(filename) << " ";
+        cout.flush();
+
+        QFile handle(QString::fromStdString(filename));
+        if (!handle.open(QIODevice::ReadOnly))
+            return false;
+        auto source = handle.readAll();
+        for (const auto& define : defines)
+        {
+            cout << define << " ";
+            source.insert(source.indexOf('\n') + 1, QByteArray::fromStdString("#define " + define + "\n"));
+        }
+        const auto compile_ok = program->addShaderFromSourceCode(type, source);
+
+        cout << (compile_ok ? "OK" : "ERROR") << endl;
+
+        return compile_ok;
+    };
+
+    const auto vertex_load_ok = load_shader(QOpenGLShader::Vertex, vertex_filename);
+    const auto geometry_load_ok = geometry_filename.empty() ? true : load_shader(QOpenGLShader::Geometry, geometry_filename);
+    const auto fragment_load_ok = load_shader(QOpenGLShader::Fragment, fragment_filename);
+
+    cout << "linking ";
+    cout.flush();
+    const auto link_ok = program->link();
+    cout << (link_ok ? "OK" : "ERROR") << endl;
+
+    auto& gl = *QOpenGLContext::currentContext()->functions();
+    const auto gl_ok = gl.glGetError() == GL_NO_ERROR;
+    const auto all_ok = vertex_load_ok && fragment_load_ok && geometry_load_ok && link_ok && gl_ok;
+    if (!all_ok) {
+        cerr << program->log().toStdString() << endl;
+        return nullptr;
+    }
+    assert_no_error(gl);
+    assert(all_ok);
+
+    return program;
+}
+
+bool gl_utils::init_locations(const QOpenGLShaderProgram& program, const Locations& attr_locations, const Locations& unif_locations)
+{
+    using std::cout;
+    using std::endl;
+
+    cout << "========== init locations" << endl;
+
+    bool found_all = true;
+
+    for (auto& pair : attr_locations)
+    {
+        cout << "attr " << std::quoted(pair.first) << " ";
+        cout.flush();
+
+        pair.second = program.attributeLocation(QString::fromStdString(pair.first));
+        const bool found = pair.second >= 0;
+        cout << (found ? "OK": "ERROR") << endl;
+
+        found_all &= found;
+    }
+
+    for (auto& pair : unif_locations)
+    {
+        cout << "unif " << std::quoted(pair.first) << " ";
+        cout.flush();
+
+        pair.second = program.uniformLocation(QString::fromStdString(pair.first));
+        const bool found = pair.second >= 0;
+        cout << (found ? "OK": "ERROR") << endl;
+
+        found_all &= found;
+    }
+
+    return found_all;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QOpenGLFunctions>
+#include <QOpenGLShaderProgram>
+
+#include <unordered_map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// helpers that only need a current context, shared by the windows and the offscreen benches
+namespace gl_utils
+{
+
+// prints the pending error in debug builds
+void assert_no_error(QOpenGLFunctions& gl);
+
+// defines are inserted after the version line of every stage, nullptr when a stage fails
+std::unique_ptr<QOpenGLShaderProgram> load_program(const std::string& vertex_filename, const std::string& fragment_filename, const std::string& geometry_filename = "", const std::vector<std::string>& defines = {});
+
+using Locations = std::unordered_map<std::string, int&>;
+bool init_locations(const QOpenGLShaderProgram& program, const Locations& attr_locations, const Locations& unif_locations);
+
+}
@@ -0,0 +1,211 @@
+#include "ground_polygons.h"
+
+#include "extract_polygons.h"
+#include "decompose_polygons.h"
+#include "simplify_polygons.h"
+#include "merge_polygons.h"
+#include "ThreadPool.h"
+
+#include <iostream>
+#include <iomanip>
+#include <cassert>
+#include <algorithm>
+
+b2Vec2 polygons::foreground_transform(const b2Vec2& point)
+{
+    const b2Vec2 point_ { point.x - .5f , .25f - point.y };
+    return world_scale * point_;
+}
+
+void polygons::foreground_transform(PolySoup& soup)
+{
+    for (auto& point : soup.vertices)
+        point = foreground_transform(point);
+
+    // the flip mirrors the winding, reversing restores a positive area
+    for (size_t kk=0; kk<soup.size(); kk++)
+        std::reverse(soup.begin(kk), soup.end(kk));
+}
+
+bool polygons::operator==(const GroundOptions& aa, const GroundOptions& bb)
+{
+    return aa.flatten_tolerance == bb.flatten_tolerance &&
+        aa.simplify_tolerance == bb.simplify_tolerance &&
+        aa.merge_pieces == bb.merge_pieces &&
+        aa.min_piece_area == bb.min_piece_area &&
+        aa.use_chains == bb.use_chains &&
+        aa.decomposition == bb.decomposition;
+}
+
+bool polygons::GroundCache::find(const std::string& map_filename, const GroundOptions& options, const uint8_t kind, const b2Vec2* points, const size_t count, Simplified& result) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const auto entries = maps.find(map_filename);
+    if (entries == std::cend(maps) || !(entries->second.options == options))
+        return false;
+
+    const auto range = entries->second.items.equal_range(PolyHasher()(points, count));
+    for (auto iter=range.first; iter!=range.second; iter++)
+    {
+        const auto& item = iter->second;
+        const auto& poly = std::get<1>(item);
+        if (std::get<0>(item) != kind || poly.size() != count || !std::equal(std::cbegin(poly), std::cend(poly), points))
+            continue;
+        result = std::get<2>(item);
+        return true;
+    }
+
+    return false;
+}
+
+void polygons::GroundCache::store(const std::string& map_filename, const GroundOptions& options, std::vector<Item>&& items)
+{
+    Entries entries;
+    entries.options = options;
+    for (auto& item : items)
+    {
+        const auto hash = PolyHasher()(std::get<1>(item));
+        entries.items.emplace(hash, std::move(item));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    maps[map_filename] = std::move(entries);
+}
+
+size_t polygons::GroundCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t count = 0;
+    for (const auto& entries : maps)
+        count += entries.second.items.size();
+    return count;
+}
+
+polygons::Ground polygons::build_ground(const std::string& map_filename, const GroundOptions& options, GroundCache* cache)
+{
+    return build_ground(map_filename, options, ThreadPool::global(), cache);
+}
+
+polygons::Ground polygons::build_ground(const std::string& map_filename, const GroundOptions& options, ThreadPool& pool, GroundCache* cache)
+{
+    using std::cout;
+    using std::endl;
+    using std::get;
+
+    cout << "** svg loading" << endl;
+    cout << "filename " << std::quoted(map_filename) << endl;
+
+    const auto polys = extract(map_filename, options.flatten_tolerance / world_scale);
+    const auto& brush_polys = std::get<1>(polys);
+
+    enum Kind { foreground, water, crate };
+
+    // tolerance and area are given in world units, extraction works in the svg unit square
+    const auto tolerance = options.simplify_tolerance / world_scale;
+    const auto min_area = options.min_piece_area / (world_scale * world_scale);
+
+    // each decomposition builds its own acd2d instance, cached results come as ready futures
+    std::vector<std::tuple<Kind, size_t, std::future<Simplified>>> jobs;
+    std::vector<size_t> job_polys; // index in brush_polys
+    size_t cache_hit_count = 0;
+    for (size_t kk=0; kk<brush_polys.size(); kk++)
+    {
+        const auto& color = brush_polys.colors[kk];
+        const bool is_foreground = isForeground(color);
+        const bool is_water = isWater(color);
+        const bool is_crate = isCrate(color);
+        if (!is_foreground && !is_water && !is_crate)
+            continue;
+        const auto kind = is_foreground ? foreground : is_water ? water : crate;
+        job_polys.emplace_back(kk);
+
+        Simplified cached;
+        if (cache && cache->find(map_filename, options, kind, brush_polys.begin(kk), brush_polys.count(kk), cached))
+        {
+            std::promise<Simplified> promise;
+            promise.set_value(std::move(cached));
+            jobs.emplace_back(kind, brush_polys.count(kk), promise.get_future());
+            cache_hit_count++;
+            continue;
+        }
+
+        jobs.emplace_back(kind, brush_polys.count(kk), pool.submit([&brush_polys, kk, &options, kind, tolerance, min_area]() -> Simplified {
+            auto simplified = simplify(brush_polys.begin(kk), brush_polys.count(kk), tolerance);
+            ensure_cw(simplified.data(), simplified.size());
+            if (kind == foreground && options.use_chains)
+                return std::make_tuple(std::move(simplified), PolySoup(), 0);
+            auto subpolys = decompose(simplified.data(), simplified.size(), 1e-5, options.decomposition);
+            const auto decomposed_count = subpolys.size();
+            if (options.merge_pieces)
+                subpolys = merge_convex(subpolys, b2_maxPolygonVertices, min_area);
+            // b2PolygonShape keeps at most b2_maxPolygonVertices, acd2d pieces are not bounded
+            subpolys = split_convex(subpolys, b2_maxPolygonVertices);
+            return std::make_tuple(std::move(simplified), std::move(subpolys), decomposed_count);
+        }));
+    }
+
+    Ground ground;
+    ground.use_chains = options.use_chains;
+    size_t vertex_count = 0;
+    size_t simplified_vertex_count = 0;
+    size_t decomposed_count = 0;
+
+    std::vector<GroundCache::Item> cache_items;
+    cout << "foreground";
+    cout.flush();
+    for (size_t jj=0; jj<jobs.size(); jj++)
+    {
+        auto& job = jobs[jj];
+        auto simplified = get<2>(job).get();
+        if (cache)
+            cache_items.emplace_back(get<0>(job), brush_polys.poly(job_polys[jj]), simplified);
+
+        auto& subpolys = get<1>(simplified);
+        vertex_count += get<1>(job);
+        simplified_vertex_count += get<0>(simplified).size();
+
+        if (get<0>(job) == foreground)
+        {
+            decomposed_count += get<2>(simplified);
+            cout << " " << subpolys.size();
+            cout.flush();
+
+            ground.pieces.append(subpolys);
+            ground.outlines.push(get<0>(simplified));
+            continue;
+        }
+
+        // regions filled by GameState::fillRegions when no baked state is available
+        foreground_transform(subpolys);
+        (get<0>(job) == water ? ground.water_regions : ground.crate_regions).emplace_back(std::move(subpolys));
+    }
+    cout << endl;
+
+    if (cache)
+    {
+        cache->store(map_filename, options, std::move(cache_items));
+        cout << "cache " << cache_hit_count << " hits " << jobs.size() - cache_hit_count << " decomposed" << endl;
+    }
+
+    foreground_transform(ground.pieces);
+    foreground_transform(ground.outlines);
+
+    cout << "simplify " << options.simplify_tolerance << " " << vertex_count << " -> " << simplified_vertex_count << " vertices" << endl;
+    cout << "decomposition " << decomposition_names[static_cast<size_t>(options.decomposition)] << endl;
+    cout << "soup " << ground.pieces.vertices.size() << " piece vertices " << ground.outlines.vertices.size() << " outline vertices" << endl;
+    if (options.use_chains)
+        cout << "chains " << ground.outlines.size() << " loops" << endl;
+    else
+        cout << "merge " << (options.merge_pieces ? "on " : "off ") << decomposed_count << " -> " << ground.pieces.size() << " pieces" << endl;
+    cout << "regions " << ground.water_regions.size() << " water " << ground.crate_regions.size() << " crate" << endl;
+
+    { // svg extent
+        const auto aa = foreground_transform(b2Vec2 { 0, 0 });
+        const auto bb = foreground_transform(b2Vec2 { 1, 1 });
+        ground.lower = b2Min(aa, bb);
+        ground.upper = b2Max(aa, bb);
+    }
+
+    return ground;
+}
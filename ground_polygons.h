@@ -0,0 +1,77 @@
+#pragma once
+
+#include "data_polygons.h"
+#include "decompose_polygons.h"
+
+#include <mutex>
+
+class ThreadPool;
+
+namespace polygons
+{
+
+// everything GameState::resetGround needs from a map, in world space
+struct Ground
+{
+    using Region = PolySoup;
+    PolySoup pieces; // convex, counter clockwise, empty with chains
+    PolySoup outlines; // foreground polygons before decomposition, counter clockwise
+    std::vector<Region> water_regions;
+    std::vector<Region> crate_regions;
+    b2Vec2 lower = { 0, 0 }; // svg extent
+    b2Vec2 upper = { 0, 0 };
+    bool use_chains = false; // foreground collides through chain loops built from the outlines
+};
+
+// world units per svg unit square side
+constexpr float world_scale = 600;
+
+// per level, from the level json
+struct GroundOptions
+{
+    float flatten_tolerance = .05; // world units, largest distance between svg curves and their flattened outline
+    float simplify_tolerance = .25; // world units, zero keeps every extracted vertex
+    bool merge_pieces = true; // merge decomposed pieces up to b2_maxPolygonVertices
+    float min_piece_area = .01; // world units squared, smaller pieces left after merging are dropped
+    bool use_chains = false; // foreground is not decomposed, only water and crate regions are
+    Decomposition decomposition = Decomposition::acd2d;
+};
+
+bool operator==(const GroundOptions& aa, const GroundOptions& bb);
+
+// clockwise outline, convex pieces and decomposed piece count of one extracted polygon, svg unit square
+using Simplified = std::tuple<Poly, PolySoup, size_t>;
+
+// results of the last build of each map, extracted polygons are looked up by PolyHasher and compared exactly
+// so that a rebuild only decomposes the polygons that changed, shared by loading threads
+class GroundCache
+{
+    public:
+        using Item = std::tuple<uint8_t, Poly, Simplified>; // kind, extracted polygon, result
+
+        bool find(const std::string& map_filename, const GroundOptions& options, const uint8_t kind, const b2Vec2* points, const size_t count, Simplified& result) const;
+        void store(const std::string& map_filename, const GroundOptions& options, std::vector<Item>&& items); // replaces the previous build
+        size_t size() const;
+
+    protected:
+        struct Entries
+        {
+            GroundOptions options;
+            std::unordered_multimap<size_t, Item> items;
+        };
+
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Entries> maps;
+};
+
+// svg unit square to world, flips y which mirrors the winding,
+// the soup version also reverses each polygon so that a positive area in the svg square stays positive in the world
+b2Vec2 foreground_transform(const b2Vec2& point);
+void foreground_transform(PolySoup& soup);
+
+// polygons are simplified, decomposed and merged concurrently on the pool, results keep the extraction order,
+// polygons found in the cache are not decomposed again and the cache is updated with this build
+Ground build_ground(const std::string& map_filename, const GroundOptions& options, ThreadPool& pool, GroundCache* cache = nullptr);
+Ground build_ground(const std::string& map_filename, const GroundOptions& options = GroundOptions(), GroundCache* cache = nullptr);
+
+}
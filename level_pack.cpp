@@ -0,0 +1,449 @@
+#include "level_pack.h"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+
+// native endianness, the pack is baked and loaded on the same kind of machine
+constexpr uint32_t pack_magic = 0x4b504b52; // RKPK
+constexpr uint32_t pack_version = 9;
+
+static void hash_bytes(uint64_t& hash, const QByteArray& bytes)
+{
+    for (const auto& byte : bytes)
+    {
+        hash ^= static_cast<uint8_t>(byte);
+        hash *= 0x100000001b3;
+    }
+}
+
+uint64_t levels::source_hash(const std::string& json_filename, const MainData& data)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    const auto hash_file = [&hash](const std::string& filename) -> void
+    {
+        QFile handle(QString::fromStdString(filename));
+        const auto open_ok = handle.open(QIODevice::ReadOnly);
+        assert(open_ok);
+        hash_bytes(hash, handle.readAll());
+    };
+
+    hash_file(json_filename);
+    for (const auto& level : data.levels)
+        hash_file(level.map_filename);
+
+    return hash;
+}
+
+struct PackWriter
+{
+    std::ostream& os;
+
+    template <typename Type>
+    void pod(const Type& value)
+    {
+        os.write(reinterpret_cast<const char*>(&value), sizeof(Type));
+    }
+
+    template <typename Type>
+    void vector(const std::vector<Type>& values)
+    {
+        pod(static_cast<uint32_t>(values.size()));
+        os.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(Type));
+    }
+
+    void string(const std::string& value)
+    {
+        pod(static_cast<uint32_t>(value.size()));
+        os.write(value.data(), value.size());
+    }
+
+    void soup(const polygons::PolySoup& value)
+    {
+        vector(value.vertices);
+        vector(value.offsets);
+        vector(value.colors);
+    }
+
+    void regions(const std::vector<polygons::Ground::Region>& values)
+    {
+        pod(static_cast<uint32_t>(values.size()));
+        for (const auto& value : values)
+            soup(value);
+    }
+};
+
+// bounds checked cursor, ok turns false on the first overrun and reads return zeros from then on
+struct PackReader
+{
+    const uchar* data;
+    size_t size;
+    size_t pos = 0;
+    bool ok = true;
+
+    bool take(void* dest, const size_t count)
+    {
+        if (!count)
+            return ok;
+        ok &= count <= size - pos;
+        if (!ok)
+        {
+            std::memset(dest, 0, count);
+            return false;
+        }
+        std::memcpy(dest, data + pos, count);
+        pos += count;
+        return true;
+    }
+
+    template <typename Type>
+    Type pod()
+    {
+        Type value;
+        take(&value, sizeof(Type));
+        return value;
+    }
+
+    template <typename Type>
+    std::vector<Type> vector()
+    {
+        const auto count = pod<uint32_t>();
+        if (!ok || count > (size - pos) / sizeof(Type))
+        {
+            ok = false;
+            return {};
+        }
+        std::vector<Type> values(count);
+        take(values.data(), count * sizeof(Type));
+        return values;
+    }
+
+    std::string string()
+    {
+        const auto bytes = vector<char>();
+        return std::string(std::cbegin(bytes), std::cend(bytes));
+    }
+
+    // offsets must start at zero, never decrease and end on the vertex count
+    polygons::PolySoup soup()
+    {
+        polygons::PolySoup value;
+        value.vertices = vector<b2Vec2>();
+        value.offsets = vector<uint32_t>();
+        value.colors = vector<polygons::Color>();
+        ok &= !value.offsets.empty() && value.offsets.front() == 0 && value.offsets.back() == value.vertices.size();
+        ok &= value.colors.size() + 1 == value.offsets.size();
+        for (size_t kk=1; ok && kk<value.offsets.size(); kk++)
+            ok &= value.offsets[kk - 1] <= value.offsets[kk];
+        if (!ok)
+            return {};
+        return value;
+    }
+
+    std::vector<polygons::Ground::Region> regions()
+    {
+        std::vector<polygons::Ground::Region> values;
+        for (auto kk=pod<uint32_t>(); ok && kk; kk--)
+            values.emplace_back(soup());
+        return values;
+    }
+
+    // checks a vector in place and returns its count, the cursor moves past it
+    template <typename Type>
+    uint32_t skipVector()
+    {
+        const auto count = pod<uint32_t>();
+        ok &= count <= (size - pos) / sizeof(Type);
+        if (!ok)
+            return 0;
+        pos += count * sizeof(Type);
+        return count;
+    }
+
+    // same checks as soup without copying the vertices
+    void skipSoup()
+    {
+        const auto vertex_count = skipVector<b2Vec2>();
+        const auto offsets_pos = pos + sizeof(uint32_t);
+        const auto offset_count = skipVector<uint32_t>();
+        const auto color_count = skipVector<polygons::Color>();
+        ok &= offset_count > 0 && static_cast<size_t>(color_count) + 1 == offset_count;
+        uint32_t previous = 0;
+        for (uint32_t kk=0; ok && kk<offset_count; kk++)
+        {
+            uint32_t offset;
+            std::memcpy(&offset, data + offsets_pos + kk * sizeof(uint32_t), sizeof(uint32_t));
+            ok &= kk ? previous <= offset : offset == 0;
+            previous = offset;
+        }
+        ok &= previous == vertex_count;
+    }
+
+    void skipRegions()
+    {
+        for (auto kk=pod<uint32_t>(); ok && kk; kk--)
+            skipSoup();
+    }
+
+    // a ground block must be consumed exactly
+    void skipGround()
+    {
+        pod<b2Vec2>();
+        pod<b2Vec2>();
+        skipSoup();
+        skipSoup();
+        skipRegions();
+        skipRegions();
+        pod<uint8_t>();
+        ok &= pos == size;
+    }
+};
+
+void levels::write_pack(std::ostream& os, const MainData& data, const std::vector<polygons::Ground>& grounds, const uint64_t hash)
+{
+    using std::get;
+
+    assert(grounds.size() == data.levels.size());
+
+    PackWriter writer { os };
+    writer.pod(pack_magic);
+    writer.pod(pack_version);
+    writer.pod(hash);
+    writer.pod(static_cast<uint32_t>(data.levels.size()));
+    writer.pod(static_cast<int32_t>(data.default_level));
+
+    auto ground_iter = std::cbegin(grounds);
+    for (const auto& level : data.levels)
+    {
+        writer.string(level.name);
+        writer.string(level.map_filename);
+        writer.string(level.initial_state);
+
+        writer.pod(static_cast<uint32_t>(level.doors.size()));
+        for (const auto& door : level.doors)
+        {
+            writer.pod(get<0>(door));
+            writer.pod(get<1>(door));
+            writer.pod(get<2>(door));
+        }
+
+        writer.pod(static_cast<uint32_t>(level.paths.size()));
+        for (const auto& path : level.paths)
+        {
+            writer.vector(get<0>(path));
+            writer.pod(get<1>(path));
+        }
+
+        writer.pod(static_cast<uint32_t>(level.emitters.size()));
+        for (const auto& emitter : level.emitters)
+        {
+            writer.pod(get<0>(emitter));
+            writer.pod(get<1>(emitter));
+            writer.pod(get<2>(emitter));
+            writer.pod(get<3>(emitter));
+            writer.pod(get<4>(emitter));
+        }
+
+        writer.pod(level.world_camera_position);
+        writer.pod(level.world_screen_height);
+        writer.pod(level.ship_screen_height);
+        writer.pod(level.ship_spawn);
+        writer.pod(level.ball_spawn);
+        writer.pod(level.crate_spawn);
+        writer.pod(level.water_spawn);
+        writer.pod(level.water_drop_size);
+        writer.pod(static_cast<uint8_t>(level.has_world_bounds));
+        writer.pod(level.world_bounds_lower);
+        writer.pod(level.world_bounds_upper);
+        writer.pod(level.chunk_size);
+        writer.pod(level.ground_options);
+
+        { // ground block, prefixed by its size so that open can skip it
+            std::ostringstream block_os;
+            PackWriter block_writer { block_os };
+            const auto& ground = *ground_iter++;
+            block_writer.pod(ground.lower);
+            block_writer.pod(ground.upper);
+            block_writer.soup(ground.pieces);
+            block_writer.soup(ground.outlines);
+            block_writer.regions(ground.water_regions);
+            block_writer.regions(ground.crate_regions);
+            block_writer.pod(static_cast<uint8_t>(ground.use_chains));
+
+            const auto block = block_os.str();
+            writer.pod(static_cast<uint64_t>(block.size()));
+            os.write(block.data(), block.size());
+        }
+    }
+}
+
+levels::PackFile::~PackFile()
+{
+    close();
+}
+
+bool levels::PackFile::open(const std::string& filename, const uint64_t expected_hash)
+{
+    using std::cout;
+    using std::endl;
+    using std::get;
+
+    close();
+
+    cout << "** pack " << std::quoted(filename) << " ";
+
+    file.setFileName(QString::fromStdString(filename));
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        cout << "missing" << endl;
+        return false;
+    }
+
+    mapped_size = file.size();
+    mapped = file.map(0, mapped_size);
+    if (!mapped)
+    {
+        cout << "can't map" << endl;
+        close();
+        return false;
+    }
+
+    PackReader reader { mapped, mapped_size };
+    const auto magic = reader.pod<uint32_t>();
+    const auto version = reader.pod<uint32_t>();
+    const auto hash = reader.pod<uint64_t>();
+    if (!reader.ok || magic != pack_magic || version != pack_version)
+    {
+        cout << "invalid header" << endl;
+        close();
+        return false;
+    }
+    if (hash != expected_hash)
+    {
+        cout << "stale" << endl;
+        close();
+        return false;
+    }
+
+    const auto level_count = reader.pod<uint32_t>();
+    data.default_level = reader.pod<int32_t>();
+    for (uint32_t kk=0; reader.ok && kk<level_count; kk++)
+    {
+        LevelData level;
+        level.name = reader.string();
+        level.map_filename = reader.string();
+        level.initial_state = reader.string();
+
+        for (auto ll=reader.pod<uint32_t>(); reader.ok && ll; ll--)
+        {
+            const auto center = reader.pod<b2Vec2>();
+            const auto size = reader.pod<b2Vec2>();
+            const auto delta = reader.pod<b2Vec2>();
+            level.doors.emplace_back(LevelData::DoorData { center, size, delta });
+        }
+
+        for (auto ll=reader.pod<uint32_t>(); reader.ok && ll; ll--)
+        {
+            const auto positions = reader.vector<b2Vec2>();
+            const auto size = reader.pod<b2Vec2>();
+            level.paths.emplace_back(LevelData::PathData { positions, size });
+        }
+
+        for (auto ll=reader.pod<uint32_t>(); reader.ok && ll; ll--)
+        {
+            const auto position = reader.pod<b2Vec2>();
+            const auto size = reader.pod<b2Vec2>();
+            const auto velocity = reader.pod<b2Vec2>();
+            const auto rate = reader.pod<float>();
+            const auto lifetime = reader.pod<float>();
+            level.emitters.emplace_back(LevelData::EmitterData { position, size, velocity, rate, lifetime });
+        }
+
+        level.world_camera_position = reader.pod<b2Vec2>();
+        level.world_screen_height = reader.pod<float>();
+        level.ship_screen_height = reader.pod<float>();
+        level.ship_spawn = reader.pod<b2Vec2>();
+        level.ball_spawn = reader.pod<b2Vec2>();
+        level.crate_spawn = reader.pod<b2Vec2>();
+        level.water_spawn = reader.pod<b2Vec2>();
+        level.water_drop_size = reader.pod<b2Vec2>();
+        level.has_world_bounds = reader.pod<uint8_t>();
+        level.world_bounds_lower = reader.pod<b2Vec2>();
+        level.world_bounds_upper = reader.pod<b2Vec2>();
+        level.chunk_size = reader.pod<float>();
+        level.ground_options = reader.pod<polygons::GroundOptions>();
+
+        const auto ground_size = reader.pod<uint64_t>();
+        reader.ok &= ground_size <= mapped_size - reader.pos;
+        if (!reader.ok)
+            break;
+        PackReader ground_reader { mapped + reader.pos, static_cast<size_t>(ground_size) };
+        ground_reader.skipGround();
+        reader.ok &= ground_reader.ok;
+        if (!reader.ok)
+            break;
+        ground_ranges.emplace_back(reader.pos, ground_size);
+        reader.pos += ground_size;
+
+        data.levels.emplace_back(level);
+    }
+
+    if (!reader.ok || data.levels.size() != level_count)
+    {
+        cout << "truncated or corrupt" << endl;
+        close();
+        return false;
+    }
+
+    cout << data.levels.size() << " levels " << mapped_size / 1024 << "KiB" << endl;
+    return true;
+}
+
+void levels::PackFile::close()
+{
+    if (mapped)
+        file.unmap(const_cast<uchar*>(mapped));
+    mapped = nullptr;
+    mapped_size = 0;
+    file.close();
+    data = MainData();
+    ground_ranges.clear();
+}
+
+bool levels::PackFile::isOpen() const
+{
+    return mapped != nullptr;
+}
+
+const levels::MainData& levels::PackFile::getData() const
+{
+    return data;
+}
+
+bool levels::PackFile::readGround(const size_t index, polygons::Ground& ground) const
+{
+    using std::get;
+
+    if (!isOpen() || index >= ground_ranges.size())
+        return false;
+    const auto& range = ground_ranges[index];
+
+    PackReader reader { mapped + get<0>(range), get<1>(range) };
+
+    polygons::Ground ground_;
+    ground_.lower = reader.pod<b2Vec2>();
+    ground_.upper = reader.pod<b2Vec2>();
+    ground_.pieces = reader.soup();
+    ground_.outlines = reader.soup();
+    ground_.water_regions = reader.regions();
+    ground_.crate_regions = reader.regions();
+    ground_.use_chains = reader.pod<uint8_t>();
+    if (!reader.ok || reader.pos != reader.size)
+        return false;
+
+    ground = std::move(ground_);
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "load_levels.h"
+#include "ground_polygons.h"
+
+#include <QFile>
+
+#include <cstdint>
+#include <iosfwd>
+
+namespace levels
+{
+
+// fnv-1a over the json and every map it references, packs baked from other sources are rejected
+uint64_t source_hash(const std::string& json_filename, const MainData& data);
+
+void write_pack(std::ostream& os, const MainData& data, const std::vector<polygons::Ground>& grounds, const uint64_t hash);
+
+// level table is read and every ground block is checked on open, grounds are read from the mapping when requested
+class PackFile
+{
+    public:
+        ~PackFile();
+
+        bool open(const std::string& filename, const uint64_t expected_hash);
+        void close();
+        bool isOpen() const;
+
+        const MainData& getData() const;
+        bool readGround(const size_t index, polygons::Ground& ground) const; // false leaves ground untouched
+
+    protected:
+        QFile file;
+        const uchar* mapped = nullptr;
+        size_t mapped_size = 0;
+        MainData data;
+        std::vector<std::tuple<size_t, size_t>> ground_ranges; // offset, size
+};
+
+}
@@ -7,6 +7,8 @@
 #include <QCoreApplication>
 #include <QDebug>
 
+#include <algorithm>
+
 QJsonObject load_json_object(const std::string& json_filename)
 {
     QFile inFile(QString::fromStdString(json_filename));
@@ -49,6 +51,7 @@ levels::MainData levels::load(const std::string& json_filename)
             level_obj["map"].toString().toStdString(),
             {},
             {},
+            {},
             vec2_from_json(level_obj, "world_camera_x", "world_camera_y", b2Vec2 { 0, -120 }),
             float_from_json(level_obj, "world_screen_height", 500),
             float_from_json(level_obj, "ship_screen_height", 70),
@@ -59,6 +62,39 @@ levels::MainData levels::load(const std::string& json_filename)
             vec2_from_json(level_obj, "water_drop_width", "water_drop_height", b2Vec2 { 15, 15 }),
         };
 
+        if (level_obj.contains("world_bounds"))
+        {
+            const auto& bounds_json = level_obj["world_bounds"];
+            assert(bounds_json.isObject());
+            level.has_world_bounds = true;
+            level.world_bounds_lower = vec2_from_json(bounds_json, "xmin", "ymin");
+            level.world_bounds_upper = vec2_from_json(bounds_json, "xmax", "ymax");
+            assert(level.world_bounds_lower.x < level.world_bounds_upper.x);
+            assert(level.world_bounds_lower.y < level.world_bounds_upper.y);
+        }
+
+        level.initial_state = level_obj["initial_state"].toString().toStdString();
+        level.chunk_size = float_from_json(level_obj, "chunk_size", level.chunk_size);
+        assert(level.chunk_size >= 0);
+        level.ground_options.flatten_tolerance = float_from_json(level_obj, "flatten_tolerance", level.ground_options.flatten_tolerance);
+        assert(level.ground_options.flatten_tolerance > 0);
+        level.ground_options.simplify_tolerance = float_from_json(level_obj, "simplify_tolerance", level.ground_options.simplify_tolerance);
+        assert(level.ground_options.simplify_tolerance >= 0);
+        level.ground_options.merge_pieces = level_obj["merge_pieces"].toBool(level.ground_options.merge_pieces);
+        level.ground_options.min_piece_area = float_from_json(level_obj, "min_piece_area", level.ground_options.min_piece_area);
+        assert(level.ground_options.min_piece_area >= 0);
+        level.ground_options.use_chains = level_obj["ground"].toString("polygons") == "chains";
+        { // decomposition by name
+            const auto name = level_obj["decomposition"].toString(polygons::decomposition_names[0]).toStdString();
+            const auto iter = std::find(std::cbegin(polygons::decomposition_names), std::cend(polygons::decomposition_names), name);
+            if (iter == std::cend(polygons::decomposition_names))
+            {
+                qDebug() << "unknown decomposition" << QString::fromStdString(name) << "skipping level" << QString::fromStdString(level.name);
+                continue;
+            }
+            level.ground_options.decomposition = static_cast<polygons::Decomposition>(iter - std::cbegin(polygons::decomposition_names));
+        }
+
         for (const auto& door_json : level_obj["doors"].toArray())
         {
             assert(door_json.isObject());
@@ -82,9 +118,21 @@ levels::MainData levels::load(const std::string& json_filename)
             level.paths.emplace_back(LevelData::PathData { positions, size });
         }
 
+        for (const auto& emitter_json : level_obj["emitters"].toArray())
+        {
+            assert(emitter_json.isObject());
+            const auto& emitter_obj = emitter_json.toObject();
+            const b2Vec2 position = vec2_from_json(emitter_obj, "x", "y");
+            const b2Vec2 size = vec2_from_json(emitter_obj, "width", "height", b2Vec2 { 1, 1 });
+            const b2Vec2 velocity = vec2_from_json(emitter_obj, "vx", "vy", b2Vec2 { 0, 0 });
+            const float rate = float_from_json(emitter_obj, "rate", 50);
+            const float lifetime = float_from_json(emitter_obj, "lifetime", 20);
+            level.emitters.emplace_back(LevelData::EmitterData { position, size, velocity, rate, lifetime });
+        }
+
         levels.emplace_back(level);
     }
 
-    return { levels, root_obj["default_level"].toInt(-1) };
+    return { levels, root_obj["default_level"].toInt(-1), root_obj["pack"].toString().toStdString() };
 }
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "ground_polygons.h"
+
 #include <Box2D/Common/b2Math.h>
 
 #include <vector>
@@ -12,10 +14,12 @@ struct LevelData
 {
     using DoorData = std::tuple<b2Vec2, b2Vec2, b2Vec2>;
     using PathData = std::tuple<std::vector<b2Vec2>, b2Vec2>;
+    using EmitterData = std::tuple<b2Vec2, b2Vec2, b2Vec2, float, float>;
     std::string name;
     std::string map_filename;
     std::vector<DoorData> doors;
     std::vector<PathData> paths;
+    std::vector<EmitterData> emitters;
     b2Vec2 world_camera_position;
     float world_screen_height;
     float ship_screen_height;
@@ -24,13 +28,20 @@ struct LevelData
     b2Vec2 crate_spawn;
     b2Vec2 water_spawn;
     b2Vec2 water_drop_size;
+    bool has_world_bounds = false;
+    b2Vec2 world_bounds_lower = { 0, 0 };
+    b2Vec2 world_bounds_upper = { 0, 0 };
+    std::string initial_state;
+    float chunk_size = 0; // world units, ground is streamed around the ship by chunks, zero loads it whole
+    polygons::GroundOptions ground_options;
 };
 
 struct MainData
 {
     using LevelDatas = std::vector<LevelData>;
     LevelDatas levels;
-    int default_level;
+    int default_level = -1;
+    std::string pack_filename;
 };
 
 MainData load(const std::string& json_filename);
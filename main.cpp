@@ -20,6 +20,12 @@ int main(int argc, char* argv[])
     QApplication app(argc, argv);
     GameWindowOpenGL view;
 
+    { // rocket [levels_dir] hot reloads levels from the sources
+        const auto arguments = app.arguments();
+        if (arguments.size() > 1)
+            view.watchLevels(arguments[1].toStdString());
+    }
+
     view.setAnimated(true);
     view.resize(1280, 720);
     view.show();
@@ -45,6 +51,13 @@ int main(int argc, char* argv[])
     view.addCheckbox("painter", Qt::Key_O, true, [&view](const bool checked) -> void {
         view.use_painter = checked;
     });
+    view.addCheckbox("sensors", Qt::Key_H, false, [&view](const bool checked) -> void {
+        view.show_sensors = checked;
+    });
+    view.addCheckbox("memory report", Qt::Key_K, false, [&view](const bool checked) -> void {
+        view.show_memory = checked;
+        view.memory_report_pending = checked;
+    });
 
     std::default_random_engine rng;
     int tag = 0;
@@ -99,6 +112,21 @@ int main(int argc, char* argv[])
         assert(view.state);
         view.state->resetBall(view.ball_spawn);
     });
+    view.addButton("spawn 100 bots", Qt::Key_N, [&view]() -> void {
+        if (!view.state)
+            return;
+        assert(view.state);
+        view.state->addBots(100, view.ship_spawn + b2Vec2 { 0, 60 }, 8, false);
+    });
+    view.addButton("clear bots", Qt::Key_U, [&view]() -> void {
+        if (!view.state)
+            return;
+        assert(view.state);
+        view.state->clearBots();
+    });
+    view.addButton("dump memory", Qt::Key_J, [&view]() -> void {
+        view.dumpMemoryReport("memory_report.json");
+    });
     view.addButton("toggle doors", Qt::Key_T, [&view]() -> void {
         if (!view.state)
             return;
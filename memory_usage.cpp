@@ -0,0 +1,73 @@
+#include "memory_usage.h"
+
+#include <sstream>
+#include <iomanip>
+
+#if defined(__linux__)
+#include <fstream>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#endif
+
+size_t memory::resident_size()
+{
+#if defined(__linux__)
+    std::ifstream handle("/proc/self/statm");
+    size_t total_pages = 0;
+    size_t resident_pages = 0;
+    if (!(handle >> total_pages >> resident_pages))
+        return 0;
+    return resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#elif defined(__APPLE__)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS)
+        return 0;
+    return info.resident_size;
+#else
+    return 0;
+#endif
+}
+
+size_t memory::total_bytes(const Report& report)
+{
+    size_t total = 0;
+    for (const auto& entry : report)
+        total += std::get<2>(entry);
+    return total;
+}
+
+std::string memory::to_json(const Report& report, const Derived& derived)
+{
+    using std::get;
+    using std::endl;
+
+    std::stringstream ss;
+    ss << "{" << endl;
+    ss << "  \"rss\": " << resident_size() << "," << endl;
+    ss << "  \"total\": " << total_bytes(report) << "," << endl;
+
+    ss << "  \"entries\": [";
+    bool first = true;
+    for (const auto& entry : report)
+    {
+        ss << (first ? "" : ",") << endl;
+        ss << "    { \"name\": " << std::quoted(get<0>(entry)) << ", \"count\": " << get<1>(entry) << ", \"bytes\": " << get<2>(entry) << " }";
+        first = false;
+    }
+    ss << endl << "  ]," << endl;
+
+    ss << "  \"derived\": {";
+    first = true;
+    for (const auto& value : derived)
+    {
+        ss << (first ? "" : ",") << endl;
+        ss << "    " << std::quoted(get<0>(value)) << ": " << get<1>(value);
+        first = false;
+    }
+    ss << endl << "  }" << endl;
+    ss << "}" << endl;
+
+    return ss.str();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace memory
+{
+
+// resident set size of the current process in bytes, 0 when unavailable
+size_t resident_size();
+
+using Entry = std::tuple<std::string, size_t, size_t>; // name, count, bytes
+using Report = std::vector<Entry>;
+using Derived = std::vector<std::tuple<std::string, float>>;
+
+size_t total_bytes(const Report& report);
+std::string to_json(const Report& report, const Derived& derived);
+
+}
@@ -0,0 +1,195 @@
+#include "merge_polygons.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+float polygons::signed_area(const b2Vec2* points, const size_t count)
+{
+    float area = 0;
+    for (size_t kk=0; kk<count; kk++)
+        area += b2Cross(points[kk], points[(kk + 1) % count]);
+    return area / 2;
+}
+
+float polygons::signed_area(const Poly& poly)
+{
+    return signed_area(poly.data(), poly.size());
+}
+
+static bool same_point(const b2Vec2& aa, const b2Vec2& bb)
+{
+    return (aa - bb).LengthSquared() < 1e-12f;
+}
+
+// union across the shared edge, collinear vertices removed, empty when not strictly convex with the given winding
+static polygons::Poly merge_pair(const polygons::Poly& aa, const polygons::Poly& bb, const float winding)
+{
+    using polygons::Poly;
+
+    const auto aa_count = aa.size();
+    const auto bb_count = bb.size();
+    for (size_t ii=0; ii<aa_count; ii++)
+        for (size_t jj=0; jj<bb_count; jj++)
+        {
+            // edge ii of aa runs backward along edge jj of bb
+            if (!same_point(aa[ii], bb[(jj + 1) % bb_count]) || !same_point(aa[(ii + 1) % aa_count], bb[jj]))
+                continue;
+
+            Poly merged;
+            for (size_t kk=0; kk<aa_count; kk++)
+                merged.emplace_back(aa[(ii + 1 + kk) % aa_count]);
+            for (size_t kk=2; kk<bb_count; kk++)
+                merged.emplace_back(bb[(jj + kk) % bb_count]);
+
+            Poly merged_;
+            const auto count = merged.size();
+            for (size_t kk=0; kk<count; kk++)
+            {
+                const auto& prev = merged[(kk + count - 1) % count];
+                const auto& next = merged[(kk + 1) % count];
+                const auto edge = merged[kk] - prev;
+                const auto edge_next = next - merged[kk];
+                const auto turn = b2Cross(edge, edge_next) * winding;
+                const auto scale = edge.Length() * edge_next.Length();
+                if (std::fabs(turn) <= 1e-6f * scale)
+                    continue; // collinear
+                if (turn < 0)
+                    return {};
+                merged_.emplace_back(merged[kk]);
+            }
+
+            return merged_;
+        }
+
+    return {};
+}
+
+polygons::PolySoup polygons::merge_convex(const PolySoup& pieces, const size_t max_vertices, const float min_area)
+{
+    assert(max_vertices >= 3);
+
+    // merging reshapes pieces, they are worked on separately and packed back at the end
+    std::vector<Poly> pieces_;
+    pieces_.reserve(pieces.size());
+    for (size_t kk=0; kk<pieces.size(); kk++)
+        pieces_.emplace_back(pieces.poly(kk));
+
+    float area = 0;
+    for (const auto& piece : pieces_)
+        area += signed_area(piece);
+    const float winding = area < 0 ? -1 : 1;
+
+    // pieces meet at bitwise equal vertices, each directed edge maps to the piece it bounds so that
+    // only the neighbours across an edge are tried, like hertel_mehlhorn does with vertex indices
+    std::unordered_map<uint64_t, uint32_t> vertex_ids;
+    const auto vertex_id = [&vertex_ids](const b2Vec2& point) -> uint32_t
+    {
+        const float xx = point.x + 0.f; // -0 and 0 are the same vertex
+        const float yy = point.y + 0.f;
+        uint32_t xx_bits, yy_bits;
+        std::memcpy(&xx_bits, &xx, sizeof(xx_bits));
+        std::memcpy(&yy_bits, &yy, sizeof(yy_bits));
+        const auto key = (static_cast<uint64_t>(xx_bits) << 32) | yy_bits;
+        return vertex_ids.emplace(key, static_cast<uint32_t>(vertex_ids.size())).first->second;
+    };
+    const auto edge_key = [](const uint32_t aa, const uint32_t bb) -> uint64_t
+    {
+        return (static_cast<uint64_t>(aa) << 32) | bb;
+    };
+
+    std::vector<std::vector<uint32_t>> piece_ids(pieces_.size());
+    std::unordered_map<uint64_t, uint32_t> edge_pieces; // directed edge to the piece it bounds
+    const auto link = [&pieces_, &piece_ids, &edge_pieces, &vertex_id, &edge_key](const uint32_t pp) -> void
+    {
+        auto& ids = piece_ids[pp];
+        ids.clear();
+        for (const auto& point : pieces_[pp])
+            ids.emplace_back(vertex_id(point));
+        for (size_t kk=0, kk_max=ids.size(); kk<kk_max; kk++)
+            edge_pieces[edge_key(ids[kk], ids[(kk + 1) % kk_max])] = pp;
+    };
+    const auto unlink = [&piece_ids, &edge_pieces, &edge_key](const uint32_t pp) -> void
+    {
+        const auto& ids = piece_ids[pp];
+        for (size_t kk=0, kk_max=ids.size(); kk<kk_max; kk++)
+        {
+            const auto iter = edge_pieces.find(edge_key(ids[kk], ids[(kk + 1) % kk_max]));
+            if (iter != std::end(edge_pieces) && iter->second == pp)
+                edge_pieces.erase(iter);
+        }
+    };
+    for (uint32_t pp=0; pp<pieces_.size(); pp++)
+        link(pp);
+
+    for (uint32_t pp=0; pp<pieces_.size(); pp++)
+    {
+        bool changed = !pieces_[pp].empty();
+        while (changed)
+        {
+            changed = false;
+            const auto ids = piece_ids[pp];
+            for (size_t kk=0, kk_max=ids.size(); !changed && kk<kk_max; kk++)
+            {
+                const auto iter = edge_pieces.find(edge_key(ids[(kk + 1) % kk_max], ids[kk]));
+                if (iter == std::cend(edge_pieces) || iter->second == pp)
+                    continue;
+                const auto qq = iter->second;
+
+                // shared edge vertices count once and may become collinear
+                if (pieces_[pp].size() + pieces_[qq].size() > max_vertices + 4)
+                    continue;
+
+                auto merged = merge_pair(pieces_[pp], pieces_[qq], winding);
+                if (merged.size() < 3 || merged.size() > max_vertices)
+                    continue;
+
+                unlink(pp);
+                unlink(qq);
+                pieces_[pp] = std::move(merged);
+                pieces_[qq].clear();
+                piece_ids[qq].clear();
+                link(pp);
+                changed = true;
+            }
+        }
+    }
+
+    PolySoup merged;
+    for (const auto& piece : pieces_)
+        if (!piece.empty() && std::fabs(signed_area(piece)) >= min_area)
+            merged.push(piece);
+
+    return merged;
+}
+
+polygons::PolySoup polygons::split_convex(const PolySoup& pieces, const size_t max_vertices)
+{
+    assert(max_vertices >= 3);
+
+    PolySoup split;
+    for (size_t kk=0; kk<pieces.size(); kk++)
+    {
+        const auto count = pieces.count(kk);
+        if (count <= max_vertices)
+        {
+            split.push(pieces.begin(kk), count, pieces.colors[kk]);
+            continue;
+        }
+
+        const auto points = pieces.begin(kk);
+        for (size_t start=1; start + 1<count;)
+        {
+            const auto stop = std::min(start + max_vertices - 2, count - 1);
+            Poly fan { points[0] };
+            fan.insert(std::end(fan), points + start, points + stop + 1);
+            split.push(fan, pieces.colors[kk]);
+            start = stop;
+        }
+    }
+
+    return split;
+}
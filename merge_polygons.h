@@ -0,0 +1,19 @@
+#pragma once
+
+#include "data_polygons.h"
+
+namespace polygons
+{
+
+// greedily merges convex pieces sharing an edge while the union stays convex and has at most max_vertices,
+// pieces still smaller than min_area afterwards are dropped. shared edges must have bitwise equal end points,
+// only the neighbours of a piece are tried so merging stays close to linear in the piece count
+PolySoup merge_convex(const PolySoup& pieces, const size_t max_vertices, const float min_area);
+
+// fans convex pieces with more than max_vertices around their first vertex, neighbour fans share an edge
+PolySoup split_convex(const PolySoup& pieces, const size_t max_vertices);
+
+float signed_area(const b2Vec2* points, const size_t count);
+float signed_area(const Poly& poly);
+
+}
@@ -0,0 +1,396 @@
+#include "partition_polygons.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <tuple>
+#include <unordered_map>
+
+using polygons::Poly;
+using polygons::PolySoup;
+
+// twice the signed area of abc, positive when abc turns left
+static float turn(const b2Vec2& aa, const b2Vec2& bb, const b2Vec2& cc)
+{
+    return b2Cross(bb - aa, cc - aa);
+}
+
+static bool in_triangle(const b2Vec2& point, const b2Vec2& aa, const b2Vec2& bb, const b2Vec2& cc)
+{
+    return turn(aa, bb, point) >= 0 && turn(bb, cc, point) >= 0 && turn(cc, aa, point) >= 0;
+}
+
+// intersection of the infinite lines through both pairs, false when parallel
+static bool line_intersection(const b2Vec2& aa, const b2Vec2& bb, const b2Vec2& cc, const b2Vec2& dd, b2Vec2& point)
+{
+    const auto edge = bb - aa;
+    const auto edge_ = dd - cc;
+    const auto denom = b2Cross(edge, edge_);
+    if (denom == 0)
+        return false;
+    point = aa + (b2Cross(cc - aa, edge_) / denom) * edge;
+    return true;
+}
+
+// closed segments, parallel ones never intersect
+static bool segments_intersect(const b2Vec2& aa, const b2Vec2& bb, const b2Vec2& cc, const b2Vec2& dd)
+{
+    const auto edge = bb - aa;
+    const auto edge_ = dd - cc;
+    const auto denom = b2Cross(edge, edge_);
+    if (denom == 0)
+        return false;
+    const auto tt = b2Cross(cc - aa, edge_) / denom;
+    const auto uu = b2Cross(cc - aa, edge) / denom;
+    return tt >= 0 && tt <= 1 && uu >= 0 && uu <= 1;
+}
+
+using Piece = std::vector<uint32_t>; // indices into the input vertices
+
+static std::vector<Piece> ear_clipping(const b2Vec2* vertices, const size_t count)
+{
+    std::vector<uint32_t> prev(count);
+    std::vector<uint32_t> next(count);
+    for (size_t kk=0; kk<count; kk++)
+    {
+        prev[kk] = (kk + count - 1) % count;
+        next[kk] = (kk + 1) % count;
+    }
+
+    const auto is_ear = [vertices, &prev, &next](const uint32_t ii) -> bool
+    {
+        const auto& aa = vertices[prev[ii]];
+        const auto& bb = vertices[ii];
+        const auto& cc = vertices[next[ii]];
+        if (turn(aa, bb, cc) <= 0)
+            return false;
+        for (auto kk=next[next[ii]]; kk!=prev[ii]; kk=next[kk])
+        {
+            const auto& point = vertices[kk];
+            if (point == aa || point == bb || point == cc)
+                continue;
+            if (in_triangle(point, aa, bb, cc))
+                return false;
+        }
+        return true;
+    };
+
+    std::vector<Piece> triangles;
+    size_t remaining = count;
+    uint32_t ii = 0;
+    size_t misses = 0;
+    while (remaining > 3)
+    {
+        // a full turn without ears only happens with degenerate input, the vertex is clipped anyway
+        if (!is_ear(ii) && misses < remaining)
+        {
+            ii = next[ii];
+            misses++;
+            continue;
+        }
+
+        const auto pp = prev[ii];
+        const auto nn = next[ii];
+        if (turn(vertices[pp], vertices[ii], vertices[nn]) > 0)
+            triangles.emplace_back(Piece { pp, ii, nn });
+        next[pp] = nn;
+        prev[nn] = pp;
+        remaining--;
+        misses = 0;
+        ii = pp;
+    }
+    if (turn(vertices[prev[ii]], vertices[ii], vertices[next[ii]]) > 0)
+        triangles.emplace_back(Piece { prev[ii], ii, next[ii] });
+
+    return triangles;
+}
+
+// drops diagonals shared by two pieces as long as the union stays convex at both ends and has at most max_vertices
+static std::vector<Piece> hertel_mehlhorn(const b2Vec2* vertices, const size_t count, const size_t max_vertices, std::vector<Piece> pieces)
+{
+    const auto edge_key = [](const uint32_t aa, const uint32_t bb) -> uint64_t
+    {
+        return (static_cast<uint64_t>(aa) << 32) | bb;
+    };
+
+    std::unordered_map<uint64_t, uint32_t> edge_pieces; // directed edge to the piece it bounds
+    for (uint32_t pp=0; pp<pieces.size(); pp++)
+        for (size_t kk=0, kk_max=pieces[pp].size(); kk<kk_max; kk++)
+            edge_pieces[edge_key(pieces[pp][kk], pieces[pp][(kk + 1) % kk_max])] = pp;
+
+    for (uint32_t pp=0; pp<pieces.size(); pp++)
+    {
+        bool merged = !pieces[pp].empty();
+        while (merged)
+        {
+            merged = false;
+            auto& piece = pieces[pp];
+            const auto size = piece.size();
+            for (size_t kk=0; !merged && kk<size; kk++)
+            {
+                const auto aa = piece[kk];
+                const auto bb = piece[(kk + 1) % size];
+                if (bb == (aa + 1) % count)
+                    continue; // polygon boundary
+
+                const auto iter = edge_pieces.find(edge_key(bb, aa));
+                if (iter == std::cend(edge_pieces) || iter->second == pp)
+                    continue;
+                const auto qq = iter->second;
+                auto& other = pieces[qq];
+                const auto other_size = other.size();
+                if (size + other_size - 2 > max_vertices)
+                    continue;
+                const auto mm = std::find(std::cbegin(other), std::cend(other), bb) - std::cbegin(other);
+                assert(other[(mm + 1) % other_size] == aa);
+
+                const auto& before_aa = vertices[piece[(kk + size - 1) % size]];
+                const auto& after_aa = vertices[other[(mm + 2) % other_size]];
+                const auto& before_bb = vertices[other[(mm + other_size - 1) % other_size]];
+                const auto& after_bb = vertices[piece[(kk + 2) % size]];
+                if (turn(before_aa, vertices[aa], after_aa) < 0 || turn(before_bb, vertices[bb], after_bb) < 0)
+                    continue;
+
+                // bb around this piece up to aa, then the other piece from after aa to before bb
+                Piece union_;
+                union_.reserve(size + other_size - 2);
+                for (size_t ll=0; ll<size; ll++)
+                    union_.emplace_back(piece[(kk + 1 + ll) % size]);
+                for (size_t ll=2; ll<other_size; ll++)
+                    union_.emplace_back(other[(mm + ll) % other_size]);
+
+                edge_pieces.erase(edge_key(aa, bb));
+                edge_pieces.erase(edge_key(bb, aa));
+                for (size_t ll=0; ll<other_size; ll++)
+                {
+                    const auto iter_ = edge_pieces.find(edge_key(other[ll], other[(ll + 1) % other_size]));
+                    if (iter_ != std::end(edge_pieces))
+                        iter_->second = pp;
+                }
+
+                other.clear();
+                piece = std::move(union_);
+                merged = true;
+            }
+        }
+    }
+
+    pieces.erase(std::remove_if(std::begin(pieces), std::end(pieces), [](const Piece& piece) -> bool { return piece.empty(); }), std::end(pieces));
+    return pieces;
+}
+
+PolySoup polygons::decompose_ear_clipping(const b2Vec2* vertices, const size_t count, const size_t max_vertices)
+{
+    assert(count > 2);
+    assert(max_vertices >= 3);
+
+    PolySoup pieces;
+    for (const auto& piece : hertel_mehlhorn(vertices, count, max_vertices, ear_clipping(vertices, count)))
+    {
+        for (const auto& index : piece)
+            pieces.vertices.emplace_back(vertices[index]);
+        pieces.offsets.emplace_back(pieces.vertices.size());
+        pieces.colors.emplace_back(Color { 0, 0, 0, 1 });
+    }
+
+    return pieces;
+}
+
+PolySoup polygons::decompose_bayazit(const b2Vec2* vertices, const size_t count, const size_t max_vertices)
+{
+    assert(count > 2);
+    assert(max_vertices >= 3);
+
+    PolySoup pieces;
+
+    // parts that keep splitting without converging are finished with ear clipping
+    const auto max_depth = count;
+    std::vector<std::tuple<Poly, size_t>> pending;
+    pending.emplace_back(Poly(vertices, vertices + count), 0);
+    while (!pending.empty())
+    {
+        Poly poly;
+        size_t depth;
+        std::tie(poly, depth) = std::move(pending.back());
+        pending.pop_back();
+
+        const int nn = poly.size();
+        const auto at = [&poly, nn](const int kk) -> const b2Vec2& { return poly[((kk % nn) + nn) % nn]; };
+        const auto is_reflex = [&at](const int kk) -> bool { return turn(at(kk - 1), at(kk), at(kk + 1)) < 0; };
+        const auto fallback = [&pieces, &poly, max_vertices]() -> void { pieces.append(decompose_ear_clipping(poly.data(), poly.size(), max_vertices)); };
+
+        int ii = 0;
+        while (ii < nn && !is_reflex(ii))
+            ii++;
+        if (ii == nn && static_cast<size_t>(nn) <= max_vertices)
+        {
+            pieces.push(poly);
+            continue;
+        }
+        if (ii == nn)
+        { // convex but too large, both halves share the chord between opposite vertices
+            pending.emplace_back(Poly(std::cbegin(poly), std::cbegin(poly) + nn / 2 + 1), depth);
+            Poly upper(std::cbegin(poly) + nn / 2, std::cend(poly));
+            upper.emplace_back(poly.front());
+            pending.emplace_back(std::move(upper), depth);
+            continue;
+        }
+        if (depth > max_depth)
+        {
+            fallback();
+            continue;
+        }
+
+        // closest hits of both edges at ii extended through ii
+        const float inf = std::numeric_limits<float>::infinity();
+        float lower_distance = inf;
+        float upper_distance = inf;
+        b2Vec2 lower_point = { 0, 0 };
+        b2Vec2 upper_point = { 0, 0 };
+        int lower_index = -1;
+        int upper_index = -1;
+        for (int jj=0; jj<nn; jj++)
+        {
+            b2Vec2 point;
+            if (turn(at(ii - 1), at(ii), at(jj)) > 0 && turn(at(ii - 1), at(ii), at(jj - 1)) <= 0 &&
+                line_intersection(at(ii - 1), at(ii), at(jj), at(jj - 1), point) && turn(at(ii + 1), at(ii), point) < 0)
+            {
+                const auto distance = b2DistanceSquared(at(ii), point);
+                if (distance < lower_distance)
+                {
+                    lower_distance = distance;
+                    lower_point = point;
+                    lower_index = jj;
+                }
+            }
+            if (turn(at(ii + 1), at(ii), at(jj + 1)) > 0 && turn(at(ii + 1), at(ii), at(jj)) <= 0 &&
+                line_intersection(at(ii + 1), at(ii), at(jj), at(jj + 1), point) && turn(at(ii - 1), at(ii), point) > 0)
+            {
+                const auto distance = b2DistanceSquared(at(ii), point);
+                if (distance < upper_distance)
+                {
+                    upper_distance = distance;
+                    upper_point = point;
+                    upper_index = jj;
+                }
+            }
+        }
+        if (lower_index < 0 || upper_index < 0)
+        {
+            fallback();
+            continue;
+        }
+
+        const auto can_see = [nn, &at, &is_reflex](const int ii, const int jj) -> bool
+        {
+            if (is_reflex(ii))
+            {
+                if (turn(at(ii), at(ii - 1), at(jj)) >= 0 && turn(at(ii), at(ii + 1), at(jj)) <= 0)
+                    return false;
+            }
+            else if (turn(at(ii), at(ii + 1), at(jj)) <= 0 || turn(at(ii), at(ii - 1), at(jj)) >= 0)
+                return false;
+            if (is_reflex(jj))
+            {
+                if (turn(at(jj), at(jj - 1), at(ii)) >= 0 && turn(at(jj), at(jj + 1), at(ii)) <= 0)
+                    return false;
+            }
+            else if (turn(at(jj), at(jj + 1), at(ii)) <= 0 || turn(at(jj), at(jj - 1), at(ii)) >= 0)
+                return false;
+            for (int kk=0; kk<nn; kk++)
+            {
+                const auto kk_next = (kk + 1) % nn;
+                if (kk == ii || kk_next == ii || kk == jj || kk_next == jj)
+                    continue;
+                if (segments_intersect(at(ii), at(jj), at(kk), at(kk_next)))
+                    return false;
+            }
+            return true;
+        };
+
+        // vertices from .. to going forward, both included
+        const auto copy = [nn, &at](const int from, int to, Poly& part) -> void
+        {
+            while (to < from)
+                to += nn;
+            for (auto kk=from; kk<=to; kk++)
+                part.emplace_back(at(kk));
+        };
+
+        Poly lower;
+        Poly upper;
+        if (lower_index == (upper_index + 1) % nn)
+        { // nothing between both hits, split through a steiner point
+            const auto middle = .5f * (lower_point + upper_point);
+            copy(ii, upper_index, lower);
+            lower.emplace_back(middle);
+            copy(lower_index, ii, upper);
+            upper.emplace_back(middle);
+        }
+        else
+        { // best visible vertex between both hits, reflex ones first then the closest
+            const auto reference = std::fmax(std::fmin(lower_distance, upper_distance), 1e-12f);
+            float best_score = 0;
+            int best = -1;
+            auto upper_index_ = upper_index;
+            while (upper_index_ < lower_index)
+                upper_index_ += nn;
+            for (auto jj=lower_index; jj<=upper_index_; jj++)
+            {
+                const auto jj_ = jj % nn;
+                if (jj_ == ii || !can_see(ii, jj_))
+                    continue;
+                auto score = 1 / (1 + b2DistanceSquared(at(ii), at(jj_)) / reference);
+                if (is_reflex(jj_))
+                    score += turn(at(jj_ - 1), at(jj_), at(ii)) <= 0 && turn(at(jj_ + 1), at(jj_), at(ii)) >= 0 ? 3 : 2;
+                else
+                    score += 1;
+                if (score > best_score)
+                {
+                    best_score = score;
+                    best = jj_;
+                }
+            }
+            if (best < 0)
+            {
+                fallback();
+                continue;
+            }
+            copy(ii, best, lower);
+            copy(best, ii, upper);
+        }
+
+        if (lower.size() < 3 || upper.size() < 3)
+        {
+            fallback();
+            continue;
+        }
+        pending.emplace_back(std::move(lower), depth + 1);
+        pending.emplace_back(std::move(upper), depth + 1);
+    }
+
+    return pieces;
+}
+
+float polygons::concavity(const b2Vec2* vertices, const size_t count)
+{
+    float area = 0;
+    for (size_t kk=0; kk<count; kk++)
+        area += b2Cross(vertices[kk], vertices[(kk + 1) % count]);
+    const float winding = area < 0 ? -1 : 1;
+
+    float result = 0;
+    for (size_t kk=0; kk<count; kk++)
+    {
+        const auto& prev = vertices[(kk + count - 1) % count];
+        const auto& next = vertices[(kk + 1) % count];
+        const auto chord = next - prev;
+        const auto length = chord.Length();
+        if (length <= 0)
+            continue;
+        result = std::fmax(result, winding * b2Cross(chord, vertices[kk] - prev) / length);
+    }
+
+    return result;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "data_polygons.h"
+
+namespace polygons
+{
+
+// decompositions without acd2d, input is a simple polygon with positive signed area like ensure_cw returns,
+// pieces keep that orientation
+
+// pieces have at most max_vertices
+
+// ear clipping triangulation, then hertel-mehlhorn removes every diagonal whose endpoints stay convex,
+// at most four times the optimal piece count
+PolySoup decompose_ear_clipping(const b2Vec2* vertices, const size_t count, const size_t max_vertices = b2_maxPolygonVertices);
+
+// bayazit, splits at reflex vertices toward the best visible vertex or a steiner point,
+// convex parts that are too large are halved, fewer pieces than hertel-mehlhorn but cubic in the worst case
+PolySoup decompose_bayazit(const b2Vec2* vertices, const size_t count, const size_t max_vertices = b2_maxPolygonVertices);
+
+// largest distance of a reflex vertex from the chord joining its neighbours, zero for convex polygons
+float concavity(const b2Vec2* vertices, const size_t count);
+
+}
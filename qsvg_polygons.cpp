@@ -0,0 +1,212 @@
+#include "qsvg_polygons.h"
+#include "svg_polygons.h"
+
+#include <QSvgRenderer>
+#include <QPaintDevice>
+#include <QPaintEngine>
+#include <QPainterPath>
+
+using polygons::Color;
+using polygons::Poly;
+using polygons::PolySoup;
+using polygons::UniquePolySoup;
+
+struct SvgDumpEngine : public QPaintEngine
+{
+    SvgDumpEngine();
+    bool begin(QPaintDevice* pdev) override;
+    bool end() override;
+    void updateState(const QPaintEngineState& state) override;
+    void drawPixmap(const QRectF& r, const QPixmap& pm, const QRectF& sr) override;
+    void drawPath(const QPainterPath& path) override;
+    Type type() const override;
+
+    bool has_pen = false;
+    bool has_brush = false;
+    Color current_color = { 0, 0, 0, 1 };
+    float tolerance = 1e-4;
+
+    Poly flatten(const QPainterPath& path) const;
+    static Color to_color(const QColor& color);
+    UniquePolySoup pen_polys;
+    UniquePolySoup brush_polys;
+
+    QTransform transform;
+};
+
+Color SvgDumpEngine::to_color(const QColor& color)
+{
+    using Scalar = decltype(b2Vec2::x);
+    return { static_cast<Scalar>(color.redF()), static_cast<Scalar>(color.greenF()), static_cast<Scalar>(color.blueF()), static_cast<Scalar>(color.alphaF()) };
+}
+
+// subpaths are closed and concatenated like QPainterPath::toFillPolygon, the closing vertex is not repeated
+Poly SvgDumpEngine::flatten(const QPainterPath& path) const
+{
+    using Scalar = decltype(b2Vec2::x);
+    const auto to_point = [this](const QPointF& point) -> b2Vec2
+    {
+        const auto point_ = transform.map(point);
+        return { static_cast<Scalar>(point_.x()), static_cast<Scalar>(point_.y()) };
+    };
+
+    Poly poly;
+    b2Vec2 subpath_start = { 0, 0 };
+    for (int kk=0, kk_max=path.elementCount(); kk<kk_max; kk++)
+    {
+        const QPainterPath::Element& element = path.elementAt(kk);
+        switch (element.type)
+        {
+            case QPainterPath::MoveToElement:
+                if (!poly.empty() && !(poly.back() == subpath_start))
+                    poly.emplace_back(subpath_start);
+                subpath_start = to_point(element);
+                poly.emplace_back(subpath_start);
+                break;
+            case QPainterPath::LineToElement:
+                poly.emplace_back(to_point(element));
+                break;
+            case QPainterPath::CurveToElement:
+                assert(!poly.empty());
+                assert(kk + 2 < kk_max);
+                polygons::flatten_cubic(poly, to_point(element), to_point(path.elementAt(kk + 1)), to_point(path.elementAt(kk + 2)), tolerance);
+                kk += 2;
+                break;
+            case QPainterPath::CurveToDataElement:
+                assert(false);
+                break;
+        }
+    }
+
+    Poly poly_;
+    for (const auto& point : poly)
+        if (poly_.empty() || !(poly_.back() == point))
+            poly_.emplace_back(point);
+
+    while (poly_.size() > 1 && poly_.back() == poly_.front())
+        poly_.pop_back();
+
+    if (poly_.size() < 2)
+        return {};
+
+    return poly_;
+}
+
+SvgDumpEngine::SvgDumpEngine() : QPaintEngine(PainterPaths | PaintOutsidePaintEvent | PrimitiveTransform)
+{
+}
+
+bool SvgDumpEngine::begin(QPaintDevice* pdev)
+{
+    has_pen = false;
+    has_brush = false;
+    current_color = { 0, 0, 0, 1 };
+    pen_polys = UniquePolySoup();
+    brush_polys = UniquePolySoup();
+    transform = QTransform();
+    return true;
+}
+
+bool SvgDumpEngine::end()
+{
+    return true;
+}
+
+void SvgDumpEngine::updateState(const QPaintEngineState& state)
+{
+    auto flags = state.state();
+    if (flags.testFlag(DirtyPen))
+    {
+        has_pen = state.pen() != Qt::NoPen;
+        if (has_pen) current_color = to_color(state.pen().color());
+        flags.setFlag(DirtyPen, false);
+    }
+    if (flags.testFlag(DirtyBrush))
+    {
+        has_brush = state.brush() != Qt::NoBrush;
+        if (has_brush) current_color = to_color(state.brush().color());
+        flags.setFlag(DirtyBrush, false);
+    }
+    if (flags.testFlag(DirtyTransform))
+    {
+        transform = state.transform();
+        flags.setFlag(DirtyTransform, false);
+    }
+    flags.setFlag(DirtyHints, false);
+    flags.setFlag(DirtyFont, false);
+    //assert(!flags); // FIXME macos
+}
+
+void SvgDumpEngine::drawPixmap(const QRectF& r, const QPixmap& pm, const QRectF& sr)
+{
+}
+
+void SvgDumpEngine::drawPath(const QPainterPath& path)
+{
+    const Poly poly = flatten(path);
+    if (poly.empty())
+        return;
+
+    if (has_brush)
+    {
+        brush_polys.push(poly, current_color);
+        return;
+    }
+
+    if (has_pen)
+    {
+        const auto inserted = pen_polys.push(poly, current_color);
+        assert(inserted);
+        return;
+    }
+
+    //assert(false); // should have pen or brush exclusively
+}
+
+QPaintEngine::Type SvgDumpEngine::type() const
+{
+    return QPaintEngine::User;
+}
+
+struct SvgDumpDevice : public QPaintDevice
+{
+    QPaintEngine* paintEngine() const override;
+    int metric(PaintDeviceMetric metric) const override;
+    SvgDumpEngine engine;
+};
+
+int SvgDumpDevice::metric(PaintDeviceMetric metric) const
+{
+    if (metric == PdmWidth) return 1024;
+    if (metric == PdmHeight) return 1024;
+    if (metric == PdmDpiX) return 100;
+    if (metric == PdmDpiY) return 100;
+    if (metric == PdmDevicePixelRatio) return 1;
+    if (metric == PdmDevicePixelRatioScaled) return 1;
+    return QPaintDevice::metric(metric);
+}
+
+QPaintEngine* SvgDumpDevice::paintEngine() const
+{
+    return const_cast<SvgDumpEngine*>(&engine);
+}
+
+std::tuple<PolySoup, PolySoup> polygons::extract_qsvg(const std::string& filename, const float tolerance)
+{
+    assert(tolerance > 0);
+
+    QSvgRenderer renderer;
+    const auto load_ok = renderer.load(QString::fromUtf8(filename.c_str()));
+    assert(renderer.isValid());
+    assert(load_ok);
+
+    SvgDumpDevice device;
+    device.engine.tolerance = tolerance;
+    {
+        QPainter painter(&device);
+        renderer.render(&painter, QRectF(0, 0, 1, 1));
+    }
+
+    return std::make_tuple(std::move(device.engine.pen_polys.soup), std::move(device.engine.brush_polys.soup));
+}
+
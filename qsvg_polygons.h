@@ -0,0 +1,11 @@
+#pragma once
+
+#include "data_polygons.h"
+
+namespace polygons
+{
+
+// reference extraction through QSvgRenderer and a paint engine intercepting drawPath, needs a QApplication
+std::tuple<PolySoup, PolySoup> extract_qsvg(const std::string& filename, const float tolerance);
+
+}
@@ -0,0 +1,163 @@
+#include "sensors.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <future>
+
+void sensors::Rays::clear()
+{
+    origins.clear();
+    directions.clear();
+    max_lengths.clear();
+}
+
+void sensors::Rays::emplace_back(const b2Vec2& origin, const b2Vec2& direction, const float max_length)
+{
+    assert(std::fabs(direction.Length() - 1) < 1e-3);
+    assert(max_length >= 0);
+    origins.emplace_back(origin);
+    directions.emplace_back(direction);
+    max_lengths.emplace_back(max_length);
+}
+
+void sensors::Hits::reset(const Rays& rays)
+{
+    distances = rays.max_lengths;
+    categories.assign(rays.size(), none);
+}
+
+sensors::Grid::Grid(const b2AABB& bounds, const float cell_size_) :
+    lower(bounds.lowerBound),
+    upper(bounds.upperBound),
+    cell_size(cell_size_)
+{
+    assert(cell_size > 0);
+    assert(upper.x >= lower.x && upper.y >= lower.y);
+    width = std::max(1, static_cast<int>(std::ceil((upper.x - lower.x) / cell_size)));
+    height = std::max(1, static_cast<int>(std::ceil((upper.y - lower.y) / cell_size)));
+    upper = lower + cell_size * b2Vec2 { static_cast<float>(width), static_cast<float>(height) };
+}
+
+std::tuple<int, int> sensors::Grid::cellCoords(const b2Vec2& point) const
+{
+    const auto xx = static_cast<int>(std::floor((point.x - lower.x) / cell_size));
+    const auto yy = static_cast<int>(std::floor((point.y - lower.y) / cell_size));
+    return std::make_tuple(std::min(std::max(xx, 0), width - 1), std::min(std::max(yy, 0), height - 1));
+}
+
+void sensors::Grid::insert(const uint32_t item, const b2AABB& aabb)
+{
+    if (aabb.upperBound.x < lower.x || aabb.upperBound.y < lower.y || aabb.lowerBound.x > upper.x || aabb.lowerBound.y > upper.y)
+        return;
+
+    int xx_min, yy_min, xx_max, yy_max;
+    std::tie(xx_min, yy_min) = cellCoords(aabb.lowerBound);
+    std::tie(xx_max, yy_max) = cellCoords(aabb.upperBound);
+    for (auto yy=yy_min; yy<=yy_max; yy++)
+        for (auto xx=xx_min; xx<=xx_max; xx++)
+            pending.emplace_back(yy * width + xx, item);
+}
+
+void sensors::Grid::finalize()
+{
+    std::sort(std::begin(pending), std::end(pending));
+
+    cell_starts.assign(width * height + 1, 0);
+    for (const auto& pair : pending)
+        cell_starts[std::get<0>(pair) + 1]++;
+    for (size_t kk=1; kk<cell_starts.size(); kk++)
+        cell_starts[kk] += cell_starts[kk - 1];
+
+    items.clear();
+    items.reserve(pending.size());
+    for (const auto& pair : pending)
+        items.emplace_back(std::get<1>(pair));
+
+    pending.clear();
+    pending.shrink_to_fit();
+}
+
+float sensors::raycast_segment(const Segment& segment, const b2Vec2& origin, const b2Vec2& direction, const float best)
+{
+    const auto& aa = std::get<0>(segment);
+    const auto edge = std::get<1>(segment) - aa;
+    const auto denom = b2Cross(direction, edge);
+    if (std::fabs(denom) < 1e-12f)
+        return best;
+
+    const auto delta = aa - origin;
+    const auto tt = b2Cross(delta, edge) / denom;
+    const auto uu = b2Cross(delta, direction) / denom;
+    if (tt < 0 || uu < 0 || uu > 1)
+        return best;
+
+    return std::fmin(best, tt);
+}
+
+float sensors::raycast_circle(const b2Vec2& center, const float radius, const b2Vec2& origin, const b2Vec2& direction, const float best)
+{
+    const auto delta = origin - center;
+    const auto cc = b2Dot(delta, delta) - radius * radius;
+    if (cc < 0)
+        return best;
+
+    const auto bb = b2Dot(delta, direction);
+    if (bb > 0)
+        return best;
+
+    const auto discriminant = bb * bb - cc;
+    if (discriminant < 0)
+        return best;
+
+    return std::fmin(best, -bb - std::sqrt(discriminant));
+}
+
+sensors::Grid sensors::build_segment_grid(const std::vector<Segment>& segments, const b2AABB& bounds, const float cell_size)
+{
+    Grid grid(bounds, cell_size);
+    uint32_t index = 0;
+    for (const auto& segment : segments)
+    {
+        b2AABB aabb;
+        aabb.lowerBound = b2Min(std::get<0>(segment), std::get<1>(segment));
+        aabb.upperBound = b2Max(std::get<0>(segment), std::get<1>(segment));
+        grid.insert(index++, aabb);
+    }
+    grid.finalize();
+    return grid;
+}
+
+sensors::Grid sensors::build_circle_grid(const b2Vec2* centers, const size_t count, const float radius, const b2AABB& bounds, const float cell_size)
+{
+    Grid grid(bounds, cell_size);
+    for (size_t kk=0; kk<count; kk++)
+    {
+        b2AABB aabb;
+        aabb.lowerBound = centers[kk] - b2Vec2 { radius, radius };
+        aabb.upperBound = centers[kk] + b2Vec2 { radius, radius };
+        grid.insert(kk, aabb);
+    }
+    grid.finalize();
+    return grid;
+}
+
+void sensors::parallel_for(const size_t count, const size_t thread_count, const std::function<void(size_t, size_t)>& func)
+{
+    auto& pool = ThreadPool::global();
+    const auto chunk_count = std::max<size_t>(1, std::min(std::min(thread_count, pool.getThreadCount() + 1), count));
+    const auto chunk_size = (count + chunk_count - 1) / chunk_count;
+
+    std::vector<std::future<void>> chunks;
+    for (size_t kk=1; kk<chunk_count; kk++)
+    {
+        const auto begin = std::min(count, kk * chunk_size);
+        const auto end = std::min(count, begin + chunk_size);
+        chunks.emplace_back(pool.submit([&func, begin, end]() -> void { func(begin, end); }));
+    }
+
+    func(0, std::min(count, chunk_size));
+
+    for (auto& chunk : chunks)
+        chunk.get();
+}
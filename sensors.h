@@ -0,0 +1,193 @@
+#pragma once
+
+#include <Box2D/Common/b2Math.h>
+#include <Box2D/Collision/b2Collision.h>
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+namespace sensors
+{
+
+enum Category : uint8_t
+{
+    none = 0,
+    ground,
+    door,
+    crate,
+    water,
+    object, // ships and balls
+};
+
+// structure of arrays, directions are unit vectors
+struct Rays
+{
+    std::vector<b2Vec2> origins;
+    std::vector<b2Vec2> directions;
+    std::vector<float> max_lengths;
+
+    size_t size() const { return origins.size(); }
+    void clear();
+    void emplace_back(const b2Vec2& origin, const b2Vec2& direction, const float max_length);
+};
+
+// distance is max_length and category none when nothing is hit
+struct Hits
+{
+    std::vector<float> distances;
+    std::vector<Category> categories;
+
+    size_t size() const { return distances.size(); }
+    void reset(const Rays& rays);
+};
+
+// uniform grid of item indices binned by bounding box, stored as one array per grid
+class Grid
+{
+    public:
+        Grid() = default;
+        Grid(const b2AABB& bounds, const float cell_size);
+
+        void insert(const uint32_t item, const b2AABB& aabb);
+        void finalize();
+
+        bool isEmpty() const { return items.empty(); }
+        size_t getItemCount() const { return items.size(); }
+
+        // visits cells along the ray in order, test(item, best) returns the updated closest hit distance,
+        // traversal stops as soon as the best hit lies within the visited cells
+        template <typename Test>
+        float traverse(const b2Vec2& origin, const b2Vec2& direction, const float max_length, const Test& test) const;
+
+        // visits the items of every cell overlapping the box, items spanning several cells are visited once per cell
+        template <typename Visit>
+        void query(const b2AABB& aabb, const Visit& visit) const;
+
+    protected:
+        std::tuple<int, int> cellCoords(const b2Vec2& point) const;
+
+        b2Vec2 lower = { 0, 0 };
+        b2Vec2 upper = { 0, 0 };
+        float cell_size = 1;
+        int width = 0;
+        int height = 0;
+        std::vector<std::tuple<uint32_t, uint32_t>> pending; // cell, item
+        std::vector<uint32_t> cell_starts;
+        std::vector<uint32_t> items;
+};
+
+using Segment = std::tuple<b2Vec2, b2Vec2>;
+
+// distance along the ray to the segment, or best when it is farther or missed
+float raycast_segment(const Segment& segment, const b2Vec2& origin, const b2Vec2& direction, const float best);
+
+// rays starting inside the circle ignore it, like box2d shapes
+float raycast_circle(const b2Vec2& center, const float radius, const b2Vec2& origin, const b2Vec2& direction, const float best);
+
+Grid build_segment_grid(const std::vector<Segment>& segments, const b2AABB& bounds, const float cell_size);
+Grid build_circle_grid(const b2Vec2* centers, const size_t count, const float radius, const b2AABB& bounds, const float cell_size);
+
+// splits [0, count) into contiguous ranges processed by up to thread_count threads, the caller included,
+// the other ranges run on ThreadPool::global() so the caller must not be one of its tasks
+void parallel_for(const size_t count, const size_t thread_count, const std::function<void(size_t, size_t)>& func);
+
+template <typename Test>
+float Grid::traverse(const b2Vec2& origin, const b2Vec2& direction, const float max_length, const Test& test) const
+{
+    if (items.empty())
+        return max_length;
+
+    // clip the ray against the grid bounds
+    float t_enter = 0;
+    float t_exit = max_length;
+    for (int axis=0; axis<2; axis++)
+    {
+        const float oo = axis ? origin.y : origin.x;
+        const float dd = axis ? direction.y : direction.x;
+        const float ll = axis ? lower.y : lower.x;
+        const float uu = axis ? upper.y : upper.x;
+        if (std::fabs(dd) < 1e-12f)
+        {
+            if (oo < ll || oo > uu)
+                return max_length;
+            continue;
+        }
+        float t_aa = (ll - oo) / dd;
+        float t_bb = (uu - oo) / dd;
+        if (t_aa > t_bb)
+            std::swap(t_aa, t_bb);
+        t_enter = std::fmax(t_enter, t_aa);
+        t_exit = std::fmin(t_exit, t_bb);
+    }
+    if (t_enter > t_exit)
+        return max_length;
+
+    int xx, yy;
+    std::tie(xx, yy) = cellCoords(origin + t_enter * direction);
+
+    const int step_x = direction.x > 0 ? 1 : -1;
+    const int step_y = direction.y > 0 ? 1 : -1;
+    const auto next_boundary = [this](const int cell, const int step, const float base) -> float
+    {
+        return base + (step > 0 ? cell + 1 : cell) * cell_size;
+    };
+    const float inf = std::numeric_limits<float>::infinity();
+    float t_max_x = std::fabs(direction.x) < 1e-12f ? inf : (next_boundary(xx, step_x, lower.x) - origin.x) / direction.x;
+    float t_max_y = std::fabs(direction.y) < 1e-12f ? inf : (next_boundary(yy, step_y, lower.y) - origin.y) / direction.y;
+    const float t_delta_x = std::fabs(direction.x) < 1e-12f ? inf : cell_size / std::fabs(direction.x);
+    const float t_delta_y = std::fabs(direction.y) < 1e-12f ? inf : cell_size / std::fabs(direction.y);
+
+    float best = max_length;
+    while (true)
+    {
+        const auto cell = yy * width + xx;
+        for (auto kk=cell_starts[cell], kk_max=cell_starts[cell + 1]; kk<kk_max; kk++)
+            best = test(items[kk], best);
+
+        const float t_cell_exit = std::fmin(t_max_x, t_max_y);
+        if (best <= t_cell_exit || t_cell_exit > t_exit)
+            break;
+
+        if (t_max_x < t_max_y)
+        {
+            xx += step_x;
+            t_max_x += t_delta_x;
+        }
+        else
+        {
+            yy += step_y;
+            t_max_y += t_delta_y;
+        }
+
+        if (xx < 0 || yy < 0 || xx >= width || yy >= height)
+            break;
+    }
+
+    return best;
+}
+
+template <typename Visit>
+void Grid::query(const b2AABB& aabb, const Visit& visit) const
+{
+    if (items.empty())
+        return;
+    if (aabb.upperBound.x < lower.x || aabb.upperBound.y < lower.y || aabb.lowerBound.x > upper.x || aabb.lowerBound.y > upper.y)
+        return;
+
+    int xx_min, yy_min, xx_max, yy_max;
+    std::tie(xx_min, yy_min) = cellCoords(aabb.lowerBound);
+    std::tie(xx_max, yy_max) = cellCoords(aabb.upperBound);
+    for (auto yy=yy_min; yy<=yy_max; yy++)
+        for (auto xx=xx_min; xx<=xx_max; xx++)
+        {
+            const auto cell = yy * width + xx;
+            for (auto kk=cell_starts[cell], kk_max=cell_starts[cell + 1]; kk<kk_max; kk++)
+                visit(items[kk]);
+        }
+}
+
+}
@@ -0,0 +1,214 @@
+#include "simplify_polygons.h"
+
+#include <cassert>
+#include <cmath>
+#include <tuple>
+#include <vector>
+#include <algorithm>
+
+static float segment_distance(const b2Vec2& point, const b2Vec2& aa, const b2Vec2& bb)
+{
+    const auto edge = bb - aa;
+    const auto length_squared = edge.LengthSquared();
+    if (length_squared <= 0)
+        return (point - aa).Length();
+    const auto tt = std::fmin(1.f, std::fmax(0.f, b2Dot(point - aa, edge) / length_squared));
+    return (point - (aa + tt * edge)).Length();
+}
+
+// proper crossing, touching at a shared vertex does not count
+static bool segments_cross(const b2Vec2& aa, const b2Vec2& bb, const b2Vec2& cc, const b2Vec2& dd)
+{
+    const auto side = [](const b2Vec2& pp, const b2Vec2& qq, const b2Vec2& rr) -> float
+    {
+        return b2Cross(qq - pp, rr - pp);
+    };
+    const auto d1 = side(cc, dd, aa);
+    const auto d2 = side(cc, dd, bb);
+    const auto d3 = side(aa, bb, cc);
+    const auto d4 = side(aa, bb, dd);
+    return ((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0)) && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0));
+}
+
+polygons::Poly polygons::simplify(const Poly& poly, const float tolerance)
+{
+    return simplify(poly.data(), poly.size(), tolerance);
+}
+
+polygons::Poly polygons::simplify(const b2Vec2* points, const size_t count, const float tolerance)
+{
+    if (tolerance <= 0 || count <= 3)
+        return Poly(points, points + count);
+
+    const auto at = [points, count](const size_t kk) -> const b2Vec2& { return points[kk % count]; };
+
+    // farthest interior point of the span between two kept vertices, index bb may wrap past count
+    const auto farthest = [&at](const size_t aa, const size_t bb) -> std::tuple<size_t, float>
+    {
+        size_t index = aa;
+        float distance = -1;
+        for (auto kk=aa + 1; kk<bb; kk++)
+        {
+            const auto distance_ = segment_distance(at(kk), at(aa), at(bb));
+            if (distance_ > distance)
+            {
+                index = kk;
+                distance = distance_;
+            }
+        }
+        return std::make_tuple(index, distance);
+    };
+
+    std::vector<bool> keep(count, false);
+
+    { // anchors are the first vertex and the one farthest from it
+        size_t anchor = 0;
+        for (size_t kk=1; kk<count; kk++)
+            if ((points[kk] - points[0]).LengthSquared() > (points[anchor] - points[0]).LengthSquared())
+                anchor = kk;
+        if (!anchor)
+            return Poly(points, points + count);
+        keep[0] = true;
+        keep[anchor] = true;
+
+        std::vector<std::tuple<size_t, size_t>> spans { std::make_tuple(0, anchor), std::make_tuple(anchor, count) };
+        while (!spans.empty())
+        {
+            size_t aa, bb;
+            std::tie(aa, bb) = spans.back();
+            spans.pop_back();
+
+            size_t index;
+            float distance;
+            std::tie(index, distance) = farthest(aa, bb);
+            if (distance <= tolerance)
+                continue;
+
+            keep[index % count] = true;
+            spans.emplace_back(aa, index);
+            spans.emplace_back(index, bb);
+        }
+    }
+
+    // topology, the span of a crossing edge gets its farthest point back until nothing crosses.
+    // kept edges are named by their start vertex and bucketed in a uniform grid, an edge is stale once
+    // its start points elsewhere, only the edges of restored spans and those they crossed are checked again
+    std::vector<size_t> next(count, 0);
+    std::vector<size_t> pending;
+    {
+        size_t last = 0;
+        for (size_t kk=1; kk<count; kk++)
+            if (keep[kk])
+            {
+                next[last] = kk;
+                pending.emplace_back(last);
+                last = kk;
+            }
+        next[last] = 0;
+        pending.emplace_back(last);
+    }
+    const auto span_end = [&next, count](const size_t aa) -> size_t { return next[aa] > aa ? next[aa] : next[aa] + count; };
+
+    b2Vec2 lower = points[0];
+    b2Vec2 upper = points[0];
+    for (size_t kk=1; kk<count; kk++)
+    {
+        lower = b2Min(lower, points[kk]);
+        upper = b2Max(upper, points[kk]);
+    }
+    const auto side = std::max<size_t>(1, std::min<size_t>(1024, std::sqrt(pending.size())));
+    const auto extent = std::fmax(upper.x - lower.x, upper.y - lower.y);
+    const auto cell_size = extent > 0 ? extent / side : 1.f;
+    const auto cell = [&side, &cell_size](const float value, const float lower_) -> size_t
+    {
+        return std::min(side - 1, static_cast<size_t>(std::fmax(0.f, (value - lower_) / cell_size)));
+    };
+
+    using Cells = std::tuple<size_t, size_t, size_t, size_t>; // xx min, xx max, yy min, yy max
+    const auto edge_cells = [&at, &span_end, &cell, &lower](const size_t aa) -> Cells
+    {
+        const auto& pp = at(aa);
+        const auto& qq = at(span_end(aa));
+        return std::make_tuple(cell(std::fmin(pp.x, qq.x), lower.x), cell(std::fmax(pp.x, qq.x), lower.x), cell(std::fmin(pp.y, qq.y), lower.y), cell(std::fmax(pp.y, qq.y), lower.y));
+    };
+
+    std::vector<std::vector<std::tuple<size_t, size_t>>> grid(side * side);
+    const auto insert = [&grid, &next, &side, &edge_cells](const size_t aa) -> void
+    {
+        size_t x0, x1, y0, y1;
+        std::tie(x0, x1, y0, y1) = edge_cells(aa);
+        for (auto yy=y0; yy<=y1; yy++)
+            for (auto xx=x0; xx<=x1; xx++)
+                grid[yy * side + xx].emplace_back(aa, next[aa]);
+    };
+    for (const auto aa : pending)
+        insert(aa);
+
+    // returns false when the span dropped nothing
+    const auto restore = [&keep, &next, &pending, &farthest, &span_end, &insert, count](const size_t aa) -> bool
+    {
+        if (span_end(aa) - aa < 2)
+            return false;
+        const auto index = std::get<0>(farthest(aa, span_end(aa))) % count;
+        assert(!keep[index]);
+        keep[index] = true;
+        next[index] = next[aa];
+        next[aa] = index;
+        insert(aa);
+        insert(index);
+        pending.emplace_back(aa);
+        pending.emplace_back(index);
+        return true;
+    };
+
+    std::vector<size_t> seen(count, 0);
+    size_t stamp = 0;
+    while (!pending.empty())
+    {
+        const auto aa = pending.back();
+        pending.pop_back();
+        assert(keep[aa]);
+
+        stamp++;
+        size_t crossed = count;
+        size_t x0, x1, y0, y1;
+        std::tie(x0, x1, y0, y1) = edge_cells(aa);
+        for (auto yy=y0; crossed == count && yy<=y1; yy++)
+            for (auto xx=x0; crossed == count && xx<=x1; xx++)
+                for (const auto& edge : grid[yy * side + xx])
+                {
+                    const auto cc = std::get<0>(edge);
+                    if (cc == aa || next[cc] != std::get<1>(edge) || seen[cc] == stamp)
+                        continue;
+                    seen[cc] = stamp;
+                    if (next[cc] == aa || next[aa] == cc)
+                        continue; // adjacent
+                    if (!segments_cross(at(aa), at(span_end(aa)), at(cc), at(span_end(cc))))
+                        continue;
+                    if (span_end(aa) - aa < 2 && span_end(cc) - cc < 2)
+                        continue; // the input crosses itself there, nothing to restore
+                    crossed = cc;
+                    break;
+                }
+
+        if (crossed == count)
+            continue;
+
+        // restore a point in whichever span dropped points, the edge is checked again either way
+        const auto restored_aa = restore(aa);
+        const auto restored_cc = restore(crossed);
+        assert(restored_aa || restored_cc);
+        if (!restored_aa)
+            pending.emplace_back(aa);
+    }
+
+    Poly poly_;
+    for (size_t kk=0; kk<count; kk++)
+        if (keep[kk])
+            poly_.emplace_back(points[kk]);
+
+    if (poly_.size() < 3)
+        return Poly(points, points + count);
+
+    return poly_;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "data_polygons.h"
+
+namespace polygons
+{
+
+// closed polygon douglas-peucker, no vertex farther than tolerance from the result is dropped,
+// dropped spans are restored until no two edges of the result cross, crossings between input edges are kept.
+// polygons are simplified one at a time, edges of neighbour polygons may still cross each other when tolerance
+// exceeds their gap
+Poly simplify(const Poly& poly, const float tolerance);
+Poly simplify(const b2Vec2* points, const size_t count, const float tolerance);
+
+}
@@ -0,0 +1,861 @@
+#include "svg_polygons.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+using polygons::Color;
+using polygons::Poly;
+using polygons::PolySoup;
+
+static void flatten_cubic(Poly& poly, const b2Vec2& p0, const b2Vec2& p1, const b2Vec2& p2, const b2Vec2& p3, const float tolerance, const int depth)
+{
+    const auto chord = p3 - p0;
+    const auto length = chord.Length();
+    const auto deviation = length > 0 ?
+        std::max(std::fabs(b2Cross(p1 - p0, chord)), std::fabs(b2Cross(p2 - p0, chord))) / length :
+        std::max((p1 - p0).Length(), (p2 - p0).Length());
+
+    if (deviation <= tolerance || depth >= 16)
+    {
+        poly.emplace_back(p3);
+        return;
+    }
+
+    const auto p01 = .5f * (p0 + p1);
+    const auto p12 = .5f * (p1 + p2);
+    const auto p23 = .5f * (p2 + p3);
+    const auto p012 = .5f * (p01 + p12);
+    const auto p123 = .5f * (p12 + p23);
+    const auto mid = .5f * (p012 + p123);
+    flatten_cubic(poly, p0, p01, p012, mid, tolerance, depth + 1);
+    flatten_cubic(poly, mid, p123, p23, p3, tolerance, depth + 1);
+}
+
+void polygons::flatten_cubic(Poly& poly, const b2Vec2& p1, const b2Vec2& p2, const b2Vec2& p3, const float tolerance)
+{
+    assert(!poly.empty());
+    const auto p0 = poly.back();
+    ::flatten_cubic(poly, p0, p1, p2, p3, tolerance, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// x' = a x + c y + e, y' = b x + d y + f
+struct Affine
+{
+    double a = 1, b = 0, c = 0, d = 1, e = 0, f = 0;
+
+    // applies other first
+    Affine operator*(const Affine& other) const
+    {
+        return {
+            a * other.a + c * other.b, b * other.a + d * other.b,
+            a * other.c + c * other.d, b * other.c + d * other.d,
+            a * other.e + c * other.f + e, b * other.e + d * other.f + f,
+        };
+    }
+
+    b2Vec2 map(const double xx, const double yy) const
+    {
+        using Scalar = decltype(b2Vec2::x);
+        return { static_cast<Scalar>(a * xx + c * yy + e), static_cast<Scalar>(b * xx + d * yy + f) };
+    }
+};
+
+// locale independent, setlocale from QApplication must not change how maps parse
+static bool next_number(const std::string& str, size_t& pos, double& value)
+{
+    const auto size = str.size();
+    while (pos < size && (std::isspace(static_cast<unsigned char>(str[pos])) || str[pos] == ','))
+        pos++;
+
+    auto kk = pos;
+    double sign = 1;
+    if (kk < size && (str[kk] == '-' || str[kk] == '+'))
+        sign = str[kk++] == '-' ? -1 : 1;
+
+    double mantissa = 0;
+    bool has_digits = false;
+    while (kk < size && std::isdigit(static_cast<unsigned char>(str[kk])))
+    {
+        mantissa = 10 * mantissa + (str[kk++] - '0');
+        has_digits = true;
+    }
+    if (kk < size && str[kk] == '.')
+    {
+        kk++;
+        double scale = .1;
+        while (kk < size && std::isdigit(static_cast<unsigned char>(str[kk])))
+        {
+            mantissa += scale * (str[kk++] - '0');
+            scale *= .1;
+            has_digits = true;
+        }
+    }
+    if (!has_digits)
+        return false;
+
+    int exponent = 0;
+    if (kk < size && (str[kk] == 'e' || str[kk] == 'E'))
+    {
+        auto ll = kk + 1;
+        int exponent_sign = 1;
+        if (ll < size && (str[ll] == '-' || str[ll] == '+'))
+            exponent_sign = str[ll++] == '-' ? -1 : 1;
+        if (ll < size && std::isdigit(static_cast<unsigned char>(str[ll])))
+        {
+            while (ll < size && std::isdigit(static_cast<unsigned char>(str[ll])))
+                exponent = 10 * exponent + (str[ll++] - '0');
+            exponent *= exponent_sign;
+            kk = ll;
+        }
+    }
+
+    value = sign * mantissa * std::pow(10., exponent);
+    pos = kk;
+    return true;
+}
+
+// arc flags may be packed without separators
+static bool next_flag(const std::string& str, size_t& pos, bool& flag)
+{
+    const auto size = str.size();
+    while (pos < size && (std::isspace(static_cast<unsigned char>(str[pos])) || str[pos] == ','))
+        pos++;
+    if (pos >= size || (str[pos] != '0' && str[pos] != '1'))
+        return false;
+    flag = str[pos++] == '1';
+    return true;
+}
+
+// lengths with unit suffixes, in user units
+static double parse_length(const std::string& str, const double def)
+{
+    size_t pos = 0;
+    double value = 0;
+    if (!next_number(str, pos, value))
+        return def;
+    const auto unit = str.substr(pos, 2);
+    if (unit == "mm") return value * 96 / 25.4;
+    if (unit == "cm") return value * 96 / 2.54;
+    if (unit == "in") return value * 96;
+    if (unit == "pt") return value * 96 / 72;
+    return value;
+}
+
+static Affine parse_transform(const std::string& str)
+{
+    Affine transform;
+    size_t pos = 0;
+    while (pos < str.size())
+    {
+        const auto open = str.find('(', pos);
+        const auto close = str.find(')', open);
+        if (open == std::string::npos || close == std::string::npos)
+            break;
+
+        auto name = str.substr(pos, open - pos);
+        name.erase(std::remove_if(std::begin(name), std::end(name), [](const char cc) { return std::isspace(static_cast<unsigned char>(cc)) || cc == ','; }), std::end(name));
+
+        const auto args_str = str.substr(open + 1, close - open - 1);
+        std::vector<double> args;
+        size_t args_pos = 0;
+        double value;
+        while (next_number(args_str, args_pos, value))
+            args.emplace_back(value);
+        const auto arg_count = args.size();
+        args.resize(6, 0);
+
+        Affine current;
+        if (name == "matrix")
+            current = { args[0], args[1], args[2], args[3], args[4], args[5] };
+        else if (name == "translate")
+            current = { 1, 0, 0, 1, args[0], args[1] };
+        else if (name == "scale")
+            current = { args[0], 0, 0, arg_count > 1 ? args[1] : args[0], 0, 0 };
+        else if (name == "rotate")
+        {
+            const auto angle = args[0] * M_PI / 180;
+            const Affine rotation { std::cos(angle), std::sin(angle), -std::sin(angle), std::cos(angle), 0, 0 };
+            current = Affine { 1, 0, 0, 1, args[1], args[2] } * rotation * Affine { 1, 0, 0, 1, -args[1], -args[2] };
+        }
+        else if (name == "skewX")
+            current = { 1, 0, std::tan(args[0] * M_PI / 180), 1, 0, 0 };
+        else if (name == "skewY")
+            current = { 1, std::tan(args[0] * M_PI / 180), 0, 1, 0, 0 };
+
+        transform = transform * current;
+        pos = close + 1;
+    }
+    return transform;
+}
+
+static int hex_digit(const char cc)
+{
+    if (cc >= '0' && cc <= '9') return cc - '0';
+    if (cc >= 'a' && cc <= 'f') return cc - 'a' + 10;
+    if (cc >= 'A' && cc <= 'F') return cc - 'A' + 10;
+    return 0;
+}
+
+// false for none and paint servers, gradients have no single colour
+static bool parse_color(const std::string& str, Color& color)
+{
+    const auto to_color = [](const int rr, const int gg, const int bb) -> Color
+    {
+        return { rr / 255.f, gg / 255.f, bb / 255.f, 1 };
+    };
+
+    if (str.empty() || str == "none" || str.compare(0, 4, "url(") == 0)
+        return false;
+
+    if (str[0] == '#' && str.size() >= 7)
+    {
+        color = to_color(
+            16 * hex_digit(str[1]) + hex_digit(str[2]),
+            16 * hex_digit(str[3]) + hex_digit(str[4]),
+            16 * hex_digit(str[5]) + hex_digit(str[6]));
+        return true;
+    }
+
+    if (str[0] == '#' && str.size() >= 4)
+    {
+        color = to_color(17 * hex_digit(str[1]), 17 * hex_digit(str[2]), 17 * hex_digit(str[3]));
+        return true;
+    }
+
+    if (str.compare(0, 4, "rgb(") == 0)
+    {
+        const bool percent = str.find('%') != std::string::npos;
+        size_t pos = 4;
+        double rr = 0, gg = 0, bb = 0;
+        next_number(str, pos, rr);
+        pos = std::min(str.find_first_of(", ", pos), str.size());
+        next_number(str, pos, gg);
+        pos = std::min(str.find_first_of(", ", pos), str.size());
+        next_number(str, pos, bb);
+        const double scale = percent ? 2.55 : 1;
+        color = to_color(std::lround(rr * scale), std::lround(gg * scale), std::lround(bb * scale));
+        return true;
+    }
+
+    using Named = std::tuple<const char*, int, int, int>;
+    static const Named named_colors[] = {
+        Named { "black", 0, 0, 0 },
+        Named { "white", 255, 255, 255 },
+        Named { "red", 255, 0, 0 },
+        Named { "lime", 0, 255, 0 },
+        Named { "green", 0, 128, 0 },
+        Named { "blue", 0, 0, 255 },
+        Named { "yellow", 255, 255, 0 },
+        Named { "cyan", 0, 255, 255 },
+        Named { "aqua", 0, 255, 255 },
+        Named { "magenta", 255, 0, 255 },
+        Named { "fuchsia", 255, 0, 255 },
+        Named { "orange", 255, 165, 0 },
+        Named { "gray", 128, 128, 128 },
+        Named { "grey", 128, 128, 128 },
+        Named { "currentColor", 0, 0, 0 },
+    };
+    for (const auto& named : named_colors)
+        if (str == std::get<0>(named))
+        {
+            color = to_color(std::get<1>(named), std::get<2>(named), std::get<3>(named));
+            return true;
+        }
+
+    return false;
+}
+
+static float parse_float(const std::string& str, const float def)
+{
+    size_t pos = 0;
+    double value = 0;
+    return next_number(str, pos, value) ? static_cast<float>(value) : def;
+}
+
+static std::string trim(const std::string& str)
+{
+    const auto begin = str.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos)
+        return {};
+    const auto end = str.find_last_not_of(" \t\r\n");
+    return str.substr(begin, end - begin + 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+// subpaths are closed and concatenated like QPainterPath::toFillPolygon
+struct PathBuilder
+{
+    const Affine& transform;
+    const float tolerance;
+    Poly poly;
+    b2Vec2 subpath_start = { 0, 0 };
+
+    void moveTo(const double xx, const double yy)
+    {
+        if (!poly.empty() && !(poly.back() == subpath_start))
+            poly.emplace_back(subpath_start);
+        subpath_start = transform.map(xx, yy);
+        poly.emplace_back(subpath_start);
+    }
+
+    void lineTo(const double xx, const double yy)
+    {
+        poly.emplace_back(transform.map(xx, yy));
+    }
+
+    void cubicTo(const double x1, const double y1, const double x2, const double y2, const double x3, const double y3)
+    {
+        if (poly.empty())
+            moveTo(x1, y1);
+        polygons::flatten_cubic(poly, transform.map(x1, y1), transform.map(x2, y2), transform.map(x3, y3), tolerance);
+    }
+
+    // svg implementation notes endpoint to center parameterization, at most a quarter turn per cubic
+    void arcTo(const double x0, const double y0, double rx, double ry, const double rotation, const bool large_arc, const bool sweep, const double x1, const double y1)
+    {
+        rx = std::fabs(rx);
+        ry = std::fabs(ry);
+        if (rx == 0 || ry == 0)
+        {
+            lineTo(x1, y1);
+            return;
+        }
+
+        const auto phi = rotation * M_PI / 180;
+        const auto cos_phi = std::cos(phi);
+        const auto sin_phi = std::sin(phi);
+        const auto dx = (x0 - x1) / 2;
+        const auto dy = (y0 - y1) / 2;
+        const auto xp = cos_phi * dx + sin_phi * dy;
+        const auto yp = -sin_phi * dx + cos_phi * dy;
+
+        const auto lambda = xp * xp / (rx * rx) + yp * yp / (ry * ry);
+        if (lambda > 1)
+        {
+            rx *= std::sqrt(lambda);
+            ry *= std::sqrt(lambda);
+        }
+
+        const auto numerator = rx * rx * ry * ry - rx * rx * yp * yp - ry * ry * xp * xp;
+        const auto denominator = rx * rx * yp * yp + ry * ry * xp * xp;
+        auto coef = denominator > 0 ? std::sqrt(std::max(0., numerator / denominator)) : 0;
+        if (large_arc == sweep)
+            coef = -coef;
+        const auto cxp = coef * rx * yp / ry;
+        const auto cyp = -coef * ry * xp / rx;
+        const auto cx = cos_phi * cxp - sin_phi * cyp + (x0 + x1) / 2;
+        const auto cy = sin_phi * cxp + cos_phi * cyp + (y0 + y1) / 2;
+
+        const auto angle = [](const double ux, const double uy, const double vx, const double vy) -> double
+        {
+            return std::atan2(ux * vy - uy * vx, ux * vx + uy * vy);
+        };
+        const auto theta = angle(1, 0, (xp - cxp) / rx, (yp - cyp) / ry);
+        auto delta = angle((xp - cxp) / rx, (yp - cyp) / ry, (-xp - cxp) / rx, (-yp - cyp) / ry);
+        if (!sweep && delta > 0)
+            delta -= 2 * M_PI;
+        if (sweep && delta < 0)
+            delta += 2 * M_PI;
+
+        const auto segment_count = std::max(1, static_cast<int>(std::ceil(std::fabs(delta) / (M_PI / 2) - 1e-9)));
+        const auto step = delta / segment_count;
+        const auto kappa = 4. / 3 * std::tan(step / 4);
+        const auto point = [&](const double tt, const double scale, const double offset) -> std::tuple<double, double>
+        {
+            // point on the ellipse at tt, moved along the tangent by offset
+            const auto ex = rx * (std::cos(tt) - offset * scale * std::sin(tt));
+            const auto ey = ry * (std::sin(tt) + offset * scale * std::cos(tt));
+            return std::make_tuple(cos_phi * ex - sin_phi * ey + cx, sin_phi * ex + cos_phi * ey + cy);
+        };
+
+        for (int kk=0; kk<segment_count; kk++)
+        {
+            const auto t0 = theta + kk * step;
+            const auto t1 = t0 + step;
+            double ax, ay, bx, by, ex, ey;
+            std::tie(ax, ay) = point(t0, kappa, 1);
+            std::tie(bx, by) = point(t1, kappa, -1);
+            std::tie(ex, ey) = kk + 1 == segment_count ? std::make_tuple(x1, y1) : point(t1, 0, 0);
+            cubicTo(ax, ay, bx, by, ex, ey);
+        }
+    }
+
+    Poly finish()
+    {
+        Poly poly_;
+        for (const auto& point : poly)
+            if (poly_.empty() || !(poly_.back() == point))
+                poly_.emplace_back(point);
+
+        while (poly_.size() > 1 && poly_.back() == poly_.front())
+            poly_.pop_back();
+
+        if (poly_.size() < 2)
+            return {};
+
+        return poly_;
+    }
+};
+
+static Poly parse_path(const std::string& data, const Affine& transform, const float tolerance)
+{
+    PathBuilder builder { transform, tolerance };
+
+    double cur_x = 0, cur_y = 0;
+    double start_x = 0, start_y = 0;
+    double ctrl_x = 0, ctrl_y = 0; // last control point, for smooth curves
+    char command = 0;
+    char previous = 0;
+    size_t pos = 0;
+
+    while (true)
+    {
+        while (pos < data.size() && (std::isspace(static_cast<unsigned char>(data[pos])) || data[pos] == ','))
+            pos++;
+        if (pos >= data.size())
+            break;
+
+        if (std::isalpha(static_cast<unsigned char>(data[pos])))
+            command = data[pos++];
+        else if (!command)
+            break;
+
+        const bool relative = std::islower(static_cast<unsigned char>(command));
+        const double base_x = relative ? cur_x : 0;
+        const double base_y = relative ? cur_y : 0;
+
+        double args[7];
+        const auto read = [&data, &pos, &args](const int count) -> bool
+        {
+            for (int kk=0; kk<count; kk++)
+                if (!next_number(data, pos, args[kk]))
+                    return false;
+            return true;
+        };
+
+        bool ok = true;
+        switch (std::toupper(static_cast<unsigned char>(command)))
+        {
+            case 'M':
+                if (!(ok = read(2))) break;
+                cur_x = base_x + args[0];
+                cur_y = base_y + args[1];
+                start_x = cur_x;
+                start_y = cur_y;
+                builder.moveTo(cur_x, cur_y);
+                command = relative ? 'l' : 'L'; // implicit lines follow
+                break;
+            case 'L':
+                if (!(ok = read(2))) break;
+                cur_x = base_x + args[0];
+                cur_y = base_y + args[1];
+                builder.lineTo(cur_x, cur_y);
+                break;
+            case 'H':
+                if (!(ok = read(1))) break;
+                cur_x = base_x + args[0];
+                builder.lineTo(cur_x, cur_y);
+                break;
+            case 'V':
+                if (!(ok = read(1))) break;
+                cur_y = base_y + args[0];
+                builder.lineTo(cur_x, cur_y);
+                break;
+            case 'C':
+                if (!(ok = read(6))) break;
+                builder.cubicTo(base_x + args[0], base_y + args[1], base_x + args[2], base_y + args[3], base_x + args[4], base_y + args[5]);
+                ctrl_x = base_x + args[2];
+                ctrl_y = base_y + args[3];
+                cur_x = base_x + args[4];
+                cur_y = base_y + args[5];
+                break;
+            case 'S':
+            {
+                if (!(ok = read(4))) break;
+                const bool smooth = std::strchr("CcSs", previous);
+                const auto x1 = smooth ? 2 * cur_x - ctrl_x : cur_x;
+                const auto y1 = smooth ? 2 * cur_y - ctrl_y : cur_y;
+                builder.cubicTo(x1, y1, base_x + args[0], base_y + args[1], base_x + args[2], base_y + args[3]);
+                ctrl_x = base_x + args[0];
+                ctrl_y = base_y + args[1];
+                cur_x = base_x + args[2];
+                cur_y = base_y + args[3];
+                break;
+            }
+            case 'Q':
+            case 'T':
+            {
+                const bool is_smooth = std::toupper(static_cast<unsigned char>(command)) == 'T';
+                if (!(ok = read(is_smooth ? 2 : 4))) break;
+                const bool smooth = std::strchr("QqTt", previous);
+                const auto qx = is_smooth ? (smooth ? 2 * cur_x - ctrl_x : cur_x) : base_x + args[0];
+                const auto qy = is_smooth ? (smooth ? 2 * cur_y - ctrl_y : cur_y) : base_y + args[1];
+                const auto ex = base_x + args[is_smooth ? 0 : 2];
+                const auto ey = base_y + args[is_smooth ? 1 : 3];
+                builder.cubicTo(cur_x + 2. / 3 * (qx - cur_x), cur_y + 2. / 3 * (qy - cur_y), ex + 2. / 3 * (qx - ex), ey + 2. / 3 * (qy - ey), ex, ey);
+                ctrl_x = qx;
+                ctrl_y = qy;
+                cur_x = ex;
+                cur_y = ey;
+                break;
+            }
+            case 'A':
+            {
+                bool large_arc, sweep;
+                if (!(ok = read(3) && next_flag(data, pos, large_arc) && next_flag(data, pos, sweep) && next_number(data, pos, args[3]) && next_number(data, pos, args[4]))) break;
+                const auto ex = base_x + args[3];
+                const auto ey = base_y + args[4];
+                builder.arcTo(cur_x, cur_y, args[0], args[1], args[2], large_arc, sweep, ex, ey);
+                cur_x = ex;
+                cur_y = ey;
+                break;
+            }
+            case 'Z':
+                builder.lineTo(start_x, start_y);
+                cur_x = start_x;
+                cur_y = start_y;
+                previous = command;
+                command = 0; // numbers may not follow a close
+                continue;
+            default:
+                ok = false;
+                break;
+        }
+
+        if (!ok)
+            break;
+        previous = command;
+    }
+
+    return builder.finish();
+}
+
+static std::vector<double> parse_numbers(const std::string& str)
+{
+    std::vector<double> values;
+    size_t pos = 0;
+    double value;
+    while (next_number(str, pos, value))
+        values.emplace_back(value);
+    return values;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+using Attributes = std::vector<std::tuple<std::string, std::string>>;
+
+struct Style
+{
+    bool has_fill = true;
+    Color fill = { 0, 0, 0, 1 };
+    float fill_opacity = 1;
+    bool has_stroke = false;
+    Color stroke = { 0, 0, 0, 1 };
+    float stroke_opacity = 1;
+    Affine transform;
+};
+
+static std::string attribute(const Attributes& attributes, const char* name)
+{
+    for (const auto& attr : attributes)
+        if (std::get<0>(attr) == name)
+            return std::get<1>(attr);
+    return {};
+}
+
+// presentation attributes first, then the style attribute overrides them; false when display is none
+static bool apply_style(Style& style, const Attributes& attributes)
+{
+    bool visible = true;
+    const auto apply = [&style, &visible](const std::string& name, const std::string& value) -> void
+    {
+        if (name == "fill")
+            style.has_fill = parse_color(value, style.fill);
+        else if (name == "stroke")
+            style.has_stroke = parse_color(value, style.stroke);
+        else if (name == "fill-opacity")
+            style.fill_opacity = parse_float(value, 1);
+        else if (name == "stroke-opacity")
+            style.stroke_opacity = parse_float(value, 1);
+        else if (name == "display")
+            visible &= value != "none";
+    };
+
+    std::string style_attr;
+    for (const auto& attr : attributes)
+    {
+        if (std::get<0>(attr) == "style")
+            style_attr = std::get<1>(attr);
+        else
+            apply(std::get<0>(attr), trim(std::get<1>(attr)));
+    }
+
+    size_t pos = 0;
+    while (pos < style_attr.size())
+    {
+        auto end = style_attr.find(';', pos);
+        if (end == std::string::npos)
+            end = style_attr.size();
+        const auto colon = style_attr.find(':', pos);
+        if (colon < end)
+            apply(trim(style_attr.substr(pos, colon - pos)), trim(style_attr.substr(colon + 1, end - colon - 1)));
+        pos = end + 1;
+    }
+
+    return visible;
+}
+
+static Poly shape_poly(const std::string& name, const Attributes& attributes, const Affine& transform, const float tolerance)
+{
+    const auto length = [&attributes](const char* attr_name, const double def = 0) -> double
+    {
+        return parse_length(attribute(attributes, attr_name), def);
+    };
+
+    PathBuilder builder { transform, tolerance };
+
+    if (name == "path")
+        return parse_path(attribute(attributes, "d"), transform, tolerance);
+
+    if (name == "polygon" || name == "polyline")
+    {
+        const auto values = parse_numbers(attribute(attributes, "points"));
+        for (size_t kk=0; kk + 1<values.size(); kk+=2)
+            if (kk) builder.lineTo(values[kk], values[kk + 1]);
+            else builder.moveTo(values[kk], values[kk + 1]);
+        return builder.finish();
+    }
+
+    if (name == "rect")
+    {
+        const auto xx = length("x");
+        const auto yy = length("y");
+        const auto width = length("width");
+        const auto height = length("height");
+        if (width <= 0 || height <= 0)
+            return {};
+
+        auto rx = length("rx", -1);
+        auto ry = length("ry", -1);
+        if (rx < 0) rx = ry;
+        if (ry < 0) ry = rx;
+        rx = std::min(std::max(rx, 0.), width / 2);
+        ry = std::min(std::max(ry, 0.), height / 2);
+
+        if (rx == 0 || ry == 0)
+        {
+            builder.moveTo(xx, yy);
+            builder.lineTo(xx + width, yy);
+            builder.lineTo(xx + width, yy + height);
+            builder.lineTo(xx, yy + height);
+            return builder.finish();
+        }
+
+        const auto kx = rx * (1 - 0.5522847498);
+        const auto ky = ry * (1 - 0.5522847498);
+        const auto right = xx + width;
+        const auto bottom = yy + height;
+        builder.moveTo(xx + rx, yy);
+        builder.lineTo(right - rx, yy);
+        builder.cubicTo(right - kx, yy, right, yy + ky, right, yy + ry);
+        builder.lineTo(right, bottom - ry);
+        builder.cubicTo(right, bottom - ky, right - kx, bottom, right - rx, bottom);
+        builder.lineTo(xx + rx, bottom);
+        builder.cubicTo(xx + kx, bottom, xx, bottom - ky, xx, bottom - ry);
+        builder.lineTo(xx, yy + ry);
+        builder.cubicTo(xx, yy + ky, xx + kx, yy, xx + rx, yy);
+        return builder.finish();
+    }
+
+    if (name == "circle" || name == "ellipse")
+    {
+        const auto cx = length("cx");
+        const auto cy = length("cy");
+        const auto rx = name == "circle" ? length("r") : length("rx");
+        const auto ry = name == "circle" ? rx : length("ry");
+        if (rx <= 0 || ry <= 0)
+            return {};
+
+        const auto kx = rx * 0.5522847498;
+        const auto ky = ry * 0.5522847498;
+        builder.moveTo(cx + rx, cy);
+        builder.cubicTo(cx + rx, cy + ky, cx + kx, cy + ry, cx, cy + ry);
+        builder.cubicTo(cx - kx, cy + ry, cx - rx, cy + ky, cx - rx, cy);
+        builder.cubicTo(cx - rx, cy - ky, cx - kx, cy - ry, cx, cy - ry);
+        builder.cubicTo(cx + kx, cy - ry, cx + rx, cy - ky, cx + rx, cy);
+        return builder.finish();
+    }
+
+    return {};
+}
+
+// viewbox onto the unit square, stretched like QSvgRenderer does
+static Affine root_transform(const Attributes& attributes)
+{
+    const auto view_box = parse_numbers(attribute(attributes, "viewBox"));
+    if (view_box.size() == 4 && view_box[2] > 0 && view_box[3] > 0)
+        return Affine { 1 / view_box[2], 0, 0, 1 / view_box[3], 0, 0 } * Affine { 1, 0, 0, 1, -view_box[0], -view_box[1] };
+
+    const auto width = parse_length(attribute(attributes, "width"), 0);
+    const auto height = parse_length(attribute(attributes, "height"), 0);
+    if (width > 0 && height > 0)
+        return Affine { 1 / width, 0, 0, 1 / height, 0, 0 };
+
+    return {};
+}
+
+std::tuple<PolySoup, PolySoup> polygons::parse_svg(const std::string& contents, const float tolerance)
+{
+    assert(tolerance > 0);
+
+    UniquePolySoup pen_polys;
+    UniquePolySoup brush_polys;
+
+    static const std::vector<std::string> skipped_elements {
+        "defs", "metadata", "title", "desc", "text", "image", "clipPath", "mask", "symbol", "pattern", "marker", "linearGradient", "radialGradient", "style", "script",
+    };
+
+    std::vector<Style> styles { Style() };
+    size_t skip_depth = 0; // inside an element whose subtree is ignored
+    bool has_root = false;
+
+    const auto size = contents.size();
+    size_t pos = 0;
+    while (pos < size)
+    {
+        pos = contents.find('<', pos);
+        if (pos == std::string::npos)
+            break;
+
+        const auto skip_to = [&contents, &pos](const char* terminator) -> void
+        {
+            const auto end = contents.find(terminator, pos);
+            pos = end == std::string::npos ? contents.size() : end + std::strlen(terminator);
+        };
+
+        if (contents.compare(pos, 4, "<!--") == 0) { skip_to("-->"); continue; }
+        if (contents.compare(pos, 9, "<![CDATA[") == 0) { skip_to("]]>"); continue; }
+        if (contents.compare(pos, 2, "<?") == 0) { skip_to("?>"); continue; }
+        if (contents.compare(pos, 2, "<!") == 0) { skip_to(">"); continue; }
+
+        if (contents.compare(pos, 2, "</") == 0)
+        {
+            skip_to(">");
+            if (skip_depth) skip_depth--;
+            else if (styles.size() > 1) styles.pop_back();
+            continue;
+        }
+
+        // opening tag
+        pos++;
+        const auto name_end = contents.find_first_of(" \t\r\n/>", pos);
+        if (name_end == std::string::npos)
+            break;
+        auto name = contents.substr(pos, name_end - pos);
+        if (name.compare(0, 4, "svg:") == 0)
+            name.erase(0, 4);
+        pos = name_end;
+
+        Attributes attributes;
+        bool self_closing = false;
+        while (pos < size)
+        {
+            while (pos < size && std::isspace(static_cast<unsigned char>(contents[pos])))
+                pos++;
+            if (pos >= size)
+                break;
+            if (contents[pos] == '>')
+            {
+                pos++;
+                break;
+            }
+            if (contents[pos] == '/')
+            {
+                self_closing = true;
+                pos++;
+                continue;
+            }
+
+            const auto equal = contents.find('=', pos);
+            if (equal == std::string::npos)
+            {
+                pos = size;
+                break;
+            }
+            const auto attr_name = trim(contents.substr(pos, equal - pos));
+            const auto quote_pos = contents.find_first_of("\"'", equal);
+            if (quote_pos == std::string::npos)
+            {
+                pos = size;
+                break;
+            }
+            const auto value_end = contents.find(contents[quote_pos], quote_pos + 1);
+            if (value_end == std::string::npos)
+            {
+                pos = size;
+                break;
+            }
+            attributes.emplace_back(attr_name, contents.substr(quote_pos + 1, value_end - quote_pos - 1));
+            pos = value_end + 1;
+        }
+
+        if (skip_depth)
+        {
+            if (!self_closing) skip_depth++;
+            continue;
+        }
+
+        const bool is_skipped = name.find(':') != std::string::npos ||
+            std::find(std::cbegin(skipped_elements), std::cend(skipped_elements), name) != std::cend(skipped_elements);
+
+        Style style = styles.back();
+        if (name == "svg" && !has_root)
+        {
+            style.transform = root_transform(attributes);
+            has_root = true;
+        }
+        else
+        {
+            const auto transform_attr = attribute(attributes, "transform");
+            if (!transform_attr.empty())
+                style.transform = style.transform * parse_transform(transform_attr);
+        }
+        const bool visible = apply_style(style, attributes);
+
+        if (is_skipped || !visible)
+        {
+            if (!self_closing) skip_depth++;
+            continue;
+        }
+
+        if (style.has_fill || style.has_stroke)
+        {
+            const auto poly = shape_poly(name, attributes, style.transform, tolerance);
+            if (!poly.empty())
+            {
+                if (style.has_fill)
+                {
+                    auto color = style.fill;
+                    color.w *= style.fill_opacity;
+                    brush_polys.push(poly, color);
+                }
+                else
+                {
+                    auto color = style.stroke;
+                    color.w *= style.stroke_opacity;
+                    pen_polys.push(poly, color);
+                }
+            }
+        }
+
+        if (!self_closing)
+            styles.emplace_back(style);
+    }
+
+    return std::make_tuple(std::move(pen_polys.soup), std::move(brush_polys.soup));
+}
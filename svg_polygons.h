@@ -0,0 +1,18 @@
+#pragma once
+
+#include "data_polygons.h"
+
+namespace polygons
+{
+
+// de casteljau subdivision from the last vertex of poly, appends points until both control points lie within tolerance of the chord
+void flatten_cubic(Poly& poly, const b2Vec2& p1, const b2Vec2& p2, const b2Vec2& p3, const float tolerance);
+
+// single pass over the svg subset inkscape levels use, no qt involved:
+// path, rect, polygon, polyline, circle and ellipse with fill or stroke colours, nested transforms and display:none,
+// text, images, gradients and defs are skipped.
+// the viewbox is mapped onto the unit square like QSvgRenderer::render(painter, QRectF(0, 0, 1, 1)),
+// filled shapes go to the second soup, stroked only shapes to the first one, both in document order without exact duplicates
+std::tuple<PolySoup, PolySoup> parse_svg(const std::string& contents, const float tolerance);
+
+}
@@ -0,0 +1,170 @@
+#include "ArenaAllocator.h"
+
+#include "Box2D/Dynamics/b2World.h"
+#include "Box2D/Dynamics/b2Body.h"
+#include "Box2D/Dynamics/b2Fixture.h"
+#include "Box2D/Collision/Shapes/b2PolygonShape.h"
+#include "Box2D/Particle/b2ParticleSystem.h"
+
+#include <iostream>
+#include <thread>
+#include <memory>
+#include <chrono>
+
+template <typename BB>
+void
+require(const BB cond, const std::string& message)
+{
+    if (!static_cast<bool>(cond))
+        throw std::runtime_error(message);
+}
+
+void
+populate(b2World& world, const int count)
+{
+    b2PolygonShape shape;
+    shape.SetAsBox(1, 1);
+
+    for (auto kk=0; kk<count; kk++)
+    {
+        b2BodyDef def;
+        def.type = b2_dynamicBody;
+        def.position.Set(3 * (kk % 100), 3 * (kk / 100));
+        auto body = world.CreateBody(&def);
+        body->CreateFixture(&shape, 1);
+    }
+
+    b2ParticleSystemDef system_def;
+    auto system = world.CreateParticleSystem(&system_def);
+    b2ParticleGroupDef group_def;
+    group_def.shape = &shape;
+    shape.SetAsBox(20, 20);
+    system->CreateParticleGroup(group_def);
+
+    for (auto kk=0; kk<10; kk++)
+        world.Step(1 / 60.f, 6, 2, 1);
+}
+
+float
+run_level(const bool use_arena, const int count)
+{
+    using std::cout;
+    using std::endl;
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<float, std::milli>;
+
+    auto arena = std::make_unique<ArenaAllocator>(use_arena);
+    auto world = std::make_unique<b2World>(b2Vec2 { 0, -10 });
+    populate(*world, count);
+
+    const auto start = Clock::now();
+    world = nullptr;
+    const auto stats = arena->getStats();
+    arena = nullptr;
+    const auto teardown_ms = Milliseconds(Clock::now() - start).count();
+
+    cout << (use_arena ? "arena " : "heap  ") << count << " bodies ";
+    cout << stats.alloc_count << " allocs " << stats.free_count << " frees ";
+    cout << stats.chunk_bytes << " chunk bytes " << stats.heap_bytes << " heap bytes ";
+    cout << teardown_ms << "ms" << endl;
+
+    require(!use_arena || stats.alloc_count > 0, "arena not used");
+    require(use_arena || stats.alloc_count == 0, "disabled arena used");
+    require(stats.alloc_count == stats.free_count, "world leaked blocks");
+    require(stats.heap_live_bytes == 0, "heap blocks still alive");
+    require(ArenaAllocator::getCurrent() == nullptr, "dangling current arena");
+
+    return teardown_ms;
+}
+
+// a pile of boxes in a closed bin keeps one large awake island, its solver temporaries overflow
+// b2StackAllocator and go through b2Alloc and b2Free on every step
+void
+run_crowded(const int step_count)
+{
+    using std::cout;
+    using std::endl;
+
+    auto arena = std::make_unique<ArenaAllocator>();
+    {
+        b2World world(b2Vec2 { 0, -10 });
+
+        b2BodyDef bin_def;
+        auto bin = world.CreateBody(&bin_def);
+        b2PolygonShape wall;
+        wall.SetAsBox(40, 1, b2Vec2 { 0, -1 }, 0);
+        bin->CreateFixture(&wall, 0);
+        wall.SetAsBox(1, 100, b2Vec2 { -41, 99 }, 0);
+        bin->CreateFixture(&wall, 0);
+        wall.SetAsBox(1, 100, b2Vec2 { 41, 99 }, 0);
+        bin->CreateFixture(&wall, 0);
+
+        b2PolygonShape shape;
+        shape.SetAsBox(.5, .5);
+        for (auto kk=0; kk<2000; kk++)
+        {
+            b2BodyDef def;
+            def.type = b2_dynamicBody;
+            def.allowSleep = false;
+            def.position.Set(-39.5f + 1.1f * (kk % 72), .5f + 1.1f * (kk / 72));
+            world.CreateBody(&def)->CreateFixture(&shape, 1);
+        }
+
+        size_t warm_bytes = 0;
+        for (auto step=0; step<step_count; step++)
+        {
+            world.Step(1 / 60.f, 6, 2, 1);
+            if (step == step_count / 2)
+                warm_bytes = arena->getStats().chunk_bytes;
+        }
+
+        const auto& stats = arena->getStats();
+        cout << "crowded " << step_count << " steps " << warm_bytes << " -> " << stats.chunk_bytes << " chunk bytes ";
+        cout << stats.reuse_count << " reuses" << endl;
+        require(stats.reuse_count > 0, "freed blocks never reused");
+        require(stats.chunk_bytes <= warm_bytes + (1 << 20), "chunk bytes keep growing");
+    }
+    require(arena->getStats().alloc_count == arena->getStats().free_count, "crowded world leaked blocks");
+}
+
+int main(int argc, char* argv[])
+{
+    std::cout << std::boolalpha;
+
+    for (const auto count : { 10, 1000, 10000 })
+    {
+        run_level(false, count);
+        run_level(true, count);
+    }
+
+    run_crowded(600);
+
+    { // blocks allocated under one arena are freed to it while another one is current
+        auto aa = std::make_unique<ArenaAllocator>();
+        auto world = std::make_unique<b2World>(b2Vec2 { 0, -10 });
+        populate(*world, 10);
+        auto bb = std::make_unique<ArenaAllocator>();
+        require(ArenaAllocator::getCurrent() == bb.get(), "invalid current arena");
+        world = nullptr;
+        require(aa->getStats().alloc_count == aa->getStats().free_count, "blocks freed to wrong arena");
+        require(bb->getStats().free_count == 0, "blocks freed to wrong arena");
+        aa = nullptr;
+        require(ArenaAllocator::getCurrent() == bb.get(), "invalid current arena");
+    }
+
+    { // an arena built by a worker task is not left current on the worker once the task scope ends
+        std::unique_ptr<ArenaAllocator> built;
+        std::thread worker([&built]() -> void {
+            {
+                ArenaAllocator::Scope scope;
+                built = std::make_unique<ArenaAllocator>();
+                require(ArenaAllocator::getCurrent() == built.get(), "invalid current arena");
+            }
+            require(ArenaAllocator::getCurrent() == nullptr, "dangling current arena");
+        });
+        worker.join();
+        require(built != nullptr, "arena not built");
+    }
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include "carve_polygons.h"
+#include "merge_polygons.h"
+#include "ground_polygons.h"
+
+#include <iostream>
+#include <cmath>
+#include <stdexcept>
+
+template <typename BB>
+void
+require(const BB cond, const std::string& message)
+{
+    if (!static_cast<bool>(cond))
+        throw std::runtime_error(message);
+}
+
+bool
+is_convex(const b2Vec2* points, const size_t count)
+{
+    for (size_t kk=0; kk<count; kk++)
+        if (b2Cross(points[(kk + 1) % count] - points[kk], points[(kk + 2) % count] - points[(kk + 1) % count]) < -1e-6f)
+            return false;
+    return true;
+}
+
+// pieces are convex, small enough for box2d and cover the expected area
+void
+check_pieces(const std::string& name, const polygons::PolySoup& pieces, const float expected_area)
+{
+    using std::cout;
+    using std::endl;
+
+    float total = 0;
+    for (size_t kk=0; kk<pieces.size(); kk++)
+    {
+        require(pieces.count(kk) <= b2_maxPolygonVertices, name + " piece too large");
+        require(is_convex(pieces.begin(kk), pieces.count(kk)), name + " piece not convex");
+        total += polygons::signed_area(pieces.begin(kk), pieces.count(kk));
+    }
+
+    cout << name << " " << pieces.size() << " pieces area " << total << " expected " << expected_area << endl;
+    require(std::fabs(total - expected_area) < 1e-3f * expected_area, name + " area mismatch");
+}
+
+int main(int argc, char* argv[])
+{
+    using polygons::Poly;
+    using polygons::Segment;
+
+    const Poly square { { -4, -4 }, { 4, -4 }, { 4, 4 }, { -4, 4 } };
+    const auto carve = polygons::circle_polygon({ 0, 0 }, 1, 16);
+    const auto carve_area = polygons::signed_area(carve);
+    require(carve_area > 0 && carve_area < M_PI, "circle polygon area");
+
+    { // hole in the middle
+        const auto pieces = polygons::subtract_convex(square.data(), square.size(), carve.data(), carve.size(), b2_maxPolygonVertices, 1e-4, 1e-6);
+        check_pieces("hole", pieces, 64 - carve_area);
+    }
+
+    { // disjoint piece stays whole
+        const auto far_carve = polygons::circle_polygon({ 10, 10 }, 1, 16);
+        require(polygons::convex_disjoint(square.data(), square.size(), far_carve.data(), far_carve.size()), "far carve overlaps");
+        const auto pieces = polygons::subtract_convex(square.data(), square.size(), far_carve.data(), far_carve.size(), b2_maxPolygonVertices, 1e-4, 1e-6);
+        require(pieces.size() == 1 && pieces.poly(0) == square, "disjoint piece changed");
+    }
+
+    { // covered piece vanishes
+        const Poly small { { -.2f, -.2f }, { .2f, -.2f }, { .2f, .2f }, { -.2f, .2f } };
+        require(polygons::subtract_convex(small.data(), small.size(), carve.data(), carve.size(), b2_maxPolygonVertices, 1e-4, 1e-6).empty(), "covered piece kept");
+    }
+
+    { // thin bar cut in two
+        const Poly bar { { -4, -.1f }, { 4, -.1f }, { 4, .1f }, { -4, .1f } };
+        const auto pieces = polygons::subtract_convex(bar.data(), bar.size(), carve.data(), carve.size(), b2_maxPolygonVertices, 1e-4, 1e-6);
+        float left_area = 0;
+        float right_area = 0;
+        for (size_t kk=0; kk<pieces.size(); kk++)
+            for (auto point=pieces.begin(kk); point!=pieces.end(kk); point++)
+                require(point->x <= -.9f || point->x >= .9f, "bar piece inside carve");
+        for (size_t kk=0; kk<pieces.size(); kk++)
+            (pieces.begin(kk)->x < 0 ? left_area : right_area) += polygons::signed_area(pieces.begin(kk), pieces.count(kk));
+        require(std::fabs(left_area - right_area) < 1e-4f && left_area > 0, "bar halves differ");
+    }
+
+    { // merging the pieces of a corner bite
+        const auto corner_carve = polygons::circle_polygon({ 4, 4 }, 2, 32);
+        const auto pieces = polygons::subtract_convex(square.data(), square.size(), corner_carve.data(), corner_carve.size(), b2_maxPolygonVertices, 1e-4, 1e-6);
+        const auto merged = polygons::merge_convex(pieces, b2_maxPolygonVertices, 1e-6);
+        check_pieces("corner", pieces, 64 - polygons::signed_area(corner_carve) / 4);
+        check_pieces("corner merged", merged, 64 - polygons::signed_area(corner_carve) / 4);
+        require(merged.size() <= pieces.size(), "merging added pieces");
+    }
+
+    { // piece wound like build_ground leaves it, positive area in the svg unit square then flipped to the world
+        polygons::PolySoup soup;
+        soup.push(Poly { { .49f, .24f }, { .51f, .24f }, { .51f, .26f }, { .49f, .26f } });
+        require(polygons::signed_area(soup.begin(0), soup.count(0)) > 0, "svg piece area");
+        polygons::foreground_transform(soup);
+        const auto piece = soup.poly(0);
+        const auto piece_area = polygons::signed_area(piece);
+        require(piece_area > 0, "world piece clockwise");
+        require(!polygons::convex_disjoint(piece.data(), piece.size(), carve.data(), carve.size()), "world piece disjoint");
+        const auto pieces = polygons::subtract_convex(piece.data(), piece.size(), carve.data(), carve.size(), b2_maxPolygonVertices, 1e-4, 1e-6);
+        check_pieces("world", pieces, piece_area - carve_area);
+    }
+
+    { // segments
+        const Segment through { { -2, 0 }, { 2, 0 } };
+        std::vector<Segment> parts;
+        polygons::subtract_segment(through, carve.data(), carve.size(), parts);
+        require(parts.size() == 2, "segment through carve");
+        require(std::fabs(std::get<1>(parts[0]).x + 1) < 1e-5f && std::fabs(std::get<0>(parts[1]).x - 1) < 1e-5f, "segment through carve ends");
+
+        parts.clear();
+        polygons::subtract_segment(Segment { { -.5f, 0 }, { .5f, 0 } }, carve.data(), carve.size(), parts);
+        require(parts.empty(), "segment inside carve");
+
+        parts.clear();
+        polygons::subtract_segment(Segment { { -2, 3 }, { 2, 3 } }, carve.data(), carve.size(), parts);
+        require(parts.size() == 1, "segment outside carve");
+
+        Segment clipped;
+        require(polygons::clip_segment(through, square.data(), square.size(), clipped) && std::get<0>(clipped).x == -2, "segment inside square");
+        require(polygons::clip_segment(Segment { { -8, 0 }, { 8, 0 } }, square.data(), square.size(), clipped), "segment across square");
+        require(std::fabs(std::get<0>(clipped).x + 4) < 1e-5f && std::fabs(std::get<1>(clipped).x - 4) < 1e-5f, "segment across square ends");
+        require(!polygons::clip_segment(Segment { { -8, 5 }, { 8, 5 } }, square.data(), square.size(), clipped), "segment above square");
+    }
+
+    std::cout << "carve ok" << std::endl;
+
+    return 0;
+}
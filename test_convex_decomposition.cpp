@@ -23,18 +23,20 @@ run_acd2d(const polygons::Poly& poly)
     for (const auto& point : poly)
         cout << "  " << point.x << " " << point.y << endl;
 
-    const auto& poly_ = polygons::ensure_cw(poly);
+    auto poly_ = poly;
+    polygons::ensure_cw(poly_.data(), poly_.size());
 
     cout << "NN " << poly_.size() << endl;
     for (const auto& point : poly_)
         cout << "  " << point.x << " " << point.y << endl;
 
-    const auto& subpolys = polygons::decompose(poly_, 1e-3);
-    for (const auto& subpoly : subpolys)
+    const auto subpolys = polygons::decompose(poly_.data(), poly_.size(), 1e-3);
+    require(subpolys.offsets.back() == subpolys.vertices.size(), "soup offsets");
+    for (size_t kk=0; kk<subpolys.size(); kk++)
     {
-        cout << "OO " << subpoly.size() << endl;
-        for (const auto& point : subpoly)
-            cout << "  " << point.x << " " << point.y << endl;
+        cout << "OO " << subpolys.count(kk) << endl;
+        for (auto point=subpolys.begin(kk); point!=subpolys.end(kk); point++)
+            cout << "  " << point->x << " " << point->y << endl;
     }
 }
 
@@ -1,30 +1,32 @@
 #include "extract_polygons.h"
+#include "qsvg_polygons.h"
 #include "decompose_polygons.h"
 
 #include <QApplication>
 
 #include <iostream>
 #include <iomanip>
+#include <chrono>
+#include <cmath>
 
-void dump_poly_to_colors(const polygons::PolyToColors& poly_to_pen_colors)
+void dump_soup(const polygons::PolySoup& soup)
 {
     using std::cout;
     using std::endl;
 
-    const auto hasher = poly_to_pen_colors.hash_function();
-    for (const auto& pair : poly_to_pen_colors)
+    const polygons::PolyHasher hasher;
+    for (size_t kk=0; kk<soup.size(); kk++)
     {
-        const auto& poly = pair.first;
-        const auto& color = pair.second;
-        const auto& hash = hasher(poly);
+        const auto& color = soup.colors[kk];
+        const auto& hash = hasher(soup.begin(kk), soup.count(kk));
         cout
             << "  poly "
             << std::setw(16) << std::setfill('0') << std::hex << hash << std::dec << " "
             << "(" << color.x << "|" << color.y << "|" << color.z << "|" << color.w << ") "
-            << poly.size() << endl;
+            << soup.count(kk) << endl;
 
-        for (const auto& point : poly)
-            cout << "    " << point.x << " " << point.y << endl;
+        for (auto point=soup.begin(kk); point!=soup.end(kk); point++)
+            cout << "    " << point->x << " " << point->y << endl;
 
         /*
         cout << "=================" << endl;
@@ -43,28 +45,29 @@ check_non_null_decomposition(const std::string& map)
     using std::endl;
     using std::get;
 
-    const auto polys = polygons::extract(map);
+    const auto polys = polygons::extract(map, 1e-4);
 
     cout << "==================== " << std::quoted(map) << endl;
-    cout << "poly_to_pen_colors " << get<0>(polys).size() << endl;
-    dump_poly_to_colors(get<0>(polys));
+    cout << "pen_polys " << get<0>(polys).size() << endl;
+    dump_soup(get<0>(polys));
 
-    cout << "poly_to_brush_colors " << get<1>(polys).size() << endl;
-    dump_poly_to_colors(get<1>(polys));
+    cout << "brush_polys " << get<1>(polys).size() << endl;
+    dump_soup(get<1>(polys));
 
-    for (const auto& poly_color : get<1>(polys))
+    const auto& brush_polys = get<1>(polys);
+    for (size_t kk=0; kk<brush_polys.size(); kk++)
     {
-        if (!polygons::isForeground(poly_color.second))
+        if (!polygons::isForeground(brush_polys.colors[kk]))
             continue;
 
-        const auto subpolys = polygons::decompose(polygons::ensure_cw(poly_color.first), 1e-2);
-        cout << "decomp " << poly_color.first.size() << " " << subpolys.size() << " ";
-        size_t accum = 0;
+        auto poly = brush_polys.poly(kk);
+        polygons::ensure_cw(poly.data(), poly.size());
+        const auto subpolys = polygons::decompose(poly.data(), poly.size(), 1e-2);
+        cout << "decomp " << poly.size() << " " << subpolys.size() << " ";
         bool first = true;
-        for (const auto& subpoly : subpolys)
+        for (size_t ll=0; ll<subpolys.size(); ll++)
         {
-            accum += subpoly.size();
-            cout << (first ? "[" : ", ") << subpoly.size();
+            cout << (first ? "[" : ", ") << subpolys.count(ll);
             first = false;
         }
         cout << "]" << endl;
@@ -74,6 +77,99 @@ check_non_null_decomposition(const std::string& map)
     }
 }
 
+
+void
+check_adaptive_flattening(const std::string& map)
+{
+    using std::cout;
+    using std::endl;
+    using std::get;
+
+    const auto fine = polygons::extract(map, 1e-5);
+    const auto coarse = polygons::extract(map, 1e-3);
+    const auto fine_count = get<1>(fine).vertices.size();
+    const auto coarse_count = get<1>(coarse).vertices.size();
+
+    cout << "flattening " << std::quoted(map) << " " << fine_count << " " << coarse_count << endl;
+    if (get<1>(fine).size() != get<1>(coarse).size() || coarse_count > fine_count)
+        std::exit(1);
+}
+
+// every foreground, water and crate polygon from QSvgRenderer has a native counterpart with the same colour and extent
+void
+check_native_matches_qsvg(const std::string& map)
+{
+    using std::cout;
+    using std::endl;
+    using std::get;
+
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    const float tolerance = 1e-4;
+    const auto qsvg_start = Clock::now();
+    const auto reference = polygons::extract_qsvg(map, tolerance);
+    const auto qsvg_ms = Milliseconds(Clock::now() - qsvg_start).count();
+    const auto native_start = Clock::now();
+    const auto native = polygons::extract(map, tolerance);
+    const auto native_ms = Milliseconds(Clock::now() - native_start).count();
+
+    const auto is_used = [](const polygons::Color& color) -> bool
+    {
+        return polygons::isForeground(color) || polygons::isWater(color) || polygons::isCrate(color);
+    };
+    const auto extent = [](const polygons::PolySoup& soup, const size_t kk) -> std::tuple<b2Vec2, b2Vec2>
+    {
+        b2Vec2 lower = *soup.begin(kk);
+        b2Vec2 upper = *soup.begin(kk);
+        for (auto point=soup.begin(kk); point!=soup.end(kk); point++)
+        {
+            lower = b2Min(lower, *point);
+            upper = b2Max(upper, *point);
+        }
+        return std::make_tuple(lower, upper);
+    };
+
+    const auto& reference_polys = get<1>(reference);
+    const auto& native_polys = get<1>(native);
+    size_t used_count = 0;
+    for (size_t kk=0; kk<reference_polys.size(); kk++)
+    {
+        const auto& color = reference_polys.colors[kk];
+        if (!is_used(color))
+            continue;
+        used_count++;
+
+        const auto reference_extent = extent(reference_polys, kk);
+        bool found = false;
+        for (size_t ll=0; ll<native_polys.size(); ll++)
+        {
+            const auto& color_ = native_polys.colors[ll];
+            if (color_.x != color.x || color_.y != color.y || color_.z != color.z)
+                continue;
+            const auto native_extent = extent(native_polys, ll);
+            found |= (get<0>(native_extent) - get<0>(reference_extent)).Length() < 10 * tolerance &&
+                (get<1>(native_extent) - get<1>(reference_extent)).Length() < 10 * tolerance;
+        }
+
+        if (!found)
+        {
+            cout << "no native match " << std::quoted(map) << " " << reference_polys.count(kk) << endl;
+            std::exit(1);
+        }
+    }
+
+    size_t native_used_count = 0;
+    for (const auto& color : native_polys.colors)
+        if (is_used(color))
+            native_used_count++;
+
+    cout << "native " << std::quoted(map) << " " << used_count << " " << native_used_count << " polygons ";
+    cout << qsvg_ms << "ms qsvg " << native_ms << "ms native" << endl;
+    if (used_count != native_used_count)
+        std::exit(1);
+}
+
 int main(int argc, char* argv[])
 {
     using std::cout;
@@ -87,6 +183,10 @@ int main(int argc, char* argv[])
     check_non_null_decomposition(":/levels/map4.svg");
     check_non_null_decomposition(":/levels/map5.svg");
     check_non_null_decomposition(":/levels/map6.svg");
+    check_adaptive_flattening(":/levels/map1.svg");
+    check_adaptive_flattening(":/levels/map6.svg");
+    for (const auto& map : { ":/levels/map1.svg", ":/levels/map2.svg", ":/levels/map3.svg", ":/levels/map4.svg", ":/levels/map5.svg", ":/levels/map6.svg", ":/levels/map7.svg", ":/levels/map8.svg" })
+        check_native_matches_qsvg(map);
 
     return 0;
 }
@@ -0,0 +1,124 @@
+#include "level_pack.h"
+
+#include <QCoreApplication>
+
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+
+template <typename BB>
+void
+require(const BB cond, const std::string& message)
+{
+    if (!static_cast<bool>(cond))
+        throw std::runtime_error(message);
+}
+
+int main(int argc, char* argv[])
+{
+    using std::cout;
+    using std::endl;
+    using std::get;
+
+    QCoreApplication app(argc, argv);
+
+    levels::MainData data;
+    data.default_level = 1;
+    std::vector<polygons::Ground> grounds;
+
+    for (auto kk=0; kk<2; kk++)
+    {
+        levels::LevelData level;
+        level.name = "level" + std::to_string(kk);
+        level.map_filename = ":/levels/map" + std::to_string(kk) + ".svg";
+        level.doors.emplace_back(levels::LevelData::DoorData { { 1, 2 }, { 3, 4 }, { 5, 6 } });
+        level.paths.emplace_back(levels::LevelData::PathData { { { 0, 0 }, { 10, 10 } }, { 1, 10 } });
+        level.world_camera_position = { 0, -120 };
+        level.world_screen_height = 500;
+        level.ship_screen_height = 70;
+        level.ship_spawn = { static_cast<float>(kk), 7 };
+        level.has_world_bounds = kk == 1;
+        level.chunk_size = kk * 64;
+        level.ground_options.simplify_tolerance = kk * .5f;
+        data.levels.emplace_back(level);
+
+        polygons::Ground ground;
+        ground.pieces.push(polygons::Poly { { 0, 0 }, { 1, 0 }, { 0, 1 } });
+        ground.pieces.push(polygons::Poly { { 0, 0 }, { 2, 0 }, { 2, 2 }, { 0, 2 } });
+        ground.outlines.push(polygons::Poly { { 0, 0 }, { 2, 0 }, { 2, 2 } });
+        ground.water_regions.emplace_back();
+        ground.water_regions.back().push(ground.pieces.poly(0), { 0, 1, 1, 1 });
+        ground.lower = { -300, -450 };
+        ground.upper = { 300, 150 };
+        ground.use_chains = kk == 1;
+        grounds.emplace_back(ground);
+    }
+
+    const std::string filename = "test_level_pack.pack";
+    {
+        std::ofstream handle(filename, std::ios::binary);
+        levels::write_pack(handle, data, grounds, 42);
+    }
+
+    levels::PackFile pack;
+    require(!pack.open(filename, 43), "stale pack accepted");
+    require(!pack.isOpen(), "stale pack left open");
+    require(pack.open(filename, 42), "can't open pack");
+
+    const auto& data_ = pack.getData();
+    require(data_.default_level == 1, "default level mismatch");
+    require(data_.levels.size() == 2, "level count mismatch");
+    for (auto kk=0; kk<2; kk++)
+    {
+        const auto& level = data.levels[kk];
+        const auto& level_ = data_.levels[kk];
+        require(level_.name == level.name, "name mismatch");
+        require(level_.map_filename == level.map_filename, "map mismatch");
+        require(level_.doors.size() == 1 && get<2>(level_.doors.front()) == b2Vec2 { 5, 6 }, "door mismatch");
+        require(level_.paths.size() == 1 && get<0>(level_.paths.front()).size() == 2, "path mismatch");
+        require(level_.ship_spawn == level.ship_spawn, "spawn mismatch");
+        require(level_.has_world_bounds == level.has_world_bounds, "bounds mismatch");
+        require(level_.chunk_size == level.chunk_size, "chunk size mismatch");
+        require(level_.ground_options.simplify_tolerance == level.ground_options.simplify_tolerance, "ground options mismatch");
+
+        polygons::Ground ground;
+        require(pack.readGround(kk, ground), "ground not read");
+        require(ground.pieces == grounds[kk].pieces, "pieces mismatch");
+        require(ground.pieces.size() == 2 && ground.pieces.count(1) == 4, "soup layout mismatch");
+        require(ground.outlines == grounds[kk].outlines, "outlines mismatch");
+        require(ground.use_chains == grounds[kk].use_chains, "chains mismatch");
+        require(ground.water_regions == grounds[kk].water_regions, "water regions mismatch");
+        require(ground.crate_regions.empty(), "crate regions mismatch");
+        require(ground.upper == grounds[kk].upper, "extent mismatch");
+    }
+    {
+        polygons::Ground ground;
+        require(!pack.readGround(2, ground), "missing ground read");
+    }
+    pack.close();
+
+    { // offsets past the vertices, the table is intact so only the ground check catches it
+        auto grounds_ = grounds;
+        grounds_[1].pieces.offsets.back() += 5;
+        std::ofstream handle(filename, std::ios::binary);
+        levels::write_pack(handle, data, grounds_, 42);
+    }
+    require(!pack.open(filename, 42), "corrupt ground accepted");
+    require(!pack.isOpen(), "corrupt pack left open");
+
+    { // truncated copy
+        {
+            std::ofstream handle(filename, std::ios::binary);
+            levels::write_pack(handle, data, grounds, 42);
+        }
+        std::ifstream handle(filename, std::ios::binary);
+        const std::string bytes((std::istreambuf_iterator<char>(handle)), std::istreambuf_iterator<char>());
+        std::ofstream truncated(filename, std::ios::binary);
+        truncated.write(bytes.data(), bytes.size() - 9);
+    }
+    require(!pack.open(filename, 42), "truncated pack accepted");
+
+    cout << "pack round trip ok" << endl;
+
+    return 0;
+}
@@ -39,7 +39,8 @@ int main(int argc, char* argv[])
         cout << std::quoted(level.name) << " ";
         cout << std::quoted(level.map_filename) << " " << map_exists << " ";
         cout << level.doors.size() << "doors ";
-        cout << level.paths.size() << "paths" << endl;
+        cout << level.paths.size() << "paths ";
+        cout << level.emitters.size() << "emitters" << endl;
 
         require(map_exists, "map does not exists");
 
@@ -0,0 +1,118 @@
+#include "merge_polygons.h"
+
+#include <iostream>
+#include <cmath>
+#include <stdexcept>
+
+template <typename BB>
+void
+require(const BB cond, const std::string& message)
+{
+    if (!static_cast<bool>(cond))
+        throw std::runtime_error(message);
+}
+
+float
+total_area(const polygons::PolySoup& pieces)
+{
+    float area = 0;
+    for (size_t kk=0; kk<pieces.size(); kk++)
+        area += polygons::signed_area(pieces.begin(kk), pieces.count(kk));
+    return area;
+}
+
+polygons::PolySoup
+to_soup(const std::vector<polygons::Poly>& polys)
+{
+    polygons::PolySoup soup;
+    for (const auto& poly : polys)
+        soup.push(poly);
+    return soup;
+}
+
+int main(int argc, char* argv[])
+{
+    using std::cout;
+    using std::endl;
+    using polygons::Poly;
+
+    { // square split into two triangles
+        const auto pieces = to_soup({
+            { { 0, 0 }, { 1, 0 }, { 1, 1 } },
+            { { 0, 0 }, { 1, 1 }, { 0, 1 } },
+        });
+        const auto merged = polygons::merge_convex(pieces, 8, 0);
+        cout << "square " << pieces.size() << " -> " << merged.size() << endl;
+        require(merged.size() == 1 && merged.count(0) == 4, "square not merged");
+        require(std::fabs(total_area(merged) - 1) < 1e-6, "square area changed");
+    }
+
+    { // clockwise strip of unit squares, collinear vertices vanish and everything merges
+        polygons::PolySoup pieces;
+        for (auto kk=0; kk<20; kk++)
+        {
+            const float xx = kk;
+            pieces.push(Poly { { xx, 0 }, { xx, 1 }, { xx + 1, 1 }, { xx + 1, 0 } });
+        }
+        const auto merged = polygons::merge_convex(pieces, 8, 0);
+        cout << "strip " << pieces.size() << " -> " << merged.size() << endl;
+        require(merged.size() == 1 && merged.count(0) == 4, "strip not merged");
+        require(std::fabs(total_area(merged) + 20) < 1e-4, "strip area changed");
+    }
+
+    { // l shape, union is concave and must stay split
+        const auto pieces = to_soup({
+            { { 0, 0 }, { 2, 0 }, { 2, 1 }, { 0, 1 } },
+            { { 0, 1 }, { 1, 1 }, { 1, 2 }, { 0, 2 } },
+        });
+        const auto merged = polygons::merge_convex(pieces, 8, 0);
+        cout << "l shape " << pieces.size() << " -> " << merged.size() << endl;
+        require(merged.size() == 2, "concave union merged");
+    }
+
+    { // triangle fan of a disc, vertex limit bounds every piece
+        polygons::PolySoup pieces;
+        const int count = 32;
+        for (auto kk=0; kk<count; kk++)
+        {
+            const float aa = 2 * static_cast<float>(M_PI) * kk / count;
+            const float bb = 2 * static_cast<float>(M_PI) * (kk + 1) / count;
+            pieces.push(Poly { { 0, 0 }, { std::cos(aa), std::sin(aa) }, { std::cos(bb), std::sin(bb) } });
+        }
+        const auto merged = polygons::merge_convex(pieces, 8, 0);
+        cout << "disc " << pieces.size() << " -> " << merged.size() << endl;
+        require(merged.size() < pieces.size() / 4, "disc not merged");
+        for (size_t kk=0; kk<merged.size(); kk++)
+            require(merged.count(kk) <= 8, "vertex limit exceeded");
+        require(std::fabs(total_area(merged) - total_area(pieces)) < 1e-4, "disc area changed");
+    }
+
+    { // large disc is fanned into pieces within the vertex limit
+        Poly disc;
+        const int count = 40;
+        for (auto kk=0; kk<count; kk++)
+        {
+            const float angle = 2 * static_cast<float>(M_PI) * kk / count;
+            disc.emplace_back(b2Vec2 { std::cos(angle), std::sin(angle) });
+        }
+        const auto pieces = to_soup({ disc, { { 2, 0 }, { 3, 0 }, { 3, 1 } } });
+        const auto split = polygons::split_convex(pieces, 8);
+        cout << "split " << pieces.size() << " -> " << split.size() << endl;
+        for (size_t kk=0; kk<split.size(); kk++)
+            require(split.count(kk) <= 8 && polygons::signed_area(split.begin(kk), split.count(kk)) > 0, "split piece invalid");
+        require(split.size() == 8 && split.poly(7) == pieces.poly(1), "split piece count");
+        require(std::fabs(total_area(split) - total_area(pieces)) < 1e-4, "split area changed");
+    }
+
+    { // isolated sliver is dropped
+        const auto pieces = to_soup({
+            { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } },
+            { { 5, 0 }, { 6, 0 }, { 5, 1e-4 } },
+        });
+        const auto merged = polygons::merge_convex(pieces, 8, 1e-3);
+        cout << "sliver " << pieces.size() << " -> " << merged.size() << endl;
+        require(merged.size() == 1, "sliver kept");
+    }
+
+    return 0;
+}
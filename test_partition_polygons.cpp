@@ -0,0 +1,121 @@
+#include "partition_polygons.h"
+
+#include <iostream>
+#include <cmath>
+#include <stdexcept>
+
+template <typename BB>
+void
+require(const BB cond, const std::string& message)
+{
+    if (!static_cast<bool>(cond))
+        throw std::runtime_error(message);
+}
+
+float
+area(const b2Vec2* points, const size_t count)
+{
+    float area = 0;
+    for (size_t kk=0; kk<count; kk++)
+        area += b2Cross(points[kk], points[(kk + 1) % count]);
+    return area / 2;
+}
+
+// pieces cover the polygon area, keep its orientation and are convex
+void
+check_pieces(const std::string& name, const polygons::Poly& poly, const polygons::PolySoup& pieces)
+{
+    using std::cout;
+    using std::endl;
+
+    float total = 0;
+    float max_concavity = 0;
+    for (size_t kk=0; kk<pieces.size(); kk++)
+    {
+        require(pieces.count(kk) <= b2_maxPolygonVertices, name + " piece too large");
+        const auto piece_area = area(pieces.begin(kk), pieces.count(kk));
+        require(piece_area > 0, name + " piece flipped");
+        total += piece_area;
+        max_concavity = std::fmax(max_concavity, polygons::concavity(pieces.begin(kk), pieces.count(kk)));
+    }
+
+    const auto poly_area = area(poly.data(), poly.size());
+    cout << name << " " << poly.size() << " vertices " << pieces.size() << " pieces concavity " << max_concavity << endl;
+    require(std::fabs(total - poly_area) < 1e-4 * poly_area, name + " area changed");
+    require(max_concavity < 1e-5, name + " piece not convex");
+}
+
+int main(int argc, char* argv[])
+{
+    using polygons::Poly;
+
+    { // convex input stays whole
+        const Poly poly { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+        require(polygons::concavity(poly.data(), poly.size()) == 0, "square concave");
+        const auto ear_pieces = polygons::decompose_ear_clipping(poly.data(), poly.size());
+        const auto bayazit_pieces = polygons::decompose_bayazit(poly.data(), poly.size());
+        check_pieces("square ear clipping", poly, ear_pieces);
+        check_pieces("square bayazit", poly, bayazit_pieces);
+        require(ear_pieces.size() == 1 && bayazit_pieces.size() == 1, "square split");
+    }
+
+    { // l shape needs exactly two pieces
+        const Poly poly { { 0, 0 }, { 2, 0 }, { 2, 1 }, { 1, 1 }, { 1, 2 }, { 0, 2 } };
+        require(std::fabs(polygons::concavity(poly.data(), poly.size()) - std::sqrt(.5f)) < 1e-5, "l shape concavity");
+        const auto ear_pieces = polygons::decompose_ear_clipping(poly.data(), poly.size());
+        const auto bayazit_pieces = polygons::decompose_bayazit(poly.data(), poly.size());
+        check_pieces("l shape ear clipping", poly, ear_pieces);
+        check_pieces("l shape bayazit", poly, bayazit_pieces);
+        require(ear_pieces.size() == 2 && bayazit_pieces.size() == 2, "l shape piece count");
+    }
+
+    { // star with many reflex vertices
+        Poly poly;
+        const int count = 96;
+        for (auto kk=0; kk<count; kk++)
+        {
+            const float angle = 2 * static_cast<float>(M_PI) * kk / count;
+            const float radius = kk % 2 ? .4f : 1.f + .2f * std::sin(5.f * angle);
+            poly.emplace_back(b2Vec2 { radius * std::cos(angle), radius * std::sin(angle) });
+        }
+        const auto ear_pieces = polygons::decompose_ear_clipping(poly.data(), poly.size());
+        const auto bayazit_pieces = polygons::decompose_bayazit(poly.data(), poly.size());
+        check_pieces("star ear clipping", poly, ear_pieces);
+        check_pieces("star bayazit", poly, bayazit_pieces);
+        // hertel-mehlhorn keeps at most two diagonals per reflex vertex, far fewer than the triangulation,
+        // one piece per spike and the center fanned under the vertex limit
+        const auto max_count = count / 2 + count / 2 / (b2_maxPolygonVertices - 2) + 4;
+        require(ear_pieces.size() < max_count && bayazit_pieces.size() < max_count, "star over split");
+    }
+
+    { // convex 40-gon with one notch, merged pieces stay within the vertex limit
+        Poly poly;
+        const int count = 40;
+        for (auto kk=0; kk<count; kk++)
+        {
+            const float angle = 2 * static_cast<float>(M_PI) * kk / count;
+            const float radius = kk ? 1.f : .5f;
+            poly.emplace_back(b2Vec2 { radius * std::cos(angle), radius * std::sin(angle) });
+        }
+        check_pieces("notched disc ear clipping", poly, polygons::decompose_ear_clipping(poly.data(), poly.size()));
+        check_pieces("notched disc bayazit", poly, polygons::decompose_bayazit(poly.data(), poly.size()));
+    }
+
+    { // comb, long reflex runs
+        Poly poly { { 0, 0 }, { 20, 0 } };
+        for (auto kk=9; kk>=0; kk--)
+        {
+            const float xx = 2 * kk;
+            poly.emplace_back(b2Vec2 { xx + 2, 5 });
+            poly.emplace_back(b2Vec2 { xx + 1, 5 });
+            poly.emplace_back(b2Vec2 { xx + 1, 1 });
+            poly.emplace_back(b2Vec2 { xx, 1 });
+        }
+        check_pieces("comb ear clipping", poly, polygons::decompose_ear_clipping(poly.data(), poly.size()));
+        check_pieces("comb bayazit", poly, polygons::decompose_bayazit(poly.data(), poly.size()));
+    }
+
+    std::cout << "partition ok" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "sensors.h"
+
+#include <iostream>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+
+template <typename BB>
+void
+require(const BB cond, const std::string& message)
+{
+    if (!static_cast<bool>(cond))
+        throw std::runtime_error(message);
+}
+
+int main(int argc, char* argv[])
+{
+    using std::cout;
+    using std::endl;
+    using sensors::Segment;
+
+    b2AABB bounds;
+    bounds.lowerBound = { -20, -20 };
+    bounds.upperBound = { 20, 20 };
+
+    // closed square of half size 10 around the origin
+    const std::vector<Segment> segments {
+        Segment { { -10, -10 }, { 10, -10 } },
+        Segment { { 10, -10 }, { 10, 10 } },
+        Segment { { 10, 10 }, { -10, 10 } },
+        Segment { { -10, 10 }, { -10, -10 } },
+    };
+    const auto segment_grid = sensors::build_segment_grid(segments, bounds, 3);
+    require(!segment_grid.isEmpty(), "empty segment grid");
+
+    const std::vector<b2Vec2> centers { { 5, 0 }, { 0, 5 } };
+    const float radius = 1;
+    const auto circle_grid = sensors::build_circle_grid(centers.data(), centers.size(), radius, bounds, 2);
+
+    const auto cast_segments = [&segments, &segment_grid](const b2Vec2& origin, const b2Vec2& direction, const float max_length) -> float
+    {
+        return segment_grid.traverse(origin, direction, max_length, [&segments, &origin, &direction](const uint32_t item, const float best) -> float {
+            return sensors::raycast_segment(segments[item], origin, direction, best);
+        });
+    };
+    const auto cast_circles = [&centers, &radius, &circle_grid](const b2Vec2& origin, const b2Vec2& direction, const float max_length) -> float
+    {
+        return circle_grid.traverse(origin, direction, max_length, [&centers, &radius, &origin, &direction](const uint32_t item, const float best) -> float {
+            return sensors::raycast_circle(centers[item], radius, origin, direction, best);
+        });
+    };
+
+    { // axis aligned rays
+        require(std::fabs(cast_segments({ 0, 0 }, { 1, 0 }, 100) - 10) < 1e-4, "segment +x");
+        require(std::fabs(cast_segments({ 0, 0 }, { -1, 0 }, 100) - 10) < 1e-4, "segment -x");
+        require(std::fabs(cast_segments({ 0, 0 }, { 0, 1 }, 100) - 10) < 1e-4, "segment +y");
+        require(std::fabs(cast_segments({ 2, 3 }, { 0, -1 }, 100) - 13) < 1e-4, "segment -y");
+        require(cast_segments({ 0, 0 }, { 1, 0 }, 5) == 5, "segment out of reach");
+        require(std::fabs(cast_segments({ -30, 0 }, { 1, 0 }, 100) - 20) < 1e-4, "segment from outside the grid");
+        require(std::fabs(cast_circles({ 0, 0 }, { 1, 0 }, 100) - 4) < 1e-4, "circle +x");
+        require(cast_circles({ 5, 0 }, { 1, 0 }, 100) == 100, "circle from inside");
+        require(cast_circles({ 0, 0 }, { -1, 0 }, 100) == 100, "circle miss");
+    }
+
+    { // box queries
+        std::vector<uint32_t> visited;
+        b2AABB aabb;
+        aabb.lowerBound = { 8, -1 };
+        aabb.upperBound = { 12, 1 };
+        segment_grid.query(aabb, [&visited](const uint32_t item) -> void { visited.emplace_back(item); });
+        require(!visited.empty() && std::all_of(std::begin(visited), std::end(visited), [](const uint32_t item) -> bool { return item == 1; }), "query right side");
+        visited.clear();
+        aabb.lowerBound = { -1, -1 };
+        aabb.upperBound = { 1, 1 };
+        segment_grid.query(aabb, [&visited](const uint32_t item) -> void { visited.emplace_back(item); });
+        require(visited.empty(), "query inside");
+    }
+
+    { // random rays against brute force, in parallel
+        std::default_random_engine rng;
+        std::uniform_real_distribution<float> dist_position(-9, 9);
+        std::uniform_real_distribution<float> dist_angle(0, 2 * M_PI);
+
+        sensors::Rays rays;
+        for (auto kk=0; kk<10000; kk++)
+        {
+            const auto angle = dist_angle(rng);
+            rays.emplace_back({ dist_position(rng), dist_position(rng) }, { std::cos(angle), std::sin(angle) }, 50);
+        }
+
+        sensors::Hits hits;
+        hits.reset(rays);
+        require(hits.size() == rays.size(), "hits size");
+
+        sensors::parallel_for(rays.size(), 4, [&](const size_t begin, const size_t end) -> void {
+            for (auto kk=begin; kk<end; kk++)
+                hits.distances[kk] = cast_segments(rays.origins[kk], rays.directions[kk], rays.max_lengths[kk]);
+        });
+
+        size_t mismatch_count = 0;
+        for (size_t kk=0; kk<rays.size(); kk++)
+        {
+            float best = rays.max_lengths[kk];
+            for (const auto& segment : segments)
+                best = sensors::raycast_segment(segment, rays.origins[kk], rays.directions[kk], best);
+            if (std::fabs(best - hits.distances[kk]) > 1e-3)
+                mismatch_count++;
+        }
+
+        cout << rays.size() << " rays " << mismatch_count << " mismatches" << endl;
+        require(mismatch_count == 0, "grid traversal differs from brute force");
+    }
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+#include "simplify_polygons.h"
+
+#include <iostream>
+#include <cmath>
+#include <stdexcept>
+
+template <typename BB>
+void
+require(const BB cond, const std::string& message)
+{
+    if (!static_cast<bool>(cond))
+        throw std::runtime_error(message);
+}
+
+bool
+has_crossing(const polygons::Poly& poly)
+{
+    const auto count = poly.size();
+    for (size_t ii=0; ii<count; ii++)
+        for (size_t jj=ii + 2; jj<count; jj++)
+        {
+            if (ii == 0 && jj + 1 == count)
+                continue;
+            const auto& aa = poly[ii];
+            const auto& bb = poly[(ii + 1) % count];
+            const auto& cc = poly[jj];
+            const auto& dd = poly[(jj + 1) % count];
+            const auto d1 = b2Cross(dd - cc, aa - cc);
+            const auto d2 = b2Cross(dd - cc, bb - cc);
+            const auto d3 = b2Cross(bb - aa, cc - aa);
+            const auto d4 = b2Cross(bb - aa, dd - aa);
+            if (d1 * d2 < 0 && d3 * d4 < 0)
+                return true;
+        }
+    return false;
+}
+
+int main(int argc, char* argv[])
+{
+    using std::cout;
+    using std::endl;
+    using polygons::Poly;
+
+    { // collinear points on a square
+        Poly poly;
+        for (auto kk=0; kk<10; kk++) poly.emplace_back(b2Vec2 { kk / 10.f, 0 });
+        for (auto kk=0; kk<10; kk++) poly.emplace_back(b2Vec2 { 1, kk / 10.f });
+        for (auto kk=0; kk<10; kk++) poly.emplace_back(b2Vec2 { 1 - kk / 10.f, 1 });
+        for (auto kk=0; kk<10; kk++) poly.emplace_back(b2Vec2 { 0, 1 - kk / 10.f });
+        const auto poly_ = polygons::simplify(poly, 1e-3);
+        cout << "square " << poly.size() << " -> " << poly_.size() << endl;
+        require(poly_.size() == 4, "square not reduced to its corners");
+        require(polygons::simplify(poly, 0) == poly, "zero tolerance changed the polygon");
+    }
+
+    { // circle, every dropped vertex stays within tolerance
+        Poly poly;
+        for (auto kk=0; kk<360; kk++)
+            poly.emplace_back(b2Vec2 { std::cos(kk * static_cast<float>(M_PI) / 180), std::sin(kk * static_cast<float>(M_PI) / 180) });
+        const float tolerance = 1e-2;
+        const auto poly_ = polygons::simplify(poly, tolerance);
+        cout << "circle " << poly.size() << " -> " << poly_.size() << endl;
+        require(poly_.size() < poly.size() / 4, "circle not simplified");
+        require(poly_.size() > 8, "circle over simplified");
+        require(!has_crossing(poly_), "circle self crossing");
+    }
+
+    { // thin comb whose teeth collapse onto each other without topology checks
+        Poly poly;
+        const int teeth = 20;
+        for (auto kk=0; kk<teeth; kk++)
+        {
+            const float xx = kk;
+            poly.emplace_back(b2Vec2 { xx, 0 });
+            poly.emplace_back(b2Vec2 { xx + .05f, 10 });
+            poly.emplace_back(b2Vec2 { xx + .5f, 10.02f });
+            poly.emplace_back(b2Vec2 { xx + .55f, 0 });
+        }
+        poly.emplace_back(b2Vec2 { teeth, -1 });
+        poly.emplace_back(b2Vec2 { 0, -1 });
+        const auto poly_ = polygons::simplify(poly, .6);
+        cout << "comb " << poly.size() << " -> " << poly_.size() << endl;
+        require(!has_crossing(poly_), "comb self crossing");
+    }
+
+    { // long comb, crossings are restored all along the outline
+        Poly poly;
+        const int teeth = 2000;
+        for (auto kk=0; kk<teeth; kk++)
+        {
+            const float xx = kk;
+            poly.emplace_back(b2Vec2 { xx, 0 });
+            poly.emplace_back(b2Vec2 { xx + .05f, 10 });
+            poly.emplace_back(b2Vec2 { xx + .5f, 10.02f });
+            poly.emplace_back(b2Vec2 { xx + .55f, 0 });
+        }
+        poly.emplace_back(b2Vec2 { teeth, -1 });
+        poly.emplace_back(b2Vec2 { 0, -1 });
+        const auto poly_ = polygons::simplify(poly, .6);
+        cout << "long comb " << poly.size() << " -> " << poly_.size() << endl;
+        require(!has_crossing(poly_), "long comb self crossing");
+    }
+
+    { // figure eight, the input crossing stays and simplification still ends
+        Poly poly;
+        for (auto kk=0; kk<200; kk++)
+        {
+            const auto angle = 2 * static_cast<float>(M_PI) * kk / 200;
+            poly.emplace_back(b2Vec2 { std::sin(angle), std::sin(angle) * std::cos(angle) });
+        }
+        const auto poly_ = polygons::simplify(poly, 1e-2);
+        cout << "figure eight " << poly.size() << " -> " << poly_.size() << endl;
+        require(poly_.size() >= 4 && poly_.size() < poly.size(), "figure eight not simplified");
+    }
+
+    { // two squares joined into one outline like a compound path, the joining edges cross the second square
+        Poly poly;
+        for (auto kk=0; kk<10; kk++) poly.emplace_back(b2Vec2 { kk / 10.f, 0 });
+        for (auto kk=0; kk<10; kk++) poly.emplace_back(b2Vec2 { 1, kk / 10.f });
+        for (auto kk=0; kk<10; kk++) poly.emplace_back(b2Vec2 { 1 - kk / 10.f, 1 });
+        for (auto kk=0; kk<10; kk++) poly.emplace_back(b2Vec2 { 0, 1 - kk / 10.f });
+        for (auto kk=0; kk<10; kk++) poly.emplace_back(b2Vec2 { .5f + kk / 10.f, .5f });
+        for (auto kk=0; kk<10; kk++) poly.emplace_back(b2Vec2 { 1.5f, .5f + kk / 10.f });
+        for (auto kk=0; kk<10; kk++) poly.emplace_back(b2Vec2 { 1.5f - kk / 10.f, 1.5f });
+        for (auto kk=0; kk<10; kk++) poly.emplace_back(b2Vec2 { .5f, 1.5f - kk / 10.f });
+        const auto poly_ = polygons::simplify(poly, 1e-3);
+        cout << "compound " << poly.size() << " -> " << poly_.size() << endl;
+        require(poly_.size() >= 3 && poly_.size() <= poly.size(), "compound result invalid");
+    }
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "svg_polygons.h"
+
+#include <iostream>
+#include <cmath>
+#include <stdexcept>
+
+template <typename BB>
+void
+require(const BB cond, const std::string& message)
+{
+    if (!static_cast<bool>(cond))
+        throw std::runtime_error(message);
+}
+
+bool
+close_to(const b2Vec2& aa, const b2Vec2& bb)
+{
+    return (aa - bb).Length() < 1e-5;
+}
+
+std::string
+document(const std::string& body)
+{
+    return
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n"
+        "<!-- test -->\n"
+        "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"800\" height=\"800\" viewBox=\"0 0 200 100\">\n"
+        "<metadata><rdf:RDF><dc:title>ignored</dc:title></rdf:RDF></metadata>\n" +
+        body +
+        "</svg>\n";
+}
+
+int main(int argc, char* argv[])
+{
+    using std::cout;
+    using std::endl;
+    using std::get;
+    using polygons::Poly;
+
+    { // viewbox onto the unit square, rect corners
+        const auto polys = polygons::parse_svg(document("<rect x=\"20\" y=\"10\" width=\"40\" height=\"30\" style=\"fill:#000000\"/>"), 1e-4);
+        require(get<0>(polys).empty(), "unexpected pen polygon");
+        require(get<1>(polys).size() == 1, "rect missing");
+        const auto poly = get<1>(polys).poly(0);
+        require(polygons::isForeground(get<1>(polys).colors[0]), "rect not foreground");
+        require(poly.size() == 4, "rect vertex count");
+        require(close_to(poly[0], { .1, .1 }) && close_to(poly[2], { .3, .4 }), "rect corners");
+    }
+
+    { // nested transforms, relative commands, implicit lines and style overriding attributes
+        const auto polys = polygons::parse_svg(document(
+            "<g transform=\"translate(100,0)\">"
+            "<g transform=\"scale(2)\">"
+            "<path fill=\"#ff0000\" style=\"fill:#00ffff\" d=\"m 10,10 10,0 v 10 h -10 z\" />"
+            "</g></g>"), 1e-4);
+        require(get<1>(polys).size() == 1, "path missing");
+        const auto poly = get<1>(polys).poly(0);
+        require(polygons::isWater(get<1>(polys).colors[0]), "style does not override fill attribute");
+        require(poly.size() == 4, "path vertex count");
+        require(close_to(poly[0], { .6, .2 }) && close_to(poly[1], { .7, .2 }) && close_to(poly[2], { .7, .4 }), "path transform");
+    }
+
+    { // hidden layers, skipped elements and stroke only shapes
+        const auto polys = polygons::parse_svg(document(
+            "<g style=\"display:none\"><rect x=\"0\" y=\"0\" width=\"10\" height=\"10\"/></g>"
+            "<text x=\"0\" y=\"0\" style=\"fill:#000000\"><tspan>X</tspan></text>"
+            "<polygon points=\"0,0 10,0 10,10\" style=\"fill:none;stroke:#ff8000\"/>"), 1e-4);
+        require(get<1>(polys).empty(), "hidden or text shape extracted");
+        require(get<0>(polys).size() == 1, "stroke polygon missing");
+        require(polygons::isCrate(get<0>(polys).colors[0]), "stroke colour");
+    }
+
+    { // curves are flattened within tolerance, finer tolerance gives more vertices
+        size_t previous_count = 0;
+        for (const float tolerance : { 1e-3f, 1e-4f, 1e-5f })
+        {
+            const auto polys = polygons::parse_svg(document("<circle cx=\"100\" cy=\"50\" r=\"40\"/><path d=\"M 20,90 A 10 10 0 0 1 40,90 Z\"/>"), tolerance);
+            require(get<1>(polys).size() == 2, "curved shapes missing");
+            size_t count = 0;
+            const auto& soup = get<1>(polys);
+            for (size_t kk=0; kk<soup.size(); kk++)
+            {
+                count += soup.count(kk);
+                const bool is_circle = soup.count(kk) > 0 && soup.begin(kk)->x > .5;
+                for (auto point=soup.begin(kk); point!=soup.end(kk); point++)
+                {
+                    // unit square coordinates, x is scaled twice as much as y
+                    const b2Vec2 local { 200 * point->x, 100 * point->y };
+                    // cubic quarter circles stray up to 2.8e-4 radius from the true circle
+                    const float radius = is_circle ? 40 : 10;
+                    const auto distance = (local - (is_circle ? b2Vec2 { 100, 50 } : b2Vec2 { 30, 90 })).Length() - radius;
+                    require(local.y > 90 - 1e-3 || std::fabs(distance) < 200 * tolerance + 3e-4 * radius, "curve point off");
+                }
+            }
+            cout << "tolerance " << tolerance << " vertices " << count << endl;
+            require(count > previous_count, "vertex count does not grow with precision");
+            previous_count = count;
+        }
+    }
+
+    { // numbers in compact notation
+        const auto polys = polygons::parse_svg(document("<path d=\"M0,0L2e1,0-0.5.5z\"/>"), 1e-4);
+        require(get<1>(polys).size() == 1, "compact path missing");
+        const auto poly = get<1>(polys).poly(0);
+        require(poly.size() == 3 && close_to(poly[1], { .1, 0 }) && close_to(poly[2], { -.0025, .005 }), "compact numbers");
+    }
+
+    { // exact duplicates are dropped, the soup keeps document order and the first colour
+        const auto polys = polygons::parse_svg(document(
+            "<rect x=\"0\" y=\"0\" width=\"10\" height=\"10\" fill=\"#000000\"/>"
+            "<rect x=\"20\" y=\"0\" width=\"10\" height=\"10\" fill=\"#00ffff\"/>"
+            "<rect x=\"0\" y=\"0\" width=\"10\" height=\"10\" fill=\"#00ffff\"/>"), 1e-4);
+        const auto& soup = get<1>(polys);
+        require(soup.size() == 2 && soup.vertices.size() == 8, "duplicate kept");
+        require(soup.offsets.size() == 3 && soup.offsets[1] == 4, "soup offsets");
+        require(polygons::isForeground(soup.colors[0]) && polygons::isWater(soup.colors[1]), "soup order");
+    }
+
+    cout << "svg parsing ok" << endl;
+
+    return 0;
+}